@@ -0,0 +1,607 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "EpochReclaimer.hpp"
+#include "Hasher.hpp"
+
+namespace JAVA {
+
+/**
+ * Thread-safe hash map modeled on Java's ConcurrentHashMap.
+ *
+ * Reads take no lock: they follow the bucket heads and chains through
+ * atomic pointers. Writes lock the single bin they change, and an insert
+ * into an empty bin is a plain CAS. Values are never written in place; an
+ * update links a new node in place of the old one, so a reader always sees
+ * a complete entry.
+ *
+ * A resize transfers bins into a table twice as large. Threads that run into
+ * a transferred bin, or notice that the map is over its threshold while a
+ * resize is running, claim ranges of bins and transfer them too. Transferred
+ * bins hold a forwarding marker, which sends readers on to the new table.
+ *
+ * Nodes and tables that are unlinked while other threads may still be
+ * reading them go through epoch-based reclamation (EpochReclaimer). Pinning
+ * only writes a cache line owned by the calling thread, so reads never
+ * write shared memory.
+ *
+ * Hash, KeyEqual and Alloc have the same meaning as for HashMap. Alloc is
+ * used from several threads at once and must allow that.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+class ConcurrentHashMap {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  static_assert(sizeof(std::size_t) == 8);
+
+  static_assert(std::is_same_v<decltype(std::declval<const KeyEqual &>()(
+                                   std::declval<const K &>(),
+                                   std::declval<const K &>())),
+                               bool>,
+                "type K must impl operator== or KeyEqual must compare K");
+
+  static_assert(std::is_convertible_v<decltype(std::declval<const Hash &>()(
+                                          std::declval<const K &>())),
+                                      std::size_t>,
+                "Hash must map K to std::size_t");
+
+  static_assert(std::is_copy_constructible_v<K> &&
+                    std::is_copy_constructible_v<V>,
+                "K and V must be copyable, a resize clones nodes that "
+                "readers may still be walking");
+
+ private:
+  constexpr static std::size_t DEFAULT_INITIAL_CAPACITY = 1 << 4;  // aka 16
+
+  constexpr static std::size_t MAXIMUM_CAPACITY = 1 << 30;
+
+  constexpr static std::size_t HASHCODE_REMOVE_SIZE = 1 << 4;
+
+  /**
+   * Fewest bins a thread claims at once while transferring.
+   */
+  constexpr static std::size_t MIN_TRANSFER_STRIDE = 16;
+
+  /**
+   * Number of striped size counters, a power of two.
+   */
+  constexpr static std::size_t COUNTER_CELLS = 32;
+
+  /**
+   * Bins that have been transferred to the next table hold this value.
+   */
+  constexpr static std::uintptr_t MOVED_TAG = 1;
+
+  constexpr static std::size_t CACHE_LINE_SIZE = 64;
+
+  inline auto hash(const K &key) const noexcept -> std::size_t {
+    std::size_t h = hasher_(key);
+    if constexpr (detail::is_avalanching<Hash>::value) {
+      return h;
+    } else {
+      return h ^ (h >> HASHCODE_REMOVE_SIZE);
+    }
+  }
+
+  /**
+   * Everything but next is immutable once the node is published.
+   */
+  struct Node {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    const std::size_t hash_code;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    const K key;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    const V value;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<Node *> next;
+
+    template <typename KeyArg, typename ValueArg>
+    Node(std::size_t hash_code, KeyArg &&key, ValueArg &&value, Node *next)
+        : hash_code(hash_code),
+          key(std::forward<KeyArg>(key)),
+          value(std::forward<ValueArg>(value)),
+          next(next) {}
+  };
+
+  static inline auto moved() noexcept -> Node * {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+    return reinterpret_cast<Node *>(MOVED_TAG);
+  }
+
+  /**
+   * Spin lock guarding one bin. Bins are only held while their chain is
+   * walked, so spinning beats parking a thread.
+   */
+  class BinLock {
+   public:
+    auto lock() noexcept -> void {
+      while (locked_.exchange(true, std::memory_order_acquire)) {
+        while (locked_.load(std::memory_order_relaxed)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    auto unlock() noexcept -> void {
+      locked_.store(false, std::memory_order_release);
+    }
+
+   private:
+    std::atomic<bool> locked_{false};
+  };
+
+  struct Table {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    const std::size_t capacity;
+
+    // size at which the table is resized, 0.75 * capacity
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    const std::size_t threshold;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<Node *> *bins = nullptr;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    BinLock *locks = nullptr;
+
+    // set once, before the first bin is transferred
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<Table *> next{nullptr};
+
+    // bins below this index are still to be claimed by a transferring thread
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<std::int64_t> transferIndex{0};
+
+    // 0 until a resize starts, then the number of transferring threads, and
+    // -1 once the last of them has left
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<std::int64_t> resizers{0};
+
+    explicit Table(std::size_t capacity) noexcept
+        : capacity(capacity), threshold(capacity - (capacity >> 2)) {}
+  };
+
+  struct alignas(CACHE_LINE_SIZE) CounterCell {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<std::int64_t> value{0};
+  };
+
+  template <typename T>
+  using Rebind =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using NodeAllocator = Rebind<Node>;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+  using TableAllocator = Rebind<Table>;
+  using TableTraits = std::allocator_traits<TableAllocator>;
+  using BinAllocator = Rebind<std::atomic<Node *>>;
+  using BinTraits = std::allocator_traits<BinAllocator>;
+  using LockAllocator = Rebind<BinLock>;
+  using LockTraits = std::allocator_traits<LockAllocator>;
+
+  using Reclaimer = EpochReclaimer<ConcurrentHashMap>;
+
+  using Guard = typename Reclaimer::Guard;
+
+  Hash hasher_;
+
+  KeyEqual keyEqual_;
+
+  NodeAllocator nodeAllocator_;
+
+  TableAllocator tableAllocator_;
+
+  BinAllocator binAllocator_;
+
+  LockAllocator lockAllocator_;
+
+  std::atomic<Table *> table_;
+
+  CounterCell counters_[COUNTER_CELLS];
+
+  // after the allocators, retired memory is freed through them
+  mutable Reclaimer reclaimer_;
+
+  template <typename KeyArg, typename ValueArg>
+  auto newNode(std::size_t hashCode, KeyArg &&key, ValueArg &&value,
+               Node *next) -> Node * {
+    Node *p = NodeTraits::allocate(nodeAllocator_, 1);
+    return new (p) Node(hashCode, std::forward<KeyArg>(key),
+                        std::forward<ValueArg>(value), next);
+  }
+
+  auto deleteNode(Node *p) noexcept -> void {
+    p->~Node();
+    NodeTraits::deallocate(nodeAllocator_, p, 1);
+  }
+
+  auto newTable(std::size_t capacity) -> Table * {
+    Table *p = TableTraits::allocate(tableAllocator_, 1);
+    Table *tab = new (p) Table(capacity);
+    tab->bins = BinTraits::allocate(binAllocator_, capacity);
+    tab->locks = LockTraits::allocate(lockAllocator_, capacity);
+    for (std::size_t i = 0; i < capacity; i++) {
+      new (tab->bins + i) std::atomic<Node *>(nullptr);
+      new (tab->locks + i) BinLock();
+    }
+    return tab;
+  }
+
+  auto deleteTable(Table *tab) noexcept -> void {
+    BinTraits::deallocate(binAllocator_, tab->bins, tab->capacity);
+    LockTraits::deallocate(lockAllocator_, tab->locks, tab->capacity);
+    tab->~Table();
+    TableTraits::deallocate(tableAllocator_, tab, 1);
+  }
+
+  /**
+   * Hands memory that is no longer reachable from the table over to
+   * reclamation. It must already be unlinked when this is called.
+   */
+  auto retire(void *ptr, typename Reclaimer::Free free) -> void {
+    reclaimer_.Retire(ptr, free);
+  }
+
+  static auto freeNode(ConcurrentHashMap *map, void *ptr) noexcept -> void {
+    map->deleteNode(static_cast<Node *>(ptr));
+  }
+
+  static auto freeTable(ConcurrentHashMap *map, void *ptr) noexcept -> void {
+    map->deleteTable(static_cast<Table *>(ptr));
+  }
+
+  static auto cellIndex() noexcept -> std::size_t {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    thread_local std::size_t index =
+        (std::hash<std::thread::id>()(std::this_thread::get_id()) *
+         0x9E3779B97F4A7C15ULL) >>
+        32;
+    return index & (COUNTER_CELLS - 1);
+  }
+
+  auto sumCount() const noexcept -> std::int64_t {
+    std::int64_t sum = 0;
+    for (const CounterCell &cell : counters_) {
+      sum += cell.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /**
+   * Adds delta to the size, and after an insertion checks whether the table
+   * has to grow.
+   */
+  auto addCount(std::int64_t delta) -> void {
+    counters_[cellIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+    if (delta <= 0) {
+      return;
+    }
+
+    Table *tab = table_.load(std::memory_order_acquire);
+    if (sumCount() < static_cast<std::int64_t>(tab->threshold)) {
+      return;
+    }
+    if (tab->resizers.load() == 0) {
+      startResize(tab);
+    } else if (tab->next.load(std::memory_order_acquire) != nullptr) {
+      helpTransfer(tab);
+    }
+  }
+
+  auto startResize(Table *tab) -> void {
+    std::int64_t idle = 0;
+    if (tab->capacity >= MAXIMUM_CAPACITY ||
+        !tab->resizers.compare_exchange_strong(idle, 1)) {
+      return;
+    }
+    Table *nextTab = newTable(tab->capacity << 1);
+    tab->transferIndex.store(static_cast<std::int64_t>(tab->capacity));
+    tab->next.store(nextTab, std::memory_order_release);
+    transfer(tab, nextTab);
+  }
+
+  /**
+   * Joins the running resize of tab if there are bins left to claim, and
+   * returns the table that follows tab.
+   */
+  auto helpTransfer(Table *tab) -> Table * {
+    Table *nextTab = tab->next.load(std::memory_order_acquire);
+    std::int64_t r = tab->resizers.load();
+    while (r > 0 && tab->transferIndex.load() > 0) {
+      if (tab->resizers.compare_exchange_weak(r, r + 1)) {
+        transfer(tab, nextTab);
+        break;
+      }
+    }
+    return nextTab;
+  }
+
+  /**
+   * Claims ranges of bins from the top of tab until none are left, then
+   * leaves the resize. The last thread to leave publishes nextTab.
+   */
+  auto transfer(Table *tab, Table *nextTab) -> void {
+    std::size_t n = tab->capacity;
+    std::size_t cpus = std::max(1U, std::thread::hardware_concurrency());
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto stride = static_cast<std::int64_t>(
+        std::max(n / 8 / cpus, MIN_TRANSFER_STRIDE));
+
+    for (std::int64_t end = tab->transferIndex.load(); end > 0;) {
+      std::int64_t start = std::max<std::int64_t>(end - stride, 0);
+      if (!tab->transferIndex.compare_exchange_weak(end, start)) {
+        continue;
+      }
+      for (auto i = static_cast<std::size_t>(start);
+           i < static_cast<std::size_t>(end); i++) {
+        transferBin(tab, nextTab, i);
+      }
+      end = tab->transferIndex.load();
+    }
+
+    std::int64_t r = tab->resizers.load();
+    while (!tab->resizers.compare_exchange_weak(r, r == 1 ? -1 : r - 1)) {
+    }
+    if (r == 1) {
+      // every claimed range is done once its claimer has left
+      table_.store(nextTab, std::memory_order_release);
+      retire(tab, &freeTable);
+    }
+  }
+
+  /**
+   * Moves bin i of tab into bins i and i + n of nextTab. Readers may still be
+   * walking the old chain, so it is left intact: the trailing run of nodes
+   * that all go to the same side is shared, and the nodes before it are
+   * cloned and retired.
+   */
+  auto transferBin(Table *tab, Table *nextTab, std::size_t i) -> void {
+    std::size_t n = tab->capacity;
+    std::atomic<Node *> &bin = tab->bins[i];
+
+    std::lock_guard<BinLock> lock(tab->locks[i]);
+    Node *f = bin.load(std::memory_order_acquire);
+    // an empty bin can still be filled by a lock-free insert
+    while (f == nullptr) {
+      if (bin.compare_exchange_weak(f, moved())) {
+        return;
+      }
+    }
+
+    Node *lastRun = f;
+    std::size_t runBit = f->hash_code & n;
+    for (Node *p = f->next.load(std::memory_order_relaxed); p != nullptr;
+         p = p->next.load(std::memory_order_relaxed)) {
+      if ((p->hash_code & n) != runBit) {
+        runBit = p->hash_code & n;
+        lastRun = p;
+      }
+    }
+
+    Node *lo = runBit == 0 ? lastRun : nullptr;
+    Node *hi = runBit == 0 ? nullptr : lastRun;
+    for (Node *p = f; p != lastRun;
+         p = p->next.load(std::memory_order_relaxed)) {
+      if ((p->hash_code & n) == 0) {
+        lo = newNode(p->hash_code, p->key, p->value, lo);
+      } else {
+        hi = newNode(p->hash_code, p->key, p->value, hi);
+      }
+    }
+
+    nextTab->bins[i].store(lo, std::memory_order_release);
+    nextTab->bins[i + n].store(hi, std::memory_order_release);
+    bin.store(moved(), std::memory_order_release);
+
+    for (Node *p = f; p != lastRun;
+         p = p->next.load(std::memory_order_relaxed)) {
+      retire(p, &freeNode);
+    }
+  }
+
+  auto findNode(std::size_t hashCode, const K &key) const noexcept -> Node * {
+    Table *tab = table_.load(std::memory_order_acquire);
+    for (;;) {
+      Node *e = tab->bins[hashCode & (tab->capacity - 1)].load(
+          std::memory_order_acquire);
+      if (e == moved()) {
+        tab = tab->next.load(std::memory_order_acquire);
+        continue;
+      }
+      for (; e != nullptr; e = e->next.load(std::memory_order_acquire)) {
+        if (e->hash_code == hashCode && keyEqual_(e->key, key)) {
+          return e;
+        }
+      }
+      return nullptr;
+    }
+  }
+
+ public:
+  ConcurrentHashMap() : ConcurrentHashMap(Hash()){};
+
+  explicit ConcurrentHashMap(const Alloc &alloc)
+      : ConcurrentHashMap(Hash(), KeyEqual(), alloc){};
+
+  explicit ConcurrentHashMap(const Hash &hasher,
+                             const KeyEqual &keyEqual = KeyEqual(),
+                             const Alloc &alloc = Alloc())
+      : hasher_(hasher),
+        keyEqual_(keyEqual),
+        nodeAllocator_(alloc),
+        tableAllocator_(alloc),
+        binAllocator_(alloc),
+        lockAllocator_(alloc),
+        table_(newTable(DEFAULT_INITIAL_CAPACITY)),
+        reclaimer_(this){};
+
+  ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+
+  auto operator=(const ConcurrentHashMap &) -> ConcurrentHashMap & = delete;
+
+  template <typename KeyType, typename ValueType>
+  auto Put(KeyType &&key, ValueType &&value) -> void {
+    // type check
+    using DecayedKeyType = std::decay_t<KeyType>;
+    using DecayedValueType = std::decay_t<ValueType>;
+    static_assert(std::is_same_v<DecayedKeyType, K>,
+                  "KeyType must be the same as K");
+    static_assert(std::is_same_v<DecayedValueType, V>,
+                  "ValueType must be the same as V");
+
+    Guard guard(&reclaimer_);
+    std::size_t hashCode = hash(key);
+    // the node is built up front, an update replaces the old node with it
+    Node *node = newNode(hashCode, std::forward<KeyType>(key),
+                         std::forward<ValueType>(value), nullptr);
+
+    Table *tab = table_.load(std::memory_order_acquire);
+    for (;;) {
+      std::size_t i = hashCode & (tab->capacity - 1);
+      Node *f = tab->bins[i].load(std::memory_order_acquire);
+      if (f == nullptr) {
+        if (tab->bins[i].compare_exchange_strong(f, node)) {
+          addCount(1);
+          return;
+        }
+        continue;
+      }
+      if (f == moved()) {
+        tab = helpTransfer(tab);
+        continue;
+      }
+
+      Node *replaced = nullptr;
+      {
+        std::lock_guard<BinLock> lock(tab->locks[i]);
+        f = tab->bins[i].load(std::memory_order_acquire);
+        if (f == nullptr || f == moved()) {
+          continue;
+        }
+
+        std::atomic<Node *> *link = &tab->bins[i];
+        for (Node *e = f; e != nullptr;
+             e = e->next.load(std::memory_order_relaxed)) {
+          if (e->hash_code == hashCode && keyEqual_(e->key, node->key)) {
+            node->next.store(e->next.load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+            replaced = e;
+            break;
+          }
+          link = &e->next;
+        }
+        link->store(node, std::memory_order_release);
+        if (replaced != nullptr) {
+          retire(replaced, &freeNode);
+        }
+      }
+
+      if (replaced == nullptr) {
+        addCount(1);
+      }
+      return;
+    }
+  }
+
+  auto Get(const K &key) const -> std::optional<V> {
+    Guard guard(&reclaimer_);
+    Node *node = findNode(hash(key), key);
+    return node == nullptr ? std::nullopt : std::make_optional(node->value);
+  }
+
+  auto Contain(const K &key) const -> bool {
+    Guard guard(&reclaimer_);
+    return findNode(hash(key), key) != nullptr;
+  }
+
+  auto Del(const K &key) -> bool {
+    Guard guard(&reclaimer_);
+    std::size_t hashCode = hash(key);
+
+    Table *tab = table_.load(std::memory_order_acquire);
+    for (;;) {
+      std::size_t i = hashCode & (tab->capacity - 1);
+      Node *f = tab->bins[i].load(std::memory_order_acquire);
+      if (f == nullptr) {
+        return false;
+      }
+      if (f == moved()) {
+        tab = helpTransfer(tab);
+        continue;
+      }
+
+      std::lock_guard<BinLock> lock(tab->locks[i]);
+      f = tab->bins[i].load(std::memory_order_acquire);
+      if (f == nullptr) {
+        return false;
+      }
+      if (f == moved()) {
+        continue;
+      }
+
+      std::atomic<Node *> *link = &tab->bins[i];
+      for (Node *e = f; e != nullptr;
+           e = e->next.load(std::memory_order_relaxed)) {
+        if (e->hash_code == hashCode && keyEqual_(e->key, key)) {
+          link->store(e->next.load(std::memory_order_relaxed),
+                      std::memory_order_release);
+          retire(e, &freeNode);
+          addCount(-1);
+          return true;
+        }
+        link = &e->next;
+      }
+      return false;
+    }
+  }
+
+  /**
+   * Number of entries. Exact when no other thread is writing, otherwise a
+   * value the size had at some point during the call.
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t {
+    std::int64_t sum = sumCount();
+    return sum < 0 ? 0 : static_cast<std::size_t>(sum);
+  }
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return size() == 0; }
+
+  /**
+   * Number of bins of the current table.
+   */
+  [[nodiscard]] auto bucketCount() const noexcept -> std::size_t {
+    return table_.load(std::memory_order_acquire)->capacity;
+  }
+
+  ~ConcurrentHashMap() {
+    Table *tab = table_.load();
+    for (std::size_t i = 0; i < tab->capacity; i++) {
+      Node *e = tab->bins[i].load();
+      while (e != nullptr) {
+        Node *next = e->next.load();
+        deleteNode(e);
+        e = next;
+      }
+    }
+    deleteTable(tab);
+  }
+};
+
+}  // namespace JAVA
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace JAVA {
+
+/**
+ * Epoch-based reclamation for the lock-free readers of ConcurrentHashMap.
+ *
+ * Every thread that touches the owner gets a record of its own, padded to a
+ * cache line. Pinning publishes the global epoch in that record and nothing
+ * else, so readers never write memory shared with other threads. Memory
+ * unlinked while the global epoch is e goes to the retiring thread's limbo
+ * list and is freed once the epoch has reached e + 2: by then every thread
+ * that was pinned while the memory was reachable has unpinned.
+ *
+ * The epoch only moves forward when every pinned thread has seen the
+ * current one, so a thread that stays pinned holds back reclamation but never
+ * blocks anybody. When a thread exits, its limbo list goes to an orphan list
+ * that later collections free, and its record is left for the next thread
+ * to take over. Records themselves are kept until the reclaimer is
+ * destroyed.
+ */
+template <typename Owner>
+class EpochReclaimer {
+ public:
+  using Free = void (*)(Owner *, void *) noexcept;
+
+ private:
+  constexpr static std::size_t CACHE_LINE_SIZE = 64;
+
+  /**
+   * Limbo list length at which a thread tries to advance the epoch.
+   */
+  constexpr static std::size_t RECLAIM_BATCH = 256;
+
+  // a record with this epoch is not pinned
+  constexpr static std::uint64_t QUIESCENT = 0;
+
+  struct Retired {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    void *ptr;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    Free free;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::uint64_t epoch;
+  };
+
+  struct alignas(CACHE_LINE_SIZE) Record {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<std::uint64_t> epoch{QUIESCENT};
+
+    // whether a thread owns the record, a free one is taken over by the next
+    // thread without one
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<bool> active{true};
+
+    // nesting depth of guards on the owning thread
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::size_t depth = 0;
+
+    // only touched by the owning thread
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::vector<Retired> limbo;
+
+    // limbo.size(), for other threads to read
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::atomic<std::size_t> pending{0};
+
+    // limbo length that triggers the next collection, it grows with what a
+    // collection could not free so a stalled epoch does not make every
+    // Retire rescan the list
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::size_t collectAt = RECLAIM_BATCH;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    Record *next = nullptr;
+  };
+
+  /**
+   * Ids of the reclaimers alive, so that a thread exiting after one of its
+   * reclaimers is gone leaves that one alone. Never destroyed, as threads
+   * may exit after static destruction has begun.
+   */
+  struct Registry {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::mutex mutex;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::unordered_set<std::uint64_t> live;
+  };
+
+  struct Slot {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::uint64_t id;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    EpochReclaimer *reclaimer;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    Record *record;
+  };
+
+  /**
+   * The records of one thread, one per reclaimer it has used. Hands them
+   * back when the thread exits.
+   */
+  struct ThreadRecords {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::vector<Slot> slots;
+
+    ThreadRecords() = default;
+
+    ThreadRecords(const ThreadRecords &) = delete;
+
+    auto operator=(const ThreadRecords &) -> ThreadRecords & = delete;
+
+    ~ThreadRecords() {
+      Registry &reg = registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      for (const Slot &slot : slots) {
+        if (reg.live.count(slot.id) != 0) {
+          slot.reclaimer->orphan(slot.record);
+        }
+      }
+    }
+  };
+
+  Owner *owner_;
+
+  // identifies this reclaimer in the per-thread record cache, addresses
+  // could be reused by a later reclaimer
+  std::uint64_t id_;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> epoch_{1};
+
+  alignas(CACHE_LINE_SIZE) std::atomic<Record *> records_{nullptr};
+
+  // limbo lists of threads that exited
+  std::mutex orphansMutex_;
+
+  std::vector<Retired> orphans_;
+
+  std::atomic<std::size_t> orphanCount_{0};
+
+  static auto registry() -> Registry & {
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    static auto *reg = new Registry();
+    return *reg;
+  }
+
+  static auto threadRecords() -> ThreadRecords & {
+    thread_local ThreadRecords records;
+    return records;
+  }
+
+  static auto nextId() noexcept -> std::uint64_t {
+    static std::atomic<std::uint64_t> ids{0};
+    return ids.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  /**
+   * Returns the record of the calling thread, taking one over or creating it
+   * on first use.
+   */
+  auto record() -> Record * {
+    std::vector<Slot> &slots = threadRecords().slots;
+    for (const Slot &slot : slots) {
+      if (slot.id == id_) {
+        return slot.record;
+      }
+    }
+
+    Record *found = nullptr;
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      bool active = false;
+      if (!r->active.load(std::memory_order_relaxed) &&
+          r->active.compare_exchange_strong(active, true,
+                                            std::memory_order_acquire)) {
+        found = r;
+        break;
+      }
+    }
+
+    if (found == nullptr) {
+      found = new Record();
+      Record *head = records_.load(std::memory_order_relaxed);
+      do {
+        found->next = head;
+      } while (!records_.compare_exchange_weak(head, found,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+    }
+
+    {
+      // drop the slots of reclaimers destroyed since, ids are never reused
+      Registry &reg = registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      slots.erase(std::remove_if(slots.begin(), slots.end(),
+                                 [&reg](const Slot &slot) {
+                                   return reg.live.count(slot.id) == 0;
+                                 }),
+                  slots.end());
+    }
+    slots.push_back(Slot{id_, this, found});
+    return found;
+  }
+
+  /**
+   * Takes over the limbo list of rec, whose thread is exiting, and frees rec
+   * for another thread.
+   */
+  auto orphan(Record *rec) -> void {
+    if (!rec->limbo.empty()) {
+      std::lock_guard<std::mutex> lock(orphansMutex_);
+      orphans_.insert(orphans_.end(), rec->limbo.begin(), rec->limbo.end());
+      orphanCount_.store(orphans_.size(), std::memory_order_relaxed);
+    }
+    std::vector<Retired>().swap(rec->limbo);
+    rec->pending.store(0, std::memory_order_relaxed);
+    rec->collectAt = RECLAIM_BATCH;
+    rec->depth = 0;
+    rec->epoch.store(QUIESCENT, std::memory_order_release);
+    rec->active.store(false, std::memory_order_release);
+  }
+
+  /**
+   * Frees the retired allocations of list that no thread can reach any more
+   * and returns how many are left.
+   */
+  auto freeUnreachable(std::vector<Retired> &list,
+                       std::uint64_t epoch) noexcept -> std::size_t {
+    std::size_t kept = 0;
+    for (Retired &r : list) {
+      if (r.epoch + 2 <= epoch) {
+        r.free(owner_, r.ptr);
+      } else {
+        list[kept++] = r;
+      }
+    }
+    list.resize(kept);
+    return kept;
+  }
+
+  /**
+   * Moves the epoch forward if every pinned thread has caught up with it.
+   */
+  auto tryAdvance() noexcept -> std::uint64_t {
+    std::uint64_t epoch = epoch_.load();
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      std::uint64_t e = r->epoch.load();
+      if (e != QUIESCENT && e != epoch) {
+        return epoch;
+      }
+    }
+    epoch_.compare_exchange_strong(epoch, epoch + 1);
+    return epoch_.load();
+  }
+
+  auto collect(Record *rec) noexcept -> void {
+    std::uint64_t epoch = tryAdvance();
+    std::size_t kept = freeUnreachable(rec->limbo, epoch);
+    rec->pending.store(kept, std::memory_order_relaxed);
+    rec->collectAt = std::max(RECLAIM_BATCH, kept * 2);
+
+    // whoever gets the lock frees the orphans, the others do not wait
+    if (orphanCount_.load(std::memory_order_relaxed) != 0 &&
+        orphansMutex_.try_lock()) {
+      std::lock_guard<std::mutex> lock(orphansMutex_, std::adopt_lock);
+      orphanCount_.store(freeUnreachable(orphans_, epoch),
+                         std::memory_order_relaxed);
+    }
+  }
+
+ public:
+  /**
+   * Keeps everything reachable when it was created alive for its lifetime.
+   * Guards may nest on one thread.
+   */
+  class Guard {
+   public:
+    explicit Guard(EpochReclaimer *reclaimer) : record_(reclaimer->record()) {
+      if (record_->depth++ != 0) {
+        return;
+      }
+      std::uint64_t epoch = reclaimer->epoch_.load();
+      for (;;) {
+        record_->epoch.store(epoch);
+        // also orders the loads of the critical section after the store
+        std::uint64_t current = reclaimer->epoch_.load();
+        if (current == epoch) {
+          return;
+        }
+        epoch = current;
+      }
+    }
+
+    Guard(const Guard &) = delete;
+
+    auto operator=(const Guard &) -> Guard & = delete;
+
+    ~Guard() {
+      if (--record_->depth == 0) {
+        record_->epoch.store(QUIESCENT, std::memory_order_release);
+      }
+    }
+
+   private:
+    Record *record_;
+  };
+
+  explicit EpochReclaimer(Owner *owner) : owner_(owner), id_(nextId()) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.live.insert(id_);
+  }
+
+  EpochReclaimer(const EpochReclaimer &) = delete;
+
+  auto operator=(const EpochReclaimer &) -> EpochReclaimer & = delete;
+
+  /**
+   * Frees ptr with free once no thread can still reach it. ptr must already
+   * be unlinked from everything a reader could start from.
+   */
+  auto Retire(void *ptr, Free free) -> void {
+    Record *rec = record();
+    // the unlink has to be visible before the epoch is read, or a reader
+    // pinned in the next epoch could still find ptr after it is freed. A
+    // read-modify-write orders it where a plain load would not
+    rec->limbo.push_back(Retired{ptr, free, epoch_.fetch_add(0)});
+    rec->pending.store(rec->limbo.size(), std::memory_order_relaxed);
+    if (rec->limbo.size() >= rec->collectAt) {
+      collect(rec);
+    }
+  }
+
+  /**
+   * Number of retired allocations not freed yet. Only exact while no other
+   * thread uses the owner.
+   */
+  [[nodiscard]] auto Pending() const noexcept -> std::size_t {
+    std::size_t pending = orphanCount_.load(std::memory_order_relaxed);
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      pending += r->pending.load(std::memory_order_relaxed);
+    }
+    return pending;
+  }
+
+  /**
+   * No thread may be using the owner any more.
+   */
+  ~EpochReclaimer() {
+    {
+      // threads exiting from here on leave their records alone
+      Registry &reg = registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      reg.live.erase(id_);
+    }
+    for (const Retired &retired : orphans_) {
+      retired.free(owner_, retired.ptr);
+    }
+    Record *r = records_.load();
+    while (r != nullptr) {
+      for (const Retired &retired : r->limbo) {
+        retired.free(owner_, retired.ptr);
+      }
+      Record *next = r->next;
+      delete r;
+      r = next;
+    }
+  }
+};
+
+}  // namespace JAVA
@@ -0,0 +1,606 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Hasher.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace JAVA {
+
+/**
+ * Open-addressing hash map in the style of SwissTable. Keys and values live
+ * in one flat slot array, and a separate array of 1-byte control words holds
+ * 7 bits of every full slot's hash code, so a probe scans a whole group of
+ * control bytes at once and only touches slots whose fragment matches.
+ *
+ * Hash, KeyEqual and Alloc have the same meaning as for HashMap.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+class FlatHashMap {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  static_assert(sizeof(std::size_t) == 8);
+
+  static_assert(std::is_same_v<decltype(std::declval<const KeyEqual &>()(
+                                   std::declval<const K &>(),
+                                   std::declval<const K &>())),
+                               bool>,
+                "type K must impl operator== or KeyEqual must compare K");
+
+  static_assert(std::is_convertible_v<decltype(std::declval<const Hash &>()(
+                                          std::declval<const K &>())),
+                                      std::size_t>,
+                "Hash must map K to std::size_t");
+
+ private:
+  using ctrl_t = std::int8_t;
+
+  /**
+   * Control bytes: a full slot stores H2 (0..127), the special states have
+   * their sign bit set so both can be found with a single compare.
+   */
+  constexpr static ctrl_t EMPTY = -128;  // 0b10000000
+
+  constexpr static ctrl_t DELETED = -2;  // 0b11111110
+
+  constexpr static ctrl_t SENTINEL = -1;  // 0b11111111
+
+  /**
+   * The number of control bytes scanned by one probe.
+   */
+  constexpr static std::size_t GROUP_WIDTH = 16;
+
+  /**
+   * The default initial capacity - MUST be a power of two >= GROUP_WIDTH.
+   */
+  constexpr static std::size_t DEFAULT_INITIAL_CAPACITY = 1 << 4;  // aka 16
+
+  /**
+   * Multiplier used to spread the hash code over all 64 bits, H1 and H2 are
+   * taken from different ends of the word so they must both be well mixed.
+   */
+  constexpr static std::size_t HASHCODE_MIX = 0x9E3779B97F4A7C15ULL;
+
+  constexpr static std::size_t H2_BITS = 7;
+
+  template <typename Q>
+  struct is_key_like
+      : std::bool_constant<detail::is_transparent<Hash>::value &&
+                           detail::is_transparent<KeyEqual>::value &&
+                           !std::is_same_v<std::decay_t<Q>, K>> {};
+
+  template <typename Q>
+  inline auto hash(const Q &key) const noexcept -> std::size_t {
+    if constexpr (detail::is_avalanching<Hash>::value) {
+      return hasher_(key);
+    } else {
+      std::size_t h = hasher_(key) * HASHCODE_MIX;
+      return h ^ (h >> 32);
+    }
+  }
+
+  static inline auto H1(std::size_t hashCode) noexcept -> std::size_t {
+    return hashCode >> H2_BITS;
+  }
+
+  static inline auto H2(std::size_t hashCode) noexcept -> ctrl_t {
+    return static_cast<ctrl_t>(hashCode & ((1 << H2_BITS) - 1));
+  }
+
+  static inline auto trailingZeros(std::uint32_t mask) noexcept -> std::size_t {
+    return static_cast<std::size_t>(__builtin_ctz(mask));
+  }
+
+  static inline auto leadingZeros(std::uint32_t mask) noexcept -> std::size_t {
+    // masks are GROUP_WIDTH bits wide
+    return static_cast<std::size_t>(__builtin_clz(mask)) - (32 - GROUP_WIDTH);
+  }
+
+  template <typename T>
+  struct is_streamable {
+    template <typename U>
+    static auto test(int)
+        -> decltype(std::declval<std::ostream &>() << std::declval<U>(),
+                    std::true_type{});
+
+    template <typename>
+    static auto test(...) -> std::false_type;
+
+    static constexpr bool value = decltype(test<T>(0))::value;
+  };
+
+  /**
+   * A window of GROUP_WIDTH control bytes, every Match returns a bit mask
+   * where bit i is set when the i-th byte of the window satisfies it.
+   */
+  struct Group {
+#if defined(__SSE2__)
+    __m128i ctrl;
+
+    explicit Group(const ctrl_t *pos) noexcept
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+    [[nodiscard]] auto Match(ctrl_t h2) const noexcept -> std::uint32_t {
+      return static_cast<std::uint32_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+    }
+
+    [[nodiscard]] auto MatchEmptyOrDeleted() const noexcept -> std::uint32_t {
+      return static_cast<std::uint32_t>(
+          _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(SENTINEL), ctrl)));
+    }
+#else
+    const ctrl_t *ctrl;
+
+    explicit Group(const ctrl_t *pos) noexcept : ctrl(pos) {}
+
+    [[nodiscard]] auto Match(ctrl_t h2) const noexcept -> std::uint32_t {
+      std::uint32_t mask = 0;
+      for (std::size_t i = 0; i < GROUP_WIDTH; i++) {
+        mask |= static_cast<std::uint32_t>(ctrl[i] == h2) << i;
+      }
+      return mask;
+    }
+
+    [[nodiscard]] auto MatchEmptyOrDeleted() const noexcept -> std::uint32_t {
+      std::uint32_t mask = 0;
+      for (std::size_t i = 0; i < GROUP_WIDTH; i++) {
+        mask |= static_cast<std::uint32_t>(ctrl[i] < SENTINEL) << i;
+      }
+      return mask;
+    }
+#endif
+
+    [[nodiscard]] auto MatchEmpty() const noexcept -> std::uint32_t {
+      return Match(EMPTY);
+    }
+  };
+
+  struct Slot {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    K key;
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    V value;
+
+    template <typename KeyArg, typename... ValueArgs>
+    explicit Slot(KeyArg &&keyArg, ValueArgs &&...valueArgs)
+        : key(std::forward<KeyArg>(keyArg)),
+          value(std::forward<ValueArgs>(valueArgs)...) {}
+  };
+
+  template <typename T>
+  using Rebind =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using SlotAllocator = Rebind<Slot>;
+
+  using SlotTraits = std::allocator_traits<SlotAllocator>;
+
+  Hash hasher_;
+
+  KeyEqual keyEqual_;
+
+  SlotAllocator slotAllocator_;
+
+  // capacity_ + GROUP_WIDTH bytes, the tail mirrors the first GROUP_WIDTH
+  // bytes so a group can be loaded at any position without wrapping
+  std::vector<ctrl_t, Rebind<ctrl_t>> ctrl_;
+
+  Slot *slots_ = nullptr;
+
+  std::size_t capacity_;
+
+  std::size_t size_ = 0;
+
+  // the number of EMPTY slots that may still be filled before a rehash
+  std::size_t growth_left_;
+
+  static inline auto capacityToGrowth(std::size_t capacity) noexcept
+      -> std::size_t {
+    // max load factor is 7/8
+    return capacity - capacity / 8;
+  }
+
+  auto setCtrl(std::size_t i, ctrl_t h) noexcept -> void {
+    ctrl_[i] = h;
+    if (i < GROUP_WIDTH) {
+      ctrl_[capacity_ + i] = h;
+    }
+  }
+
+  auto initialize(std::size_t capacity) noexcept -> void {
+    capacity_ = capacity;
+    ctrl_.assign(capacity + GROUP_WIDTH, EMPTY);
+    slots_ = SlotTraits::allocate(slotAllocator_, capacity);
+    growth_left_ = capacityToGrowth(capacity);
+  }
+
+  /**
+   * Returns the index of the slot holding key, or capacity_ if absent.
+   * Groups are visited in triangular order, which covers every group of a
+   * power-of-two table.
+   */
+  template <typename Q>
+  auto findIndex(std::size_t hashCode, const Q &key) const noexcept
+      -> std::size_t {
+    std::size_t mask = capacity_ - 1;
+    std::size_t pos = H1(hashCode) & mask;
+    ctrl_t h2 = H2(hashCode);
+    for (std::size_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+      Group g(ctrl_.data() + pos);
+      for (std::uint32_t m = g.Match(h2); m != 0; m &= m - 1) {
+        std::size_t i = (pos + trailingZeros(m)) & mask;
+        if (keyEqual_(slots_[i].key, key)) {
+          return i;
+        }
+      }
+      if (g.MatchEmpty() != 0) {
+        return capacity_;
+      }
+      pos = (pos + step) & mask;
+    }
+  }
+
+  auto eraseAt(std::size_t index) noexcept -> void {
+    slots_[index].~Slot();
+    size_--;
+
+    // If no probe window containing index was ever full, a lookup can never
+    // have walked past this slot, so it may go straight back to EMPTY.
+    std::size_t mask = capacity_ - 1;
+    std::uint32_t emptyBefore =
+        Group(ctrl_.data() + ((index - GROUP_WIDTH) & mask)).MatchEmpty();
+    std::uint32_t emptyAfter = Group(ctrl_.data() + index).MatchEmpty();
+    bool wasNeverFull =
+        emptyBefore != 0 && emptyAfter != 0 &&
+        trailingZeros(emptyAfter) + leadingZeros(emptyBefore) < GROUP_WIDTH;
+
+    setCtrl(index, wasNeverFull ? EMPTY : DELETED);
+    growth_left_ += wasNeverFull;
+  }
+
+  template <typename Q>
+  auto eraseKey(const Q &key) noexcept -> bool {
+    std::size_t index = findIndex(hash(key), key);
+    if (index == capacity_) {
+      return false;
+    }
+    eraseAt(index);
+    return true;
+  }
+
+  /**
+   * Returns the first EMPTY or DELETED slot on the probe sequence of hashCode.
+   */
+  auto findFirstNonFull(std::size_t hashCode) const noexcept -> std::size_t {
+    std::size_t mask = capacity_ - 1;
+    std::size_t pos = H1(hashCode) & mask;
+    for (std::size_t step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+      std::uint32_t m = Group(ctrl_.data() + pos).MatchEmptyOrDeleted();
+      if (m != 0) {
+        return (pos + trailingZeros(m)) & mask;
+      }
+      pos = (pos + step) & mask;
+    }
+  }
+
+  auto resize(std::size_t newCap) noexcept -> void {
+    auto oldCtrl = std::move(ctrl_);
+    Slot *oldSlots = slots_;
+    std::size_t oldCap = capacity_;
+
+    initialize(newCap);
+
+    // move data
+    for (std::size_t i = 0; i < oldCap; i++) {
+      if (oldCtrl[i] >= 0) {
+        std::size_t hashCode = hash(oldSlots[i].key);
+        std::size_t target = findFirstNonFull(hashCode);
+        setCtrl(target, H2(hashCode));
+        new (slots_ + target) Slot{std::move(oldSlots[i].key),
+                                   std::move(oldSlots[i].value)};
+        oldSlots[i].~Slot();
+      }
+    }
+    growth_left_ -= size_;
+
+    SlotTraits::deallocate(slotAllocator_, oldSlots, oldCap);
+  }
+
+  /**
+   * Builds a slot for a key known to be absent and returns its index.
+   */
+  template <typename KeyArg, typename... ValueArgs>
+  auto insertSlot(std::size_t hashCode, KeyArg &&keyArg,
+                  ValueArgs &&...valueArgs) noexcept -> std::size_t {
+    std::size_t index = findFirstNonFull(hashCode);
+    if (growth_left_ == 0 && ctrl_[index] == EMPTY) {
+      rehashAndGrowIfNecessary();
+      index = findFirstNonFull(hashCode);
+    }
+
+    growth_left_ -= ctrl_[index] == EMPTY;
+    setCtrl(index, H2(hashCode));
+    new (slots_ + index) Slot(std::forward<KeyArg>(keyArg),
+                              std::forward<ValueArgs>(valueArgs)...);
+    size_++;
+    return index;
+  }
+
+  /**
+   * Called when an insertion would fill the last EMPTY slot allowed by the
+   * load factor. If most of the used slots are tombstones the table is
+   * rebuilt at the same size, otherwise it doubles.
+   */
+  auto rehashAndGrowIfNecessary() noexcept -> void {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (capacity_ > GROUP_WIDTH && size_ * 32 <= capacity_ * 25) {
+      resize(capacity_);
+    } else {
+      resize(capacity_ << 1);
+    }
+  }
+
+ public:
+  FlatHashMap() noexcept : FlatHashMap(Hash()) {}
+
+  explicit FlatHashMap(const Alloc &alloc) noexcept
+      : FlatHashMap(Hash(), KeyEqual(), alloc) {}
+
+  explicit FlatHashMap(const Hash &hasher,
+                       const KeyEqual &keyEqual = KeyEqual(),
+                       const Alloc &alloc = Alloc()) noexcept
+      : hasher_(hasher),
+        keyEqual_(keyEqual),
+        slotAllocator_(alloc),
+        ctrl_(alloc) {
+    initialize(DEFAULT_INITIAL_CAPACITY);
+  }
+
+  FlatHashMap(const FlatHashMap &) = delete;
+
+  auto operator=(const FlatHashMap &) -> FlatHashMap & = delete;
+
+  template <typename KeyType, typename ValueType>
+  auto Put(KeyType &&key, ValueType &&value) noexcept -> void {
+    // type check
+    using DecayedKeyType = std::decay_t<KeyType>;
+    using DecayedValueType = std::decay_t<ValueType>;
+    static_assert(std::is_same_v<DecayedKeyType, K>,
+                  "KeyType must be the same as K");
+    static_assert(std::is_same_v<DecayedValueType, V>,
+                  "ValueType must be the same as V");
+
+    InsertOrAssign(std::forward<KeyType>(key), std::forward<ValueType>(value));
+  }
+
+  /**
+   * Same as HashMap::Emplace.
+   */
+  template <typename KeyArg, typename... ValueArgs>
+  auto Emplace(KeyArg &&keyArg, ValueArgs &&...valueArgs) noexcept -> bool {
+    if constexpr (std::is_same_v<std::decay_t<KeyArg>, K>) {
+      return TryEmplace(std::forward<KeyArg>(keyArg),
+                        std::forward<ValueArgs>(valueArgs)...);
+    } else {
+      return TryEmplace(K(std::forward<KeyArg>(keyArg)),
+                        std::forward<ValueArgs>(valueArgs)...);
+    }
+  }
+
+  template <typename KeyType, typename... ValueArgs,
+            std::enable_if_t<std::is_same_v<std::decay_t<KeyType>, K>, int> = 0>
+  auto TryEmplace(KeyType &&key, ValueArgs &&...valueArgs) noexcept -> bool {
+    std::size_t hashCode = hash(key);
+    if (findIndex(hashCode, key) != capacity_) {
+      return false;
+    }
+    insertSlot(hashCode, std::forward<KeyType>(key),
+               std::forward<ValueArgs>(valueArgs)...);
+    return true;
+  }
+
+  template <typename KeyType, typename ValueType,
+            std::enable_if_t<std::is_same_v<std::decay_t<KeyType>, K>, int> = 0>
+  auto InsertOrAssign(KeyType &&key, ValueType &&value) noexcept -> bool {
+    std::size_t hashCode = hash(key);
+    std::size_t index = findIndex(hashCode, key);
+    if (index != capacity_) {
+      slots_[index].value = std::forward<ValueType>(value);
+      return false;
+    }
+    insertSlot(hashCode, std::forward<KeyType>(key),
+               std::forward<ValueType>(value));
+    return true;
+  }
+
+  auto Get(const K &key) const noexcept -> std::optional<V> {
+    std::size_t index = findIndex(hash(key), key);
+    return index == capacity_ ? std::nullopt
+                              : std::make_optional(slots_[index].value);
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Get(const Q &key) const noexcept -> std::optional<V> {
+    std::size_t index = findIndex(hash(key), key);
+    return index == capacity_ ? std::nullopt
+                              : std::make_optional(slots_[index].value);
+  }
+
+  /**
+   * Same as HashMap::Find. The pointer stays valid until the next insertion
+   * or removal.
+   */
+  auto Find(const K &key) noexcept -> V * {
+    std::size_t index = findIndex(hash(key), key);
+    return index == capacity_ ? nullptr : &slots_[index].value;
+  }
+
+  auto Find(const K &key) const noexcept -> const V * {
+    std::size_t index = findIndex(hash(key), key);
+    return index == capacity_ ? nullptr : &slots_[index].value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Find(const Q &key) noexcept -> V * {
+    std::size_t index = findIndex(hash(key), key);
+    return index == capacity_ ? nullptr : &slots_[index].value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Find(const Q &key) const noexcept -> const V * {
+    std::size_t index = findIndex(hash(key), key);
+    return index == capacity_ ? nullptr : &slots_[index].value;
+  }
+
+  auto GetOr(const K &key, const V &defaultValue) const noexcept -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto GetOr(const Q &key, const V &defaultValue) const noexcept -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  auto Contain(const K &key) const noexcept -> bool {
+    return findIndex(hash(key), key) != capacity_;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Contain(const Q &key) const noexcept -> bool {
+    return findIndex(hash(key), key) != capacity_;
+  }
+
+  auto Del(const K &key) noexcept -> bool { return eraseKey(key); }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Del(const Q &key) noexcept -> bool {
+    return eraseKey(key);
+  }
+
+  /**
+   * Same as HashMap::Update.
+   */
+  template <typename Fn>
+  auto Update(const K &key, Fn &&fn) -> bool {
+    V *value = Find(key);
+    if (value == nullptr) {
+      return false;
+    }
+    std::forward<Fn>(fn)(*value);
+    return true;
+  }
+
+  /**
+   * Same as HashMap::Compute.
+   */
+  template <typename Fn>
+  auto Compute(const K &key, Fn &&fn) -> V * {
+    std::size_t hashCode = hash(key);
+    std::size_t index = findIndex(hashCode, key);
+    bool present = index != capacity_;
+    std::optional<V> value =
+        std::forward<Fn>(fn)(key, present ? &slots_[index].value : nullptr);
+
+    if (present) {
+      if (value.has_value()) {
+        slots_[index].value = std::move(*value);
+        return &slots_[index].value;
+      }
+      eraseAt(index);
+      return nullptr;
+    }
+
+    if (!value.has_value()) {
+      return nullptr;
+    }
+    // indexed after the insertion, which may move slots_ to a new array
+    index = insertSlot(hashCode, key, std::move(*value));
+    return &slots_[index].value;
+  }
+
+  /**
+   * Same as HashMap::ComputeIfAbsent.
+   */
+  template <typename Fn>
+  auto ComputeIfAbsent(const K &key, Fn &&fn) -> V & {
+    std::size_t hashCode = hash(key);
+    std::size_t index = findIndex(hashCode, key);
+    if (index == capacity_) {
+      index = insertSlot(hashCode, key, std::forward<Fn>(fn)(key));
+    }
+    return slots_[index].value;
+  }
+
+  /**
+   * Same as HashMap::Merge.
+   */
+  template <typename ValueType, typename Fn>
+  auto Merge(const K &key, ValueType &&value, Fn &&fn) -> V * {
+    std::size_t hashCode = hash(key);
+    std::size_t index = findIndex(hashCode, key);
+    if (index == capacity_) {
+      index = insertSlot(hashCode, key, std::forward<ValueType>(value));
+      return &slots_[index].value;
+    }
+
+    std::optional<V> merged = std::forward<Fn>(fn)(
+        slots_[index].value, std::forward<ValueType>(value));
+    if (!merged.has_value()) {
+      eraseAt(index);
+      return nullptr;
+    }
+    slots_[index].value = std::move(*merged);
+    return &slots_[index].value;
+  }
+
+  [[nodiscard]] auto toString() const noexcept -> std::string {
+    // type check
+    static_assert(is_streamable<K>::value, "K must impl operator << ");
+    static_assert(is_streamable<V>::value, "V must impl operator << ");
+
+    std::stringstream ss;
+    ss << "{";
+    bool first = true;
+    for (std::size_t i = 0; i < capacity_; i++) {
+      if (ctrl_[i] >= 0) {
+        ss << (first ? "" : ",") << slots_[i].key << "=" << slots_[i].value;
+        first = false;
+      }
+    }
+    ss << "}";
+    return ss.str();
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+  ~FlatHashMap() {
+    for (std::size_t i = 0; i < capacity_; i++) {
+      if (ctrl_[i] >= 0) {
+        slots_[i].~Slot();
+      }
+    }
+    SlotTraits::deallocate(slotAllocator_, slots_, capacity_);
+  }
+};
+
+}  // namespace JAVA
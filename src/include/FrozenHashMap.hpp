@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Hasher.hpp"
+
+namespace JAVA {
+
+namespace frozen {
+
+// N of a FrozenHashMap whose size is only known at run time
+constexpr static std::size_t DYNAMIC =
+    std::numeric_limits<std::size_t>::max();
+
+// a pilot with this bit set holds the slot of the only key of its bucket,
+// otherwise it is the displacement that places the keys of its bucket
+constexpr static std::uint32_t DIRECT = std::uint32_t{1} << 31;
+
+constexpr static std::uint32_t MAX_DISPLACEMENT = std::uint32_t{1} << 24;
+
+constexpr static std::uint64_t DISPLACE_STEP = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * Maps h to [0, n) by its high bits, without a division.
+ */
+constexpr inline auto reduce(std::uint64_t h, std::size_t n) noexcept
+    -> std::size_t {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  return static_cast<std::size_t>(
+      (static_cast<unsigned __int128>(h) * n) >> 64);
+}
+
+/**
+ * Two keys per bucket on average, few enough for every bucket to find a
+ * displacement in a handful of tries.
+ */
+constexpr inline auto bucketsFor(std::size_t n) noexcept -> std::size_t {
+  return n / 2 + 1;
+}
+
+constexpr inline auto slotOf(std::uint64_t code, std::uint32_t displacement,
+                             std::size_t n) noexcept -> std::size_t {
+  return reduce(hashing::splitMix(code + displacement * DISPLACE_STEP), n);
+}
+
+}  // namespace frozen
+
+/**
+ * Immutable map over a fixed key set, built once with a minimal perfect
+ * hash so that every Get or Contain looks at exactly one slot.
+ *
+ * Construction follows CHD ("Hash, displace, and compress" by Belazzougui,
+ * Botelho and Dietzfelbinger): the keys are split into about n / 2 buckets,
+ * and from the largest bucket down every bucket gets the smallest
+ * displacement that sends all of its keys to free slots of a table of
+ * exactly n slots. Buckets of one key take any free slot directly. A
+ * lookup hashes the key, reads the pilot of its bucket and compares the
+ * key in the one slot the pilot gives.
+ *
+ * With N the map lives in std::arrays and, for literal K and V and a Hash
+ * usable in constant expressions like StaticHash, is built at compile time:
+ *
+ *   constexpr FrozenHashMap<std::string_view, int, 3> LEVELS{
+ *       {"debug", 0}, {"info", 1}, {"warn", 2}};
+ *   static_assert(LEVELS.Get("info") == 1);
+ *
+ * Without N it is sized at run time, e.g. from the entries of a HashMap
+ * that was filled at startup. Hash codes are remixed, so any Hash works.
+ * Get and Contain take any key type when Hash and KeyEqual are both
+ * transparent, as the defaults are.
+ *
+ * Construction throws std::invalid_argument if a key appears twice, if two
+ * keys have the same hash code or if a map with N is given a number of
+ * entries other than N. In a constant expression these do not compile.
+ */
+template <typename K, typename V, std::size_t N = frozen::DYNAMIC,
+          typename Hash = StaticHash, typename KeyEqual = std::equal_to<>>
+class FrozenHashMap {
+  static_assert(std::is_default_constructible_v<K> &&
+                    std::is_default_constructible_v<V>,
+                "K and V must be default constructible");
+
+  static_assert(N == frozen::DYNAMIC || (N > 0 && N < frozen::DIRECT),
+                "N must be positive and below 2^31");
+
+ public:
+  using key_type = K;
+
+  using mapped_type = V;
+
+  using size_type = std::size_t;
+
+ private:
+  template <typename Q>
+  struct is_key_like
+      : std::bool_constant<detail::is_transparent<Hash>::value &&
+                           detail::is_transparent<KeyEqual>::value &&
+                           !std::is_same_v<std::decay_t<Q>, K>> {};
+
+  template <typename T>
+  struct is_iterator {
+    template <typename U>
+    using category = typename std::iterator_traits<U>::iterator_category;
+
+    template <typename U>
+    static auto test(int)
+        -> decltype(std::declval<category<U> *>(), std::true_type{});
+
+    template <typename>
+    static auto test(...) -> std::false_type;
+
+    static constexpr bool value = decltype(test<T>(0))::value;
+  };
+
+  constexpr static bool FIXED = N != frozen::DYNAMIC;
+
+  constexpr static std::size_t FIXED_SIZE = FIXED ? N : 0;
+
+  constexpr static std::size_t FIXED_BUCKETS =
+      FIXED ? frozen::bucketsFor(N) : 0;
+
+  struct Entry {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    K key{};
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    V value{};
+  };
+
+  // arrays of Size elements with N, vectors sized at run time without
+  template <typename T, std::size_t Size>
+  using Buffer =
+      std::conditional_t<FIXED, std::array<T, Size>, std::vector<T>>;
+
+  template <typename T, std::size_t Size>
+  static constexpr auto makeBuffer(std::size_t n) -> Buffer<T, Size> {
+    if constexpr (FIXED) {
+      return Buffer<T, Size>{};
+    } else {
+      return Buffer<T, Size>(n);
+    }
+  }
+
+  Hash hasher_;
+
+  KeyEqual keyEqual_;
+
+  // the entry of every slot, in slot order
+  Buffer<Entry, FIXED_SIZE> entries_{};
+
+  // one per bucket, see frozen::DIRECT
+  Buffer<std::uint32_t, FIXED_BUCKETS> pilots_{};
+
+  template <typename Q>
+  constexpr auto codeOf(const Q &key) const noexcept -> std::uint64_t {
+    auto code = static_cast<std::uint64_t>(hasher_(key));
+    if constexpr (detail::is_avalanching<Hash>::value) {
+      return code;
+    } else {
+      return hashing::splitMix(code);
+    }
+  }
+
+  template <typename Q>
+  constexpr auto findEntry(const Q &key) const noexcept -> const Entry * {
+    if constexpr (!FIXED) {
+      if (entries_.empty()) {
+        return nullptr;
+      }
+    }
+    std::uint64_t code = codeOf(key);
+    std::uint32_t pilot = pilots_[frozen::reduce(code, pilots_.size())];
+    // both computed, so that the choice is a select rather than a branch
+    // the processor cannot predict
+    std::size_t displaced = frozen::slotOf(code, pilot, entries_.size());
+    std::size_t direct = pilot & ~frozen::DIRECT;
+    std::size_t slot = (pilot & frozen::DIRECT) != 0 ? direct : displaced;
+    const Entry &entry = entries_[slot];
+    return keyEqual_(entry.key, key) ? &entry : nullptr;
+  }
+
+  /**
+   * Copies the n entries of [first, last) and moves them to the slots of a
+   * minimal perfect hash.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  template <typename It>
+  constexpr auto build(It first, It last, std::size_t n) -> void {
+    if constexpr (FIXED) {
+      if (n != N) {
+        throw std::invalid_argument(
+            "FrozenHashMap needs exactly N entries, " + std::to_string(n) +
+            " given");
+      }
+    } else {
+      if (n >= frozen::DIRECT) {
+        throw std::invalid_argument("Too many entries for FrozenHashMap");
+      }
+    }
+    entries_ = makeBuffer<Entry, FIXED_SIZE>(n);
+    for (std::size_t i = 0; first != last; ++first, ++i) {
+      auto &&entry = *first;
+      entries_[i].key = entry.first;
+      entries_[i].value = entry.second;
+    }
+    if (n == 0) {
+      return;
+    }
+
+    std::size_t buckets = frozen::bucketsFor(n);
+    pilots_ = makeBuffer<std::uint32_t, FIXED_BUCKETS>(buckets);
+    auto codes = makeBuffer<std::uint64_t, FIXED_SIZE>(n);
+    auto bucketOf = makeBuffer<std::size_t, FIXED_SIZE>(n);
+    for (std::size_t i = 0; i < n; i++) {
+      codes[i] = codeOf(entries_[i].key);
+      bucketOf[i] = frozen::reduce(codes[i], buckets);
+    }
+
+    // keys grouped by bucket, the keys of bucket b are
+    // order[starts[b], starts[b + 1])
+    auto starts = makeBuffer<std::size_t, FIXED_BUCKETS + 1>(buckets + 1);
+    for (std::size_t i = 0; i < n; i++) {
+      ++starts[bucketOf[i] + 1];
+    }
+    std::size_t largest = 0;
+    for (std::size_t b = 0; b < buckets; b++) {
+      largest = std::max(largest, starts[b + 1]);
+      starts[b + 1] += starts[b];
+    }
+    auto order = makeBuffer<std::size_t, FIXED_SIZE>(n);
+    {
+      auto next = makeBuffer<std::size_t, FIXED_BUCKETS + 1>(buckets + 1);
+      for (std::size_t b = 0; b < buckets; b++) {
+        next[b] = starts[b];
+      }
+      for (std::size_t i = 0; i < n; i++) {
+        order[next[bucketOf[i]]++] = i;
+      }
+    }
+
+    auto taken = makeBuffer<bool, FIXED_SIZE>(n);
+    auto slots = makeBuffer<std::size_t, FIXED_SIZE>(n);
+    for (std::size_t size = largest; size >= 2; size--) {
+      for (std::size_t b = 0; b < buckets; b++) {
+        std::size_t begin = starts[b];
+        std::size_t end = starts[b + 1];
+        if (end - begin != size) {
+          continue;
+        }
+        // no displacement separates keys with equal hash codes
+        for (std::size_t x = begin; x < end; x++) {
+          for (std::size_t y = x + 1; y < end; y++) {
+            if (codes[order[x]] == codes[order[y]]) {
+              throw std::invalid_argument(
+                  keyEqual_(entries_[order[x]].key, entries_[order[y]].key)
+                      ? "Duplicate key in FrozenHashMap"
+                      : "Keys with equal hash codes in FrozenHashMap");
+            }
+          }
+        }
+        std::uint32_t displacement = 0;
+        for (;; displacement++) {
+          if (displacement == frozen::MAX_DISPLACEMENT) {
+            throw std::invalid_argument("No perfect hash for FrozenHashMap");
+          }
+          std::size_t placed = begin;
+          for (; placed < end; placed++) {
+            std::size_t i = order[placed];
+            slots[i] = frozen::slotOf(codes[i], displacement, n);
+            if (taken[slots[i]]) {
+              break;
+            }
+            taken[slots[i]] = true;
+          }
+          if (placed == end) {
+            break;
+          }
+          for (std::size_t undo = begin; undo < placed; undo++) {
+            taken[slots[order[undo]]] = false;
+          }
+        }
+        pilots_[b] = displacement;
+      }
+    }
+
+    std::size_t freeSlot = 0;
+    for (std::size_t b = 0; b < buckets; b++) {
+      if (starts[b + 1] - starts[b] != 1) {
+        continue;
+      }
+      while (taken[freeSlot]) {
+        ++freeSlot;
+      }
+      taken[freeSlot] = true;
+      slots[order[starts[b]]] = freeSlot;
+      pilots_[b] = frozen::DIRECT | static_cast<std::uint32_t>(freeSlot);
+    }
+
+    auto placed = makeBuffer<Entry, FIXED_SIZE>(n);
+    for (std::size_t i = 0; i < n; i++) {
+      placed[slots[i]] = std::move(entries_[i]);
+    }
+    entries_ = std::move(placed);
+  }
+
+ public:
+  constexpr FrozenHashMap(std::initializer_list<std::pair<K, V>> entries,
+                          const Hash &hasher = Hash(),
+                          const KeyEqual &keyEqual = KeyEqual())
+      : hasher_(hasher), keyEqual_(keyEqual) {
+    build(entries.begin(), entries.end(), entries.size());
+  }
+
+  /**
+   * Builds the map from the key/value pairs of [first, last), e.g. the
+   * begin() and end() of a HashMap.
+   */
+  template <typename ForwardIt,
+            std::enable_if_t<is_iterator<ForwardIt>::value, int> = 0>
+  FrozenHashMap(ForwardIt first, ForwardIt last, const Hash &hasher = Hash(),
+                const KeyEqual &keyEqual = KeyEqual())
+      : hasher_(hasher), keyEqual_(keyEqual) {
+    build(first, last,
+          static_cast<std::size_t>(std::distance(first, last)));
+  }
+
+  constexpr auto Get(const K &key) const noexcept -> std::optional<V> {
+    const Entry *entry = findEntry(key);
+    return entry == nullptr ? std::nullopt : std::optional<V>(entry->value);
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  constexpr auto Get(const Q &key) const noexcept -> std::optional<V> {
+    const Entry *entry = findEntry(key);
+    return entry == nullptr ? std::nullopt : std::optional<V>(entry->value);
+  }
+
+  /**
+   * Returns a pointer to the value of key, or nullptr if key is absent.
+   */
+  constexpr auto Find(const K &key) const noexcept -> const V * {
+    const Entry *entry = findEntry(key);
+    return entry == nullptr ? nullptr : &entry->value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  constexpr auto Find(const Q &key) const noexcept -> const V * {
+    const Entry *entry = findEntry(key);
+    return entry == nullptr ? nullptr : &entry->value;
+  }
+
+  constexpr auto GetOr(const K &key, const V &defaultValue) const noexcept
+      -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  constexpr auto GetOr(const Q &key, const V &defaultValue) const noexcept
+      -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  constexpr auto Contain(const K &key) const noexcept -> bool {
+    return findEntry(key) != nullptr;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  constexpr auto Contain(const Q &key) const noexcept -> bool {
+    return findEntry(key) != nullptr;
+  }
+
+  /**
+   * Calls fn(key, value) with every entry, in slot order.
+   */
+  template <typename Fn>
+  constexpr auto ForEach(Fn &&fn) const -> void {
+    for (const Entry &entry : entries_) {
+      fn(entry.key, entry.value);
+    }
+  }
+
+  [[nodiscard]] constexpr auto size() const noexcept -> std::size_t {
+    return entries_.size();
+  }
+
+  [[nodiscard]] constexpr auto empty() const noexcept -> bool {
+    return entries_.size() == 0;
+  }
+};
+
+}  // namespace JAVA
@@ -1,26 +1,142 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <istream>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <ostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "Hasher.hpp"
+#include "Serialization.hpp"
+#include "Snapshot.hpp"
+#include "Trace.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// counts resizes and their time for HashMap::Stats, define as 0 to drop the
+// counters
+#ifndef HASHMAP_STATS
+#define HASHMAP_STATS 1
+#endif
+
+// calls the HashMapObserver set with HashMap::SetObserver from Get, Put, Del,
+// resizes and slab allocations. Off by default, the hooks then compile to
+// nothing
+#ifndef HASHMAP_TRACE
+#define HASHMAP_TRACE 0
+#endif
+
 namespace JAVA {
 
-template <typename K, typename V>
+/**
+ * Shape and memory of a HashMap at one point in time, see HashMap::Stats.
+ */
+struct HashMapStats {
+  std::size_t size = 0;
+
+  std::size_t bucketCount = 0;
+
+  // size / bucketCount
+  double load = 0;
+
+  // chainLengths[n] is the number of buckets holding n entries, for every n
+  // up to maxChain
+  std::vector<std::size_t> chainLengths;
+
+  std::size_t maxChain = 0;
+
+  std::size_t treeBins = 0;
+
+  // node slabs allocated, and the cells in them that hold no entry
+  std::size_t slabs = 0;
+
+  std::size_t freeCells = 0;
+
+  // bytes held by the map, see HashMap::MemoryUsage, and the part of them
+  // taken by the nodes of its entries
+  std::size_t bytesReserved = 0;
+
+  std::size_t bytesLive = 0;
+
+  // resizes and rehashes since construction and the time spent in them,
+  // always 0 unless HASHMAP_STATS
+  std::size_t resizes = 0;
+
+  std::chrono::nanoseconds resizeTime{0};
+};
+
+/**
+ * Hash: hash function of K. If it declares a member type is_avalanching,
+ * every bit of its result is assumed to depend on every bit of the key and
+ * the h ^ (h >> 16) spread is skipped. Nodes of keys that are trivially
+ * copyable and no larger than a pointer do not store their hash code when
+ * Hash is stateless, it is recomputed when needed unless Hash declares a
+ * member type is_expensive.
+ *
+ * KeyEqual: equality of K, defaults to K::operator==. If both Hash and
+ * KeyEqual declare a member type is_transparent, Get, Contain and Del also
+ * accept any type they can hash and compare against K, e.g. std::string_view
+ * for a map keyed by std::string with StringHash and std::equal_to<>.
+ *
+ * Alloc: allocator for all the memory of the map (node slabs, tree bins and
+ * bucket arrays), rebound to the type it has to allocate.
+ *
+ * TaggedBuckets: every bucket also keeps an inline array with an 8-bit tag of
+ * the hash code of each node in its chain, so lookups compare all the tags
+ * of a bucket at once and only follow the chain when a tag matches.
+ *
+ * IncrementalResize: a resize only allocates the new table. The old one is
+ * kept next to it and its buckets are moved over a few at a time by every
+ * following Put, Del, Update, Compute and the like, hits or misses, as in
+ * the progressive rehash of Redis, so no single Put pays for moving every
+ * entry. Const lookups never move anything, so a read-only phase keeps
+ * probing both tables until the next call that may modify the map.
+ *
+ * Large bulk loads, and large resizes once SetParallelism has been called,
+ * are spread over several threads. Hash and KeyEqual are then used from
+ * those threads at the same time, and so is Alloc when it is not
+ * std::allocator and SetParallelism asked for threads.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>,
+          bool TaggedBuckets = false, bool IncrementalResize = false>
 class HashMap {
   // NOLINTNEXTLINE(readability-magic-numbers)
   static_assert(sizeof(std::size_t) == 8);
 
-  static_assert(
-      std::is_same_v<decltype(std::declval<K>() == std::declval<K>()), bool>,
-      "type K must impl operator==");
+  static_assert(std::is_same_v<decltype(std::declval<const KeyEqual &>()(
+                                   std::declval<const K &>(),
+                                   std::declval<const K &>())),
+                               bool>,
+                "type K must impl operator== or KeyEqual must compare K");
+
+  static_assert(std::is_convertible_v<decltype(std::declval<const Hash &>()(
+                                          std::declval<const K &>())),
+                                      std::size_t>,
+                "Hash must map K to std::size_t");
 
  private:
   /**
@@ -34,12 +150,6 @@ class HashMap {
    */
   constexpr static std::size_t MAXIMUM_CAPACITY = 1 << 30;
 
-  /**
-   * Hash Function, if is not the basic type, you can using your hash function
-   * by Instantiated template
-   */
-  constexpr static std::hash<K> HASH_FUNCTION = std::hash<K>();
-
   constexpr static std::size_t HASHCODE_REMOVE_SIZE = 1 << 4;
 
   /**
@@ -47,11 +157,105 @@ class HashMap {
    */
   constexpr static float DEFAULT_LOAD_FACTOR = 0.75;
 
-  static inline auto hash(const K &key) noexcept -> std::size_t {
-    std::size_t h = HASH_FUNCTION(key);
-    return h ^ (h >> HASHCODE_REMOVE_SIZE);
+  /**
+   * The bin count threshold for using a tree rather than list for a bin. Bins
+   * are converted to trees when adding an element to a bin with at least this
+   * many nodes.
+   */
+  constexpr static std::size_t TREEIFY_THRESHOLD = 8;
+
+  /**
+   * The bin count threshold for untreeifying a (split) bin during a resize
+   * operation. Should be less than TREEIFY_THRESHOLD.
+   */
+  constexpr static std::size_t UNTREEIFY_THRESHOLD = 6;
+
+  /**
+   * The smallest table capacity for which bins may be treeified. (Otherwise
+   * the table is resized if too many nodes in a bin.)
+   */
+  constexpr static std::size_t MIN_TREEIFY_CAPACITY = 64;
+
+  /**
+   * Buckets of the old table moved by every modifying call while an
+   * incremental resize is running. More than 4/3 finishes a rehash before
+   * the new table reaches its own threshold.
+   */
+  constexpr static std::size_t INCREMENTAL_RESIZE_BUCKETS = 4;
+
+  /**
+   * The least number of entries or buckets a thread is given by BulkLoad and
+   * resize(). Less work than that is done on the calling thread alone.
+   */
+  constexpr static std::size_t PARALLEL_MIN_WORK = 1 << 14;
+
+  /**
+   * Value of movedBin(), never the address of a node.
+   */
+  constexpr static std::uintptr_t MOVED_BIN = 2;
+
+  /**
+   * Keys GetMany and ContainMany have in flight at once: enough to overlap
+   * their cache misses, few enough that the prefetched lines are still in L1
+   * when the keys are resolved.
+   */
+  constexpr static std::size_t PREFETCH_GROUP = 16;
+
+  /**
+   * Text Dump collects before writing it out.
+   */
+  constexpr static std::size_t DUMP_BUFFER_BYTES = 1 << 16;
+
+  /**
+   * Significant digits of floating point keys and values in toString, the
+   * default of operator<<.
+   */
+  constexpr static int FORMAT_FLOAT_PRECISION = 6;
+
+  /**
+   * Whether Get, Contain and Del may be called with a Q instead of a K, which
+   * requires both Hash and KeyEqual to declare is_transparent.
+   */
+  template <typename Q>
+  struct is_key_like
+      : std::bool_constant<detail::is_transparent<Hash>::value &&
+                           detail::is_transparent<KeyEqual>::value &&
+                           !std::is_same_v<std::decay_t<Q>, K>> {};
+
+  template <typename T>
+  struct is_iterator {
+    template <typename U>
+    using category = typename std::iterator_traits<U>::iterator_category;
+
+    template <typename U>
+    static auto test(int)
+        -> decltype(std::declval<category<U> *>(), std::true_type{});
+
+    template <typename>
+    static auto test(...) -> std::false_type;
+
+    static constexpr bool value = decltype(test<T>(0))::value;
+  };
+
+  static inline auto spread(std::size_t h) noexcept -> std::size_t {
+    if constexpr (detail::is_avalanching<Hash>::value) {
+      return h;
+    } else {
+      return h ^ (h >> HASHCODE_REMOVE_SIZE);
+    }
+  }
+
+  template <typename Q>
+  inline auto hash(const Q &key) const noexcept -> std::size_t {
+    return spread(hasher_(key));
   }
 
+  template <typename T>
+  struct is_std_allocator : std::false_type {};
+
+  template <typename T>
+  struct is_std_allocator<std::allocator<T>> : std::true_type {};
+
   template <typename T>
   struct is_streamable {
     template <typename U>
@@ -65,10 +269,53 @@ class HashMap {
     static constexpr bool value = decltype(test<T>(0))::value;
   };
 
-  struct Node {
+  template <typename T>
+  struct is_character
+      : std::bool_constant<
+            std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+            std::is_same_v<T, unsigned char> || std::is_same_v<T, wchar_t> ||
+            std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>> {};
+
+  template <typename T, typename U = T>
+  struct is_less_comparable {
+    template <typename A, typename B>
+    static auto test(int)
+        -> decltype(std::declval<const A &>() < std::declval<const B &>(),
+                    std::declval<const B &>() < std::declval<const A &>(),
+                    std::true_type{});
+
+    template <typename, typename>
+    static auto test(...) -> std::false_type;
+
+    static constexpr bool value = decltype(test<T, U>(0))::value;
+  };
+
+  /**
+   * Nodes of small trivially copyable keys with a stateless hash do not
+   * cache their hash code, it is recomputed from the key whenever a resize
+   * or a tree bin needs it. For HashMap<int, int> that makes a node 16 bytes
+   * instead of 24, and a chain walk compares the key directly instead of the
+   * hash code first.
+   */
+  constexpr static bool COMPACT_NODES =
+      std::is_trivially_copyable_v<K> && sizeof(K) <= sizeof(std::size_t) &&
+      std::is_empty_v<Hash> && std::is_default_constructible_v<Hash> &&
+      !detail::is_expensive<Hash>::value;
+
+  struct CachedHashCode {
     // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
     const std::size_t hash_code;
 
+    explicit CachedHashCode(std::size_t hashCode) noexcept
+        : hash_code(hashCode) {}
+  };
+
+  struct NoHashCode {
+    explicit NoHashCode(std::size_t /*unused*/) noexcept {}
+  };
+
+  struct Node
+      : public std::conditional_t<COMPACT_NODES, NoHashCode, CachedHashCode> {
     // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
     const K key;
 
@@ -78,334 +325,3179 @@ class HashMap {
     // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
     Node *next;
 
-    Node(std::size_t hash_code, K key, V value, Node *next)
-        : hash_code(hash_code), key(key), value(value), next(next) {}
-
-    [[nodiscard]] auto toString() const noexcept -> std::string {
-      // type check
-      static_assert(is_streamable<K>::value, "K must impl operator << ");
-      static_assert(is_streamable<V>::value, "V must impl operator << ");
-      std::stringstream ss;
-      ss << key << "=" << value;
-      return ss.str();
-    }
+    /**
+     * key and value are constructed in place from keyArg and valueArgs.
+     */
+    template <typename KeyArg, typename... ValueArgs>
+    Node(std::size_t hash_code, Node *next, KeyArg &&keyArg,
+         ValueArgs &&...valueArgs)
+        : std::conditional_t<COMPACT_NODES, NoHashCode, CachedHashCode>(
+              hash_code),
+          key(std::forward<KeyArg>(keyArg)),
+          value(std::forward<ValueArgs>(valueArgs)...),
+          next(next) {}
   };
 
-  class ObjectPool {
-   private:
-    constexpr static std::size_t DEFAULT_BLOCK_SIZE = 1 << 10;
-
-    constexpr static float DEFAULT_FREE_DEALLOCATE_NODE_LOAD_FACTOR = 1.75;
-
-    std::vector<Node *> free_list_;
-
-    std::vector<Node *> del_list;
-
-    std::size_t blockSize_;
-
-    std::size_t size_ = 0;
-
-    std::size_t index_ = 0;
-
-    float free_deallocate_node_load_factor_;
-
-    auto allocateBlock() noexcept -> void {
-      for (std::size_t i = 0; i < blockSize_; ++i) {
-        free_list_[i] = (static_cast<Node *>(::operator new(sizeof(Node))));
-      }
-      size_ += blockSize_;
-      index_ = 0;
-    }
-
-    auto freeBlock() noexcept -> void {
-      std::size_t old_size = del_list.size();
-      for (Node *node : del_list) {
-        ::operator delete(node);
-      }
-      del_list.clear();
-      size_ -= old_size;
-    }
+  /**
+   * Entry for tree bins. Tree bins are red-black trees ordered primarily by
+   * hash code and then by operator< when K provides one, and they still keep
+   * their nodes chained through next so that traversal does not care whether
+   * a bin is a list or a tree.
+   */
+  struct TreeNode : public Node {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    TreeNode *parent = nullptr;
 
-   public:
-    explicit ObjectPool(size_t blockSize = DEFAULT_BLOCK_SIZE,
-                        float free_deallocate_node_load_factor =
-                            DEFAULT_FREE_DEALLOCATE_NODE_LOAD_FACTOR)
-        : blockSize_(blockSize),
-          free_list_(std::vector<Node *>(blockSize, nullptr)),
-          free_deallocate_node_load_factor_(free_deallocate_node_load_factor) {
-      allocateBlock();
-    }
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    TreeNode *left = nullptr;
 
-    auto allocate() noexcept -> Node * {
-      if (index_ == blockSize_) {
-        allocateBlock();
-      }
-      size_--;
-      return free_list_[index_++];
-    }
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    TreeNode *right = nullptr;
 
-    auto deallocate(Node *node) -> void {
-      node->~Node();
-      std::memset(node, 0, sizeof(Node));
-      del_list.emplace_back(node);
-      if (++size_ > blockSize_ * free_deallocate_node_load_factor_) {
-        freeBlock();
-      }
-    }
+    // needed to unlink next upon deletion
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    TreeNode *prev = nullptr;
 
-    ~ObjectPool() {
-      while (index_ < blockSize_) {
-        ::operator delete(free_list_[index_++]);
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    bool red = false;
+
+    template <typename KeyArg, typename... ValueArgs>
+    TreeNode(std::size_t hash_code, Node *next, KeyArg &&keyArg,
+             ValueArgs &&...valueArgs)
+        : Node(hash_code, next, std::forward<KeyArg>(keyArg),
+               std::forward<ValueArgs>(valueArgs)...) {}
+
+    auto root() noexcept -> TreeNode * {
+      TreeNode *r = this;
+      while (r->parent != nullptr) {
+        r = r->parent;
       }
-
-      freeBlock();
+      return r;
     }
   };
 
-  ObjectPool objectPool_;
-
-  std::size_t capacity_;
-
-  std::size_t threshold_;
-
-  std::vector<Node *> tables_;
-
-  std::size_t size_ = 0;
+  /**
+   * Tree bins are marked by setting the lowest bit of their slot in tables_,
+   * so the hot path can tell a list from a tree without touching the node.
+   */
+  constexpr static std::uintptr_t TREE_BIN_TAG = 1;
 
-  float loadFactor;
+  static_assert(alignof(Node) > TREE_BIN_TAG,
+                "Node alignment must leave room for the tree bin tag");
 
-  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
-  auto resize() noexcept -> void {
-    std::size_t oldCap = tables_.size();
-    std::size_t oldThr = threshold_;
-    std::size_t newCap = 0;
-    std::size_t newThr = 0;
+  static inline auto isTreeBin(const Node *bin) noexcept -> bool {
+    return (reinterpret_cast<std::uintptr_t>(bin) & TREE_BIN_TAG) != 0;
+  }
 
-    if (oldCap >= MAXIMUM_CAPACITY) {
-      threshold_ = std::numeric_limits<std::size_t>::max();
-      return;
+  /**
+   * Hash code of the key of node, see COMPACT_NODES.
+   */
+  static inline auto hashOf(const Node *node) noexcept -> std::size_t {
+    if constexpr (COMPACT_NODES) {
+      return spread(Hash{}(node->key));
+    } else {
+      return node->hash_code;
     }
+  }
 
-    if ((newCap = (oldCap << 1)) < MAXIMUM_CAPACITY &&
-        oldCap >= DEFAULT_INITIAL_CAPACITY) {
-      newThr = oldThr << 1;
+  /**
+   * Whether node holds key, whose hash code is hashCode.
+   */
+  template <typename Q>
+  inline auto matches(const Node *node, std::size_t hashCode,
+                      const Q &key) const noexcept -> bool {
+    countProbe();
+    if constexpr (COMPACT_NODES) {
+      return keyEqual_(node->key, key);
+    } else {
+      return node->hash_code == hashCode && keyEqual_(node->key, key);
     }
+  }
 
-    if (newThr == 0) {
-      float ft = static_cast<float>(newCap) * loadFactor;
-      newThr = (newCap < MAXIMUM_CAPACITY &&
-                        ft < static_cast<float>(MAXIMUM_CAPACITY)
-                    ? static_cast<std::size_t>(ft)
-                    : std::numeric_limits<std::size_t>::max());
+  static inline auto binHead(Node *bin) noexcept -> Node * {
+    return reinterpret_cast<Node *>(reinterpret_cast<std::uintptr_t>(bin) &
+                                    ~TREE_BIN_TAG);
+  }
+
+  static inline auto treeBin(TreeNode *root) noexcept -> Node * {
+    if (root == nullptr) {
+      return nullptr;
     }
+    return reinterpret_cast<Node *>(
+        reinterpret_cast<std::uintptr_t>(static_cast<Node *>(root)) |
+        TREE_BIN_TAG);
+  }
 
-    capacity_ = newCap;
-    threshold_ = newThr;
-    std::vector<Node *> newTable(newCap, nullptr);
+  /**
+   * The number of chain positions covered by the tag array of a bucket, nodes
+   * past it are still found by walking the chain. List bins are treeified
+   * after TREEIFY_THRESHOLD nodes, so in practice every node has a tag.
+   */
+  constexpr static std::size_t BUCKET_TAG_WIDTH = 16;
 
-    // move data
-    for (std::size_t i = 0; i < oldCap; i++) {
-      Node *e = nullptr;
+  /**
+   * Tag of an empty chain position, real tags are never 0.
+   */
+  constexpr static std::uint8_t EMPTY_TAG = 0;
 
-      if ((e = tables_[i]) != nullptr) {
-        // table -> e -> nullptr
-        if (e->next == nullptr) {
-          newTable[e->hash_code & (newCap - 1)] = e;
-        } else {
-          // table -> e1 -> e2 -> ...
-          Node *loHead = nullptr;
-          Node *loTail = nullptr;
+  constexpr static std::size_t TAG_MIX = 0x9E3779B97F4A7C15ULL;
 
-          Node *hiHead = nullptr;
-          Node *hiTail = nullptr;
+  constexpr static std::size_t TAG_SHIFT = 56;
 
-          Node *next = nullptr;
+  struct alignas(BUCKET_TAG_WIDTH) BucketTags {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::uint8_t tag[BUCKET_TAG_WIDTH];
+  };
 
-          do {
-            next = e->next;
+  template <typename T>
+  using Rebind =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
 
-            if ((e->hash_code & oldCap) == 0) {
-              // no need to move(because the bit length <= oldCap)
-              if (loTail == nullptr) {
-                loHead = e;
-              } else {
-                loTail->next = e;
-              }
-              loTail = e;
-            } else {
-              // need to move
-              if (hiTail == nullptr) {
-                hiHead = e;
-              } else {
-                hiTail->next = e;
-              }
-              hiTail = e;
-            }
+  /**
+   * Allocator adaptor that default-initializes instead of value-initializing,
+   * so vector(n) leaves the elements unwritten. Tables that need empty
+   * buckets up front pass the value explicitly.
+   */
+  template <typename A>
+  struct DefaultInit : A {
+    using A::A;
 
-          } while ((e = next) != nullptr);
+    template <typename U>
+    struct rebind {
+      using other = DefaultInit<
+          typename std::allocator_traits<A>::template rebind_alloc<U>>;
+    };
 
-          if (loTail != nullptr) {
-            loTail->next = nullptr;
-            newTable[i] = loHead;
-          }
+    template <typename U>
+    auto construct(U *p) noexcept(
+        std::is_nothrow_default_constructible_v<U>) -> void {
+      ::new (static_cast<void *>(p)) U;
+    }
 
-          if (hiTail != nullptr) {
-            hiTail->next = nullptr;
-            newTable[i + oldCap] = hiHead;
-          }
-        }
-      }
+    template <typename U, typename... Args>
+    auto construct(U *p, Args &&...args) -> void {
+      std::allocator_traits<A>::construct(static_cast<A &>(*this), p,
+                                          std::forward<Args>(args)...);
     }
-    tables_ = std::move(newTable);
   };
 
- public:
-  HashMap() noexcept
-      : capacity_(DEFAULT_INITIAL_CAPACITY),
-        tables_(std::vector<Node *>(DEFAULT_INITIAL_CAPACITY, nullptr)),
-        threshold_(capacity_ * DEFAULT_LOAD_FACTOR),
-        loadFactor(DEFAULT_LOAD_FACTOR),
-        objectPool_(){};
+  using NodeTable = std::vector<Node *, DefaultInit<Rebind<Node *>>>;
 
-  template <typename KeyType, typename ValueType>
-  auto Put(KeyType &&key, ValueType &&value) noexcept -> void {
-    // type check
-    using DecayedKeyType = std::decay_t<KeyType>;
-    using DecayedValueType = std::decay_t<ValueType>;
-    static_assert(std::is_same_v<DecayedKeyType, K>,
-                  "KeyType must be the same as K");
-    static_assert(std::is_same_v<DecayedValueType, V>,
-                  "ValueType must be the same as V");
+  using TagTable = std::vector<BucketTags, DefaultInit<Rebind<BucketTags>>>;
 
-    std::size_t hashCode = hash(key);
-    std::size_t index = hashCode & (capacity_ - 1);
+  /**
+   * The index only uses the low bits of the hash code, so the tag is taken
+   * from the top byte of a multiplicative mix of all of them.
+   */
+  static inline auto tagOf(std::size_t hashCode) noexcept -> std::uint8_t {
+    auto t = static_cast<std::uint8_t>((hashCode * TAG_MIX) >> TAG_SHIFT);
+    return t + static_cast<std::uint8_t>(t == EMPTY_TAG);
+  }
 
-    if (tables_[index] == nullptr) {
-      tables_[index] =
-          new (objectPool_.allocate()) Node(hashCode, key, value, nullptr);
+  /**
+   * Returns a mask with bit i set when the i-th chain position of the bucket
+   * carries the given tag.
+   */
+  static inline auto matchTags(const BucketTags &bucket,
+                               std::uint8_t tag) noexcept -> std::uint32_t {
+#if defined(__SSE2__)
+    __m128i tags =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(bucket.tag));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(
+        _mm_cmpeq_epi8(tags, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < BUCKET_TAG_WIDTH; i++) {
+      mask |= static_cast<std::uint32_t>(bucket.tag[i] == tag) << i;
+    }
+    return mask;
+#endif
+  }
 
-      if (++size_ > threshold_) {
-        resize();
-      }
+  /**
+   * Whether the chain of the bucket may be longer than its tag array.
+   */
+  static inline auto tagsOverflow(const BucketTags &bucket) noexcept -> bool {
+    return bucket.tag[BUCKET_TAG_WIDTH - 1] != EMPTY_TAG;
+  }
 
+  /**
+   * Recomputes the tags of a bucket from its chain, tree bins have no tags.
+   */
+  static auto refreshTags(BucketTags &bucket, Node *bin) noexcept -> void {
+    std::memset(bucket.tag, EMPTY_TAG, BUCKET_TAG_WIDTH);
+    if (isTreeBin(bin)) {
       return;
     }
-
-    // tables_[index] != nullptr
-    Node *node = tables_[index];
-    while (node->next != nullptr) {
-      if (node->hash_code == hashCode && node->key == key) {
-        node->value = value;
-        break;
-      }
-      node = node->next;
+    std::size_t pos = 0;
+    for (Node *node = bin; node != nullptr && pos < BUCKET_TAG_WIDTH;
+         node = node->next) {
+      bucket.tag[pos++] = tagOf(hashOf(node));
     }
+  }
 
-    // node -> next
-    if (node->next == nullptr) {
-      if (node->hash_code == hashCode && node->key == key) {
-        node->value = value;
-      } else {
-        node->next =
-            new (objectPool_.allocate()) Node(hashCode, key, value, nullptr);
+  /**
+   * Whether operator< agrees with KeyEqual, which only holds for the default
+   * equality. A custom KeyEqual may call keys equal that operator< orders.
+   */
+  static constexpr bool KEY_LESS_MATCHES_EQUAL =
+      std::is_same_v<KeyEqual, std::equal_to<K>> ||
+      std::is_same_v<KeyEqual, std::equal_to<>>;
 
-        if (++size_ > threshold_) {
-          resize();
-        }
+  /**
+   * Orders keys with equal hash codes, 0 if K is not comparable, operator<
+   * may disagree with KeyEqual, or the keys are equivalent.
+   */
+  template <typename Q>
+  static auto compareKeys(const Q &k, const K &pk) noexcept -> int {
+    if constexpr (KEY_LESS_MATCHES_EQUAL && is_less_comparable<Q, K>::value) {
+      if (k < pk) {
+        return -1;
       }
-    }
-  };
-
-  auto Get(const K &key) const noexcept -> std::optional<V> {
-    std::size_t hashCode = hash(key);
-    Node *node = tables_[hashCode & (capacity_ - 1)];
-
-    while (node != nullptr) {
-      if (node->hash_code == hashCode && node->key == key) {
-        return std::make_optional(node->value);
+      if (pk < k) {
+        return 1;
       }
-      node = node->next;
     }
-
-    return std::nullopt;
+    return 0;
   }
 
-  auto Contain(const K &key) const noexcept -> bool {
-    std::size_t hashCode = hash(key);
-    Node *node = tables_[hashCode & (capacity_ - 1)];
+  /**
+   * Tie-breaking utility for ordering insertions when keys have equal hash
+   * codes and are not comparable. We don't require a total order, just a
+   * consistent insertion rule to maintain equivalence across rebalancings.
+   */
+  static auto tieBreakOrder(const K &a, const K &b) noexcept -> int {
+    return std::less<const void *>()(&a, &b) ? -1 : 1;
+  }
 
-    while (node != nullptr) {
-      if (node->hash_code == hashCode && node->key == key) {
-        return true;
+  /**
+   * Finds the node starting at root p with the given hash and key.
+   */
+  template <typename Q>
+  auto find(TreeNode *p, std::size_t h, const Q &k) const noexcept
+      -> TreeNode * {
+    do {
+      countProbe();
+      TreeNode *pl = p->left;
+      TreeNode *pr = p->right;
+      TreeNode *q = nullptr;
+      int dir = 0;
+      std::size_t ph = hashOf(p);
+      if (ph > h) {
+        p = pl;
+      } else if (ph < h) {
+        p = pr;
+      } else if (keyEqual_(p->key, k)) {
+        return p;
+      } else if (pl == nullptr) {
+        p = pr;
+      } else if (pr == nullptr) {
+        p = pl;
+      } else if ((dir = compareKeys(k, p->key)) != 0) {
+        p = dir < 0 ? pl : pr;
+      } else if ((q = find(pr, h, k)) != nullptr) {
+        return q;
+      } else {
+        p = pl;
       }
-      node = node->next;
-    }
-
-    return false;
+    } while (p != nullptr);
+    return nullptr;
   }
 
-  auto Del(const K &key) noexcept -> bool {
-    std::size_t hashCode = hash(key);
-    Node *prev = nullptr;
-    Node *curr = tables_[hashCode & (capacity_ - 1)];
-    while (curr != nullptr) {
-      Node *next = curr->next;
-      if (curr->hash_code == hashCode && curr->key == key) {
-        // curr = tables_[hashCode & (capacity_ - 1)];
-        if (prev == nullptr) {
-          tables_[hashCode & (capacity_ - 1)] = next;
-        } else {
-          // prev -> curr -> next
-          prev->next = next;
-        }
-        objectPool_.deallocate(curr);
-        size_--;
-        return true;
+  static auto rotateLeft(TreeNode *root, TreeNode *p) noexcept -> TreeNode * {
+    TreeNode *r = nullptr;
+    if (p != nullptr && (r = p->right) != nullptr) {
+      TreeNode *rl = p->right = r->left;
+      if (rl != nullptr) {
+        rl->parent = p;
       }
-      prev = curr;
-      curr = next;
+      TreeNode *pp = r->parent = p->parent;
+      if (pp == nullptr) {
+        root = r;
+        root->red = false;
+      } else if (pp->left == p) {
+        pp->left = r;
+      } else {
+        pp->right = r;
+      }
+      r->left = p;
+      p->parent = r;
     }
-    return false;
+    return root;
   }
 
-  [[nodiscard]] auto toString() const noexcept -> std::string {
-    // type check
-    static_assert(is_streamable<K>::value, "K must impl operator << ");
-    static_assert(is_streamable<V>::value, "V must impl operator << ");
-
-    std::string ans("{");
-    for (const Node *node : tables_) {
-      while (node != nullptr) {
-        ans.append(node->toString());
-        ans.append(",");
+  static auto rotateRight(TreeNode *root, TreeNode *p) noexcept -> TreeNode * {
+    TreeNode *l = nullptr;
+    if (p != nullptr && (l = p->left) != nullptr) {
+      TreeNode *lr = p->left = l->right;
+      if (lr != nullptr) {
+        lr->parent = p;
+      }
+      TreeNode *pp = l->parent = p->parent;
+      if (pp == nullptr) {
+        root = l;
+        root->red = false;
+      } else if (pp->right == p) {
+        pp->right = l;
+      } else {
+        pp->left = l;
+      }
+      l->right = p;
+      p->parent = l;
+    }
+    return root;
+  }
+
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  static auto balanceInsertion(TreeNode *root, TreeNode *x) noexcept
+      -> TreeNode * {
+    x->red = true;
+    for (;;) {
+      TreeNode *xp = x->parent;
+      TreeNode *xpp = nullptr;
+      if (xp == nullptr) {
+        x->red = false;
+        return x;
+      }
+      if (!xp->red || (xpp = xp->parent) == nullptr) {
+        return root;
+      }
+      TreeNode *xppl = xpp->left;
+      if (xp == xppl) {
+        TreeNode *xppr = xpp->right;
+        if (xppr != nullptr && xppr->red) {
+          xppr->red = false;
+          xp->red = false;
+          xpp->red = true;
+          x = xpp;
+        } else {
+          if (x == xp->right) {
+            x = xp;
+            root = rotateLeft(root, x);
+            xp = x->parent;
+            xpp = xp == nullptr ? nullptr : xp->parent;
+          }
+          if (xp != nullptr) {
+            xp->red = false;
+            if (xpp != nullptr) {
+              xpp->red = true;
+              root = rotateRight(root, xpp);
+            }
+          }
+        }
+      } else {
+        if (xppl != nullptr && xppl->red) {
+          xppl->red = false;
+          xp->red = false;
+          xpp->red = true;
+          x = xpp;
+        } else {
+          if (x == xp->left) {
+            x = xp;
+            root = rotateRight(root, x);
+            xp = x->parent;
+            xpp = xp == nullptr ? nullptr : xp->parent;
+          }
+          if (xp != nullptr) {
+            xp->red = false;
+            if (xpp != nullptr) {
+              xpp->red = true;
+              root = rotateLeft(root, xpp);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  static auto balanceDeletion(TreeNode *root, TreeNode *x) noexcept
+      -> TreeNode * {
+    for (;;) {
+      TreeNode *xp = nullptr;
+      if (x == nullptr || x == root) {
+        return root;
+      }
+      if ((xp = x->parent) == nullptr) {
+        x->red = false;
+        return x;
+      }
+      if (x->red) {
+        x->red = false;
+        return root;
+      }
+      TreeNode *xpl = xp->left;
+      if (xpl == x) {
+        TreeNode *xpr = xp->right;
+        if (xpr != nullptr && xpr->red) {
+          xpr->red = false;
+          xp->red = true;
+          root = rotateLeft(root, xp);
+          xp = x->parent;
+          xpr = xp == nullptr ? nullptr : xp->right;
+        }
+        if (xpr == nullptr) {
+          x = xp;
+        } else {
+          TreeNode *sl = xpr->left;
+          TreeNode *sr = xpr->right;
+          if ((sr == nullptr || !sr->red) && (sl == nullptr || !sl->red)) {
+            xpr->red = true;
+            x = xp;
+          } else {
+            if (sr == nullptr || !sr->red) {
+              if (sl != nullptr) {
+                sl->red = false;
+              }
+              xpr->red = true;
+              root = rotateRight(root, xpr);
+              xp = x->parent;
+              xpr = xp == nullptr ? nullptr : xp->right;
+            }
+            if (xpr != nullptr) {
+              xpr->red = xp != nullptr && xp->red;
+              if ((sr = xpr->right) != nullptr) {
+                sr->red = false;
+              }
+            }
+            if (xp != nullptr) {
+              xp->red = false;
+              root = rotateLeft(root, xp);
+            }
+            x = root;
+          }
+        }
+      } else {  // symmetric
+        if (xpl != nullptr && xpl->red) {
+          xpl->red = false;
+          xp->red = true;
+          root = rotateRight(root, xp);
+          xp = x->parent;
+          xpl = xp == nullptr ? nullptr : xp->left;
+        }
+        if (xpl == nullptr) {
+          x = xp;
+        } else {
+          TreeNode *sl = xpl->left;
+          TreeNode *sr = xpl->right;
+          if ((sl == nullptr || !sl->red) && (sr == nullptr || !sr->red)) {
+            xpl->red = true;
+            x = xp;
+          } else {
+            if (sl == nullptr || !sl->red) {
+              if (sr != nullptr) {
+                sr->red = false;
+              }
+              xpl->red = true;
+              root = rotateLeft(root, xpl);
+              xp = x->parent;
+              xpl = xp == nullptr ? nullptr : xp->left;
+            }
+            if (xpl != nullptr) {
+              xpl->red = xp != nullptr && xp->red;
+              if ((sl = xpl->left) != nullptr) {
+                sl->red = false;
+              }
+            }
+            if (xp != nullptr) {
+              xp->red = false;
+              root = rotateRight(root, xp);
+            }
+            x = root;
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Ensures that the given root is the first node of its bin and marks the
+   * bin as a tree bin.
+   */
+  static auto moveRootToFront(NodeTable &tab, TreeNode *root) noexcept
+      -> void {
+    std::size_t index = hashOf(root) & (tab.size() - 1);
+    auto *first = static_cast<TreeNode *>(binHead(tab[index]));
+    if (root != first) {
+      Node *rn = root->next;
+      TreeNode *rp = root->prev;
+      if (rn != nullptr) {
+        static_cast<TreeNode *>(rn)->prev = rp;
+      }
+      if (rp != nullptr) {
+        rp->next = rn;
+      }
+      if (first != nullptr) {
+        first->prev = root;
+      }
+      root->next = first;
+      root->prev = nullptr;
+    }
+    tab[index] = treeBin(root);
+  }
+
+  /**
+   * Forms a tree of the nodes linked from head.
+   */
+  static auto treeify(NodeTable &tab, TreeNode *head) noexcept
+      -> void {
+    TreeNode *root = nullptr;
+    for (TreeNode *x = head, *next = nullptr; x != nullptr; x = next) {
+      next = static_cast<TreeNode *>(x->next);
+      x->left = x->right = nullptr;
+      if (root == nullptr) {
+        x->parent = nullptr;
+        x->red = false;
+        root = x;
+        continue;
+      }
+      const K &k = x->key;
+      std::size_t h = hashOf(x);
+      for (TreeNode *p = root;;) {
+        int dir = 0;
+        std::size_t ph = hashOf(p);
+        if (ph > h) {
+          dir = -1;
+        } else if (ph < h) {
+          dir = 1;
+        } else if ((dir = compareKeys(k, p->key)) == 0) {
+          dir = tieBreakOrder(k, p->key);
+        }
+
+        TreeNode *xp = p;
+        if ((p = (dir <= 0) ? p->left : p->right) == nullptr) {
+          x->parent = xp;
+          if (dir <= 0) {
+            xp->left = x;
+          } else {
+            xp->right = x;
+          }
+          root = balanceInsertion(root, x);
+          break;
+        }
+      }
+    }
+    moveRootToFront(tab, root);
+  }
+
+  /**
+   * Slab allocator for Node. Nodes are carved out of large aligned slabs and
+   * recycled through an intrusive free list kept inside every slab, so a slab
+   * that no longer holds any node can be returned to the system allocator.
+   */
+  class ObjectPool {
+   private:
+    union Cell {
+      // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+      Cell *next;
+
+      // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes,modernize-avoid-c-arrays)
+      alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+
+    struct Slab {
+      // links of the list of slabs that still have free cells
+      Slab *prev = nullptr;
+      Slab *next = nullptr;
+
+      // cells given back by deallocate
+      Cell *freeList = nullptr;
+
+      // cells handed out and not given back yet
+      std::size_t live = 0;
+
+      // cells taken from the untouched tail of the slab so far
+      std::size_t carved = 0;
+
+      // position in slabs_
+      std::size_t index = 0;
+    };
+
+    constexpr static std::size_t CELL_OFFSET =
+        (sizeof(Slab) + alignof(Cell) - 1) / alignof(Cell) * alignof(Cell);
+
+    constexpr static std::size_t MIN_CELLS_PER_SLAB = 1 << 6;
+
+    constexpr static std::size_t DEFAULT_SLAB_SIZE = 1 << 16;  // aka 64 KiB
+
+    static constexpr auto slabSize() noexcept -> std::size_t {
+      std::size_t bytes = DEFAULT_SLAB_SIZE;
+      while (bytes < CELL_OFFSET + MIN_CELLS_PER_SLAB * sizeof(Cell)) {
+        bytes <<= 1;
+      }
+      return bytes;
+    }
+
+    constexpr static std::size_t SLAB_SIZE = slabSize();
+
+    constexpr static std::size_t CELLS_PER_SLAB =
+        (SLAB_SIZE - CELL_OFFSET) / sizeof(Cell);
+
+    /**
+     * With std::allocator slabs are aligned to their size, so the slab of a
+     * node is found by masking the low bits of its address. Other allocators
+     * may not honour such an alignment, or pad every slab to get it, so
+     * their slabs are only aligned for Slab and Cell and looked up in
+     * byAddress_ instead.
+     */
+    constexpr static bool ALIGNED_SLABS = is_std_allocator<Alloc>::value;
+
+    constexpr static std::size_t SLAB_ALIGN =
+        ALIGNED_SLABS ? SLAB_SIZE : std::max(alignof(Slab), alignof(Cell));
+
+    struct alignas(SLAB_ALIGN) SlabStorage {
+      // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes,modernize-avoid-c-arrays)
+      unsigned char bytes[SLAB_SIZE];
+    };
+
+    using SlabAllocator = Rebind<SlabStorage>;
+
+    using SlabTraits = std::allocator_traits<SlabAllocator>;
+
+    SlabAllocator allocator_;
+
+    std::vector<Slab *, Rebind<Slab *>> slabs_;
+
+    // slabs sorted by address, only kept without ALIGNED_SLABS
+    std::vector<Slab *, Rebind<Slab *>> byAddress_;
+
+    // slabs with at least one free cell, allocation takes from the head
+    Slab *available_ = nullptr;
+
+#if HASHMAP_TRACE
+    HashMapObserver *observer_ = nullptr;
+#endif
+
+    static inline auto addressLess(const void *a, const void *b) noexcept
+        -> bool {
+      return std::less<const void *>()(a, b);
+    }
+
+    inline auto slabOf(void *node) const noexcept -> Slab * {
+      if constexpr (ALIGNED_SLABS) {
+        return reinterpret_cast<Slab *>(
+            reinterpret_cast<std::uintptr_t>(node) & ~(SLAB_SIZE - 1));
+      } else {
+        // the last slab starting at or before node
+        return *(std::upper_bound(byAddress_.begin(), byAddress_.end(),
+                                  static_cast<const void *>(node),
+                                  addressLess) -
+                 1);
+      }
+    }
+
+    auto indexAddress(Slab *slab) -> void {
+      if constexpr (!ALIGNED_SLABS) {
+        byAddress_.insert(std::upper_bound(byAddress_.begin(),
+                                           byAddress_.end(),
+                                           static_cast<const void *>(slab),
+                                           addressLess),
+                          slab);
+      }
+    }
+
+    static inline auto cellAt(Slab *slab, std::size_t i) noexcept -> Cell * {
+      return reinterpret_cast<Cell *>(reinterpret_cast<unsigned char *>(slab) +
+                                      CELL_OFFSET) +
+             i;
+    }
+
+    auto linkAvailable(Slab *slab) noexcept -> void {
+      slab->prev = nullptr;
+      slab->next = available_;
+      if (available_ != nullptr) {
+        available_->prev = slab;
+      }
+      available_ = slab;
+    }
+
+    auto unlinkAvailable(Slab *slab) noexcept -> void {
+      if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+      } else {
+        available_ = slab->next;
+      }
+      if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+      }
+      slab->prev = slab->next = nullptr;
+    }
+
+    auto allocateSlab() noexcept -> void {
+      SlabStorage *storage = SlabTraits::allocate(allocator_, 1);
+      if (reinterpret_cast<std::uintptr_t>(storage) % SLAB_ALIGN != 0) {
+        // slabOf would find the wrong slab for every node of this one
+        std::fputs("HashMap: allocator ignored the alignment of a slab\n",
+                   stderr);
+        std::abort();
+      }
+      auto *slab = new (storage) Slab();
+      slab->index = slabs_.size();
+      slabs_.emplace_back(slab);
+      indexAddress(slab);
+      linkAvailable(slab);
+#if HASHMAP_TRACE
+      if (observer_ != nullptr) {
+        observer_->OnSlabAllocate(SLAB_SIZE);
+      }
+#endif
+    }
+
+    auto freeSlab(Slab *slab) noexcept -> void {
+      unlinkAvailable(slab);
+      slabs_.back()->index = slab->index;
+      slabs_[slab->index] = slabs_.back();
+      slabs_.pop_back();
+      if constexpr (!ALIGNED_SLABS) {
+        byAddress_.erase(std::lower_bound(byAddress_.begin(),
+                                          byAddress_.end(),
+                                          static_cast<const void *>(slab),
+                                          addressLess));
+      }
+      slab->~Slab();
+      SlabTraits::deallocate(allocator_, reinterpret_cast<SlabStorage *>(slab),
+                             1);
+    }
+
+   public:
+    explicit ObjectPool(const Alloc &alloc) noexcept
+        : allocator_(alloc), slabs_(alloc), byAddress_(alloc) {}
+
+    ObjectPool(const ObjectPool &) = delete;
+
+    auto operator=(const ObjectPool &) -> ObjectPool & = delete;
+
+    auto setObserver([[maybe_unused]] HashMapObserver *observer) noexcept
+        -> void {
+#if HASHMAP_TRACE
+      observer_ = observer;
+#endif
+    }
+
+    auto allocate() noexcept -> Node * {
+      if (available_ == nullptr) {
+        allocateSlab();
+      }
+
+      Slab *slab = available_;
+      Cell *cell = slab->freeList;
+      if (cell != nullptr) {
+        slab->freeList = cell->next;
+      } else {
+        cell = cellAt(slab, slab->carved++);
+      }
+
+      if (++slab->live == CELLS_PER_SLAB) {
+        unlinkAvailable(slab);
+      }
+      return reinterpret_cast<Node *>(cell->storage);
+    }
+
+    auto deallocate(Node *node) noexcept -> void {
+      node->~Node();
+      Slab *slab = slabOf(node);
+      auto *cell = reinterpret_cast<Cell *>(node);
+      cell->next = slab->freeList;
+      slab->freeList = cell;
+
+      if (slab->live-- == CELLS_PER_SLAB) {
+        linkAvailable(slab);
+      }
+
+      // keep the last slab with free cells around so that a Put right after
+      // a Del does not allocate a slab again
+      if (slab->live == 0 && (slab->prev != nullptr || slab->next != nullptr)) {
+        freeSlab(slab);
+      }
+    }
+
+    /**
+     * Takes over every slab of other, so that the nodes allocated from it
+     * can be freed through this pool. Both must use equal allocators. The
+     * slabs are reported to the observer of this pool as they come in.
+     */
+    auto merge(ObjectPool &other) -> void {
+      slabs_.reserve(slabs_.size() + other.slabs_.size());
+      for (Slab *slab : other.slabs_) {
+        slab->index = slabs_.size();
+        slabs_.emplace_back(slab);
+        indexAddress(slab);
+        if (slab->live < CELLS_PER_SLAB) {
+          linkAvailable(slab);
+        }
+#if HASHMAP_TRACE
+        if (observer_ != nullptr) {
+          observer_->OnSlabAllocate(SLAB_SIZE);
+        }
+#endif
+      }
+      other.slabs_.clear();
+      other.byAddress_.clear();
+      other.available_ = nullptr;
+    }
+
+    /**
+     * Bytes taken by the slabs, free cells included.
+     */
+    [[nodiscard]] auto bytes() const noexcept -> std::size_t {
+      return slabs_.size() * SLAB_SIZE +
+             (slabs_.capacity() + byAddress_.capacity()) * sizeof(Slab *);
+    }
+
+    [[nodiscard]] auto slabCount() const noexcept -> std::size_t {
+      return slabs_.size();
+    }
+
+    /**
+     * Cells of the slabs that hold no node.
+     */
+    [[nodiscard]] auto freeCells() const noexcept -> std::size_t {
+      std::size_t cells = 0;
+      for (const Slab *slab : slabs_) {
+        cells += CELLS_PER_SLAB - slab->live;
+      }
+      return cells;
+    }
+
+    ~ObjectPool() {
+      for (Slab *slab : slabs_) {
+        slab->~Slab();
+        SlabTraits::deallocate(allocator_,
+                               reinterpret_cast<SlabStorage *>(slab), 1);
+      }
+    }
+  };
+
+  ObjectPool objectPool_;
+
+  Hash hasher_;
+
+  KeyEqual keyEqual_;
+
+  using TreeNodeAllocator = Rebind<TreeNode>;
+
+  using TreeNodeTraits = std::allocator_traits<TreeNodeAllocator>;
+
+  TreeNodeAllocator treeNodeAllocator_;
+
+  std::size_t capacity_;
+
+  std::size_t threshold_;
+
+  NodeTable tables_;
+
+  // parallel to tables_ when TaggedBuckets, empty otherwise
+  TagTable tags_;
+
+  // the table being moved into tables_ by an incremental resize, empty when
+  // there is none. A bucket that has not been moved holds every entry whose
+  // hash maps to it, and buckets i and i + oldCap of tables_ are only
+  // initialized once bucket i has been moved
+  NodeTable oldTables_;
+
+  std::size_t migrateIndex_ = 0;
+
+  std::size_t size_ = 0;
+
+  float loadFactor;
+
+  // threads used by BulkLoad and resize() as set by SetParallelism, 0 for
+  // one per hardware thread, unset until SetParallelism is called
+  std::optional<std::size_t> parallelism_;
+
+#if HASHMAP_STATS
+  std::size_t resizes_ = 0;
+
+  std::chrono::nanoseconds resizeTime_{0};
+#endif
+
+#if HASHMAP_TRACE
+  HashMapObserver *observer_ = nullptr;
+
+  /**
+   * Nodes compared with the key by the operation running on this thread.
+   * Per thread rather than per map, as const lookups may run concurrently.
+   */
+  static inline auto probes() noexcept -> std::size_t & {
+    static thread_local std::size_t count = 0;
+    return count;
+  }
+#endif
+
+  /**
+   * Counts one node compared with the key for the HashMapObserver. Does
+   * nothing unless HASHMAP_TRACE.
+   */
+  static inline auto countProbe() noexcept -> void {
+#if HASHMAP_TRACE
+    ++probes();
+#endif
+  }
+
+  /**
+   * Counts one resize and adds the time until it is destroyed to
+   * resizeTime_, and reports it to the observer with the capacities before
+   * and after. Does nothing unless HASHMAP_STATS or HASHMAP_TRACE.
+   */
+  class ResizeTimer {
+   public:
+#if HASHMAP_STATS || HASHMAP_TRACE
+    explicit ResizeTimer(HashMap &map) noexcept
+        : map_(map),
+          oldCapacity_(map.capacity_),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ResizeTimer(const ResizeTimer &) = delete;
+
+    auto operator=(const ResizeTimer &) -> ResizeTimer & = delete;
+
+    ~ResizeTimer() {
+      std::chrono::nanoseconds duration =
+          std::chrono::steady_clock::now() - start_;
+#if HASHMAP_STATS
+      ++map_.resizes_;
+      map_.resizeTime_ += duration;
+#endif
+#if HASHMAP_TRACE
+      if (map_.observer_ != nullptr) {
+        map_.observer_->OnResize(oldCapacity_, map_.capacity_, duration);
+      }
+#endif
+    }
+
+   private:
+    HashMap &map_;
+
+    std::size_t oldCapacity_;
+
+    std::chrono::steady_clock::time_point start_;
+#else
+    explicit ResizeTimer(HashMap & /*unused*/) noexcept {}
+#endif
+  };
+
+  /**
+   * Reports the operation that runs until it is destroyed to the observer,
+   * with the probes it counted and its latency. The clock is only read when
+   * an observer is set. Does nothing unless HASHMAP_TRACE.
+   */
+  class OpTrace {
+   public:
+#if HASHMAP_TRACE
+    OpTrace(const HashMap &map, MapOp op) noexcept
+        : observer_(map.observer_), op_(op) {
+      probes() = 0;
+      if (observer_ != nullptr) {
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    OpTrace(const OpTrace &) = delete;
+
+    auto operator=(const OpTrace &) -> OpTrace & = delete;
+
+    ~OpTrace() {
+      if (observer_ != nullptr) {
+        observer_->OnOperation(op_, probes(),
+                               std::chrono::steady_clock::now() - start_);
+      }
+    }
+
+   private:
+    HashMapObserver *observer_;
+
+    MapOp op_;
+
+    std::chrono::steady_clock::time_point start_;
+#else
+    OpTrace(const HashMap & /*unused*/, MapOp /*unused*/) noexcept {}
+#endif
+  };
+
+  /**
+   * Value argument of insertVal standing for the value fn() returns, so that
+   * fn is only called once the key has been found absent.
+   */
+  template <typename Fn>
+  struct ValueFrom {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    Fn &fn;
+  };
+
+  template <typename KeyArg, typename... ValueArgs>
+  auto newTreeNode(std::size_t hash_code, Node *next, KeyArg &&keyArg,
+                   ValueArgs &&...valueArgs) -> TreeNode * {
+    TreeNode *p = TreeNodeTraits::allocate(treeNodeAllocator_, 1);
+    return new (p) TreeNode(hash_code, next, std::forward<KeyArg>(keyArg),
+                            std::forward<ValueArgs>(valueArgs)...);
+  }
+
+  template <typename KeyArg, typename Fn>
+  auto newTreeNode(std::size_t hash_code, Node *next, KeyArg &&keyArg,
+                   ValueFrom<Fn> value) -> TreeNode * {
+    // before allocating, so that nothing leaks if fn throws
+    V made(value.fn());
+    return newTreeNode(hash_code, next, std::forward<KeyArg>(keyArg),
+                       std::move(made));
+  }
+
+  template <typename KeyArg, typename... ValueArgs>
+  auto newNode(std::size_t hash_code, KeyArg &&keyArg,
+               ValueArgs &&...valueArgs) noexcept -> Node * {
+    return new (objectPool_.allocate())
+        Node(hash_code, nullptr, std::forward<KeyArg>(keyArg),
+             std::forward<ValueArgs>(valueArgs)...);
+  }
+
+  template <typename KeyArg, typename Fn>
+  auto newNode(std::size_t hash_code, KeyArg &&keyArg, ValueFrom<Fn> value)
+      -> Node * {
+    V made(value.fn());
+    return newNode(hash_code, std::forward<KeyArg>(keyArg), std::move(made));
+  }
+
+  auto deleteTreeNode(TreeNode *p) noexcept -> void {
+    p->~TreeNode();
+    TreeNodeTraits::deallocate(treeNodeAllocator_, p, 1);
+  }
+
+  /**
+   * Returns a list of plain nodes replacing the tree nodes linked from q.
+   */
+  auto untreeify(Node *q) noexcept -> Node * {
+    Node *hd = nullptr;
+    Node *tl = nullptr;
+    while (q != nullptr) {
+      Node *next = q->next;
+      Node *p = newNode(hashOf(q), q->key, std::move(q->value));
+      if (tl == nullptr) {
+        hd = p;
+      } else {
+        tl->next = p;
+      }
+      tl = p;
+      deleteTreeNode(static_cast<TreeNode *>(q));
+      q = next;
+    }
+    return hd;
+  }
+
+  /**
+   * Replaces all linked nodes in bin at index for given hash unless table is
+   * too small, in which case resizes instead.
+   */
+  auto treeifyBin(std::size_t index) noexcept -> void {
+    if (tables_.size() < MIN_TREEIFY_CAPACITY) {
+      resize();
+      return;
+    }
+
+    TreeNode *hd = nullptr;
+    TreeNode *tl = nullptr;
+    Node *e = tables_[index];
+    while (e != nullptr) {
+      Node *next = e->next;
+      TreeNode *p =
+          newTreeNode(hashOf(e), nullptr, e->key, std::move(e->value));
+      if (tl == nullptr) {
+        hd = p;
+      } else {
+        p->prev = tl;
+        tl->next = p;
+      }
+      tl = p;
+      objectPool_.deallocate(e);
+      e = next;
+    }
+
+    tables_[index] = hd;
+    if (hd != nullptr) {
+      treeify(tables_, hd);
+    }
+
+    if constexpr (TaggedBuckets) {
+      refreshTags(tags_[index], tables_[index]);
+    }
+  }
+
+  /**
+   * Tree version of insertVal, returns the existing node for k and false,
+   * or the node built from k and valueArgs and linked in and true.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  template <typename KeyArg, typename... ValueArgs>
+  auto putTreeVal(std::size_t index, std::size_t h, KeyArg &&k,
+                  ValueArgs &&...valueArgs) -> std::pair<TreeNode *, bool> {
+    bool searched = false;
+    TreeNode *root = static_cast<TreeNode *>(binHead(tables_[index]))->root();
+    for (TreeNode *p = root;;) {
+      countProbe();
+      int dir = 0;
+      std::size_t ph = hashOf(p);
+      if (ph > h) {
+        dir = -1;
+      } else if (ph < h) {
+        dir = 1;
+      } else if (keyEqual_(p->key, k)) {
+        return {p, false};
+      } else if ((dir = compareKeys(k, p->key)) == 0) {
+        if (!searched) {
+          TreeNode *q = nullptr;
+          searched = true;
+          if ((p->left != nullptr && (q = find(p->left, h, k)) != nullptr) ||
+              (p->right != nullptr && (q = find(p->right, h, k)) != nullptr)) {
+            return {q, false};
+          }
+        }
+        dir = tieBreakOrder(k, p->key);
+      }
+
+      TreeNode *xp = p;
+      if ((p = (dir <= 0) ? p->left : p->right) == nullptr) {
+        Node *xpn = xp->next;
+        TreeNode *x = newTreeNode(h, xpn, std::forward<KeyArg>(k),
+                                  std::forward<ValueArgs>(valueArgs)...);
+        if (dir <= 0) {
+          xp->left = x;
+        } else {
+          xp->right = x;
+        }
+        xp->next = x;
+        x->parent = x->prev = xp;
+        if (xpn != nullptr) {
+          static_cast<TreeNode *>(xpn)->prev = x;
+        }
+        moveRootToFront(tables_, balanceInsertion(root, x));
+        return {x, true};
+      }
+    }
+  }
+
+  auto removeTreeNode(TreeNode *p, bool movable = true) noexcept -> void {
+    removeTreeNode(tables_, p, movable);
+  }
+
+  /**
+   * Removes the given node, that must be present in its tree bin of tab,
+   * tables_ or the old table of an incremental resize. The node itself is
+   * not freed. If the tree has become too small it is converted back to a
+   * plain bin. Unless movable, the order of the remaining nodes along next
+   * is kept, which iterators rely on.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  auto removeTreeNode(NodeTable &tab, TreeNode *p, bool movable) noexcept
+      -> void {
+    std::size_t index = hashOf(p) & (tab.size() - 1);
+    auto *first = static_cast<TreeNode *>(binHead(tab[index]));
+    TreeNode *root = first;
+    auto *succ = static_cast<TreeNode *>(p->next);
+    TreeNode *pred = p->prev;
+    if (pred == nullptr) {
+      first = succ;
+      tab[index] = treeBin(first);
+    } else {
+      pred->next = succ;
+    }
+    if (succ != nullptr) {
+      succ->prev = pred;
+    }
+    if (first == nullptr) {
+      return;
+    }
+    if (root->parent != nullptr) {
+      root = root->root();
+    }
+    TreeNode *rl = nullptr;
+    if (root->right == nullptr || (rl = root->left) == nullptr ||
+        rl->left == nullptr) {
+      tab[index] = untreeify(first);  // too small
+      if constexpr (TaggedBuckets) {
+        // the old table has no tags
+        if (&tab == &tables_) {
+          refreshTags(tags_[index], tables_[index]);
+        }
+      }
+      return;
+    }
+
+    TreeNode *pl = p->left;
+    TreeNode *pr = p->right;
+    TreeNode *replacement = nullptr;
+    if (pl != nullptr && pr != nullptr) {
+      TreeNode *s = pr;
+      while (s->left != nullptr) {  // find successor
+        s = s->left;
+      }
+      std::swap(s->red, p->red);  // swap colors
+      TreeNode *sr = s->right;
+      TreeNode *pp = p->parent;
+      if (s == pr) {  // p was s's direct parent
+        p->parent = s;
+        s->right = p;
+      } else {
+        TreeNode *sp = s->parent;
+        if ((p->parent = sp) != nullptr) {
+          if (s == sp->left) {
+            sp->left = p;
+          } else {
+            sp->right = p;
+          }
+        }
+        if ((s->right = pr) != nullptr) {
+          pr->parent = s;
+        }
+      }
+      p->left = nullptr;
+      if ((p->right = sr) != nullptr) {
+        sr->parent = p;
+      }
+      if ((s->left = pl) != nullptr) {
+        pl->parent = s;
+      }
+      if ((s->parent = pp) == nullptr) {
+        root = s;
+      } else if (p == pp->left) {
+        pp->left = s;
+      } else {
+        pp->right = s;
+      }
+      replacement = sr != nullptr ? sr : p;
+    } else if (pl != nullptr) {
+      replacement = pl;
+    } else if (pr != nullptr) {
+      replacement = pr;
+    } else {
+      replacement = p;
+    }
+
+    if (replacement != p) {
+      TreeNode *pp = replacement->parent = p->parent;
+      if (pp == nullptr) {
+        root = replacement;
+        root->red = false;
+      } else if (p == pp->left) {
+        pp->left = replacement;
+      } else {
+        pp->right = replacement;
+      }
+      p->left = p->right = p->parent = nullptr;
+    }
+
+    TreeNode *r = p->red ? root : balanceDeletion(root, replacement);
+
+    if (replacement == p) {  // detach
+      TreeNode *pp = p->parent;
+      p->parent = nullptr;
+      if (pp != nullptr) {
+        if (p == pp->left) {
+          pp->left = nullptr;
+        } else if (p == pp->right) {
+          pp->right = nullptr;
+        }
+      }
+    }
+    if (movable) {
+      moveRootToFront(tab, r);
+    }
+  }
+
+  /**
+   * Splits nodes in a tree bin into lower and upper tree bins of newTable, or
+   * untreeifies if now too small. Called only from resize.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  auto split(NodeTable &newTable, TreeNode *b, std::size_t index,
+             std::size_t bit) noexcept -> void {
+    // Relink into lo and hi lists, preserving order
+    TreeNode *loHead = nullptr;
+    TreeNode *loTail = nullptr;
+    TreeNode *hiHead = nullptr;
+    TreeNode *hiTail = nullptr;
+    std::size_t lc = 0;
+    std::size_t hc = 0;
+    for (TreeNode *e = b, *next = nullptr; e != nullptr; e = next) {
+      next = static_cast<TreeNode *>(e->next);
+      e->next = nullptr;
+      if ((hashOf(e) & bit) == 0) {
+        if ((e->prev = loTail) == nullptr) {
+          loHead = e;
+        } else {
+          loTail->next = e;
+        }
+        loTail = e;
+        ++lc;
+      } else {
+        if ((e->prev = hiTail) == nullptr) {
+          hiHead = e;
+        } else {
+          hiTail->next = e;
+        }
+        hiTail = e;
+        ++hc;
+      }
+    }
+
+    if (loHead != nullptr) {
+      if (lc <= UNTREEIFY_THRESHOLD) {
+        newTable[index] = untreeify(loHead);
+      } else {
+        newTable[index] = treeBin(loHead);
+        if (hiHead != nullptr) {  // (else is already treeified)
+          treeify(newTable, loHead);
+        }
+      }
+    }
+
+    if (hiHead != nullptr) {
+      if (hc <= UNTREEIFY_THRESHOLD) {
+        newTable[index + bit] = untreeify(hiHead);
+      } else {
+        newTable[index + bit] = treeBin(hiHead);
+        if (loHead != nullptr) {
+          treeify(newTable, hiHead);
+        }
+      }
+    }
+  }
+
+  /**
+   * Looks key up in a single bin, without tags.
+   */
+  template <typename Q>
+  auto findInBin(Node *bin, std::size_t hashCode, const Q &key) const noexcept
+      -> Node * {
+    if (isTreeBin(bin)) {
+      return find(static_cast<TreeNode *>(binHead(bin))->root(), hashCode,
+                  key);
+    }
+    for (Node *node = bin; node != nullptr; node = node->next) {
+      if (matches(node, hashCode, key)) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Marks a bucket of the old table that has been moved into tables_.
+   */
+  static inline auto movedBin() noexcept -> Node * {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+    return reinterpret_cast<Node *>(MOVED_BIN);
+  }
+
+  /**
+   * Whether the entries that hashCode maps to are still in the old table of
+   * a running incremental resize.
+   */
+  auto inOldTable(std::size_t hashCode) const noexcept -> bool {
+    if constexpr (IncrementalResize) {
+      return !oldTables_.empty() &&
+             oldTables_[hashCode & (oldTables_.size() - 1)] != movedBin();
+    }
+    return false;
+  }
+
+  /**
+   * Calls fn with every bucket that may hold entries. While an incremental
+   * resize runs, a bucket of the old table that has been moved is replaced
+   * by the two buckets of tables_ it was split into. If fn returns bool,
+   * false stops the walk.
+   */
+  template <typename Fn>
+  auto forEachBin(Fn &&fn) const -> void {
+    auto visit = [&fn](Node *bin) -> bool {
+      if constexpr (std::is_same_v<std::invoke_result_t<Fn &, Node *>, bool>) {
+        return fn(bin);
+      } else {
+        fn(bin);
+        return true;
+      }
+    };
+    if (oldTables_.empty()) {
+      for (Node *bin : tables_) {
+        if (!visit(bin)) {
+          return;
+        }
+      }
+      return;
+    }
+    std::size_t oldCap = oldTables_.size();
+    for (std::size_t i = 0; i < oldCap; i++) {
+      if (oldTables_[i] == movedBin()) {
+        if (!visit(tables_[i]) || !visit(tables_[i + oldCap])) {
+          return;
+        }
+      } else if (!visit(oldTables_[i])) {
+        return;
+      }
+    }
+  }
+
+  template <typename Q>
+  auto getNode(std::size_t hashCode, const Q &key) const noexcept -> Node * {
+    if (inOldTable(hashCode)) {
+      return findInBin(oldTables_[hashCode & (oldTables_.size() - 1)],
+                       hashCode, key);
+    }
+
+    Node *first = tables_[hashCode & (capacity_ - 1)];
+
+    if (isTreeBin(first)) {
+      return find(static_cast<TreeNode *>(binHead(first))->root(), hashCode,
+                  key);
+    }
+
+    if constexpr (TaggedBuckets) {
+      const BucketTags &bucket = tags_[hashCode & (capacity_ - 1)];
+      Node *node = first;
+      std::size_t pos = 0;
+      // only chain positions whose tag matches get their key compared
+      for (std::uint32_t mask = matchTags(bucket, tagOf(hashCode)); mask != 0;
+           mask &= mask - 1) {
+        auto target = static_cast<std::size_t>(__builtin_ctz(mask));
+        for (; pos < target; ++pos) {
+          node = node->next;
+        }
+        if (matches(node, hashCode, key)) {
+          return node;
+        }
+      }
+      if (!tagsOverflow(bucket)) {
+        return nullptr;
+      }
+      for (; pos < BUCKET_TAG_WIDTH; ++pos) {
         node = node->next;
       }
+      first = node;
+    }
+
+    for (Node *node = first; node != nullptr; node = node->next) {
+      if (matches(node, hashCode, key)) {
+        return node;
+      }
+    }
+
+    return nullptr;
+  }
+
+  /**
+   * Starts loading the bucket slot (and tags) that hashCode maps to.
+   */
+  auto prefetchBucket(std::size_t hashCode) const noexcept -> void {
+    if constexpr (IncrementalResize) {
+      if (!oldTables_.empty()) {
+        __builtin_prefetch(&oldTables_[hashCode & (oldTables_.size() - 1)]);
+      }
+    }
+    __builtin_prefetch(&tables_[hashCode & (capacity_ - 1)]);
+    if constexpr (TaggedBuckets) {
+      __builtin_prefetch(&tags_[hashCode & (capacity_ - 1)]);
+    }
+  }
+
+  /**
+   * Starts loading the first node of the bin that hashCode maps to, its slot
+   * should already be in the cache.
+   */
+  auto prefetchBin(std::size_t hashCode) const noexcept -> void {
+    Node *bin = inOldTable(hashCode)
+                    ? oldTables_[hashCode & (oldTables_.size() - 1)]
+                    : tables_[hashCode & (capacity_ - 1)];
+    if (bin != nullptr) {
+      __builtin_prefetch(binHead(bin));
+    }
+  }
+
+  /**
+   * Looks up keys[0, count) in groups of PREFETCH_GROUP and calls
+   * fn(i, node) for each of them. The bucket slots of a whole group are
+   * prefetched, then their first nodes, and only then are the chains walked,
+   * so the misses of a group overlap instead of being paid one by one.
+   */
+  template <typename Q, typename Fn>
+  auto lookupMany(const Q *keys, std::size_t count, Fn &&fn) const noexcept
+      -> void {
+    std::array<std::size_t, PREFETCH_GROUP> hashCodes{};
+    for (std::size_t base = 0; base < count; base += PREFETCH_GROUP) {
+      std::size_t n = std::min(PREFETCH_GROUP, count - base);
+      for (std::size_t i = 0; i < n; i++) {
+        hashCodes[i] = hash(keys[base + i]);
+        prefetchBucket(hashCodes[i]);
+      }
+      for (std::size_t i = 0; i < n; i++) {
+        prefetchBin(hashCodes[i]);
+      }
+      for (std::size_t i = 0; i < n; i++) {
+        fn(base + i, getNode(hashCodes[i], keys[base + i]));
+      }
+    }
+  }
+
+  template <typename Q>
+  auto removeNode(std::size_t hashCode, const Q &key) noexcept -> bool {
+    rehashStep();
+    if (inOldTable(hashCode)) {
+      std::size_t i = hashCode & (oldTables_.size() - 1);
+      if (findInBin(oldTables_[i], hashCode, key) == nullptr) {
+        return false;
+      }
+      migrateBin(i);
+    }
+
+    if (isTreeBin(tables_[hashCode & (capacity_ - 1)])) {
+      auto *node = static_cast<TreeNode *>(getNode(hashCode, key));
+      if (node == nullptr) {
+        return false;
+      }
+      removeTreeNode(node);
+      deleteTreeNode(node);
+      size_--;
+      return true;
+    }
+
+    if constexpr (TaggedBuckets) {
+      // a miss is answered from the tags without touching the chain
+      const BucketTags &bucket = tags_[hashCode & (capacity_ - 1)];
+      if (matchTags(bucket, tagOf(hashCode)) == 0 && !tagsOverflow(bucket)) {
+        return false;
+      }
+    }
+
+    Node *prev = nullptr;
+    Node *curr = tables_[hashCode & (capacity_ - 1)];
+    std::size_t pos = 0;
+    while (curr != nullptr) {
+      if (matches(curr, hashCode, key)) {
+        unlinkNode(tables_, hashCode & (capacity_ - 1), prev, curr, pos);
+        return true;
+      }
+      prev = curr;
+      curr = curr->next;
+      ++pos;
+    }
+    return false;
+  }
+
+  /**
+   * Unlinks node, found at position pos of the chain of bucket index of tab
+   * right after prev, and frees it.
+   */
+  auto unlinkNode(NodeTable &tab, std::size_t index, Node *prev, Node *node,
+                  std::size_t pos) noexcept -> void {
+    if (prev == nullptr) {
+      tab[index] = node->next;
+    } else {
+      // prev -> node -> next
+      prev->next = node->next;
+    }
+
+    if constexpr (TaggedBuckets) {
+      // the old table has no tags
+      if (&tab == &tables_) {
+        BucketTags &bucket = tags_[index];
+        if (tagsOverflow(bucket)) {
+          refreshTags(bucket, tables_[index]);
+        } else {
+          std::memmove(bucket.tag + pos, bucket.tag + pos + 1,
+                       BUCKET_TAG_WIDTH - 1 - pos);
+          bucket.tag[BUCKET_TAG_WIDTH - 1] = EMPTY_TAG;
+        }
+      }
+    }
+
+    objectPool_.deallocate(node);
+    size_--;
+  }
+
+
+  /**
+   * removeNode for a node of hashCode that the caller has just looked up in
+   * tables_: keys are not compared again, a tree node is unlinked directly
+   * and a chain is only followed to the node before it.
+   */
+  auto removeFoundNode(std::size_t hashCode, Node *node) noexcept -> void {
+    std::size_t index = hashCode & (capacity_ - 1);
+    if (isTreeBin(tables_[index])) {
+      removeTreeNode(static_cast<TreeNode *>(node));
+      deleteTreeNode(static_cast<TreeNode *>(node));
+      size_--;
+      return;
+    }
+    Node *prev = nullptr;
+    std::size_t pos = 0;
+    for (Node *e = tables_[index]; e != node; e = e->next) {
+      prev = e;
+      ++pos;
+    }
+    unlinkNode(tables_, index, prev, node, pos);
+  }
+
+  /**
+   * Moves the bucket of hashCode out of the old table of a running
+   * incremental resize, so that a node looked up afterwards can be handed
+   * to removeFoundNode.
+   */
+  auto migrateBinOf(std::size_t hashCode) noexcept -> void {
+    if (inOldTable(hashCode)) {
+      migrateBin(hashCode & (oldTables_.size() - 1));
+    }
+  }
+
+  /**
+   * Returns the existing node for key, or links in a new node built from key
+   * and valueArgs and returns nullptr. A single ValueFrom stands for the
+   * value its fn returns. Nothing is moved from the arguments
+   * unless the node is built, so callers may still use them on a hit.
+   */
+  template <typename KeyArg, typename... ValueArgs>
+  auto putVal(std::size_t hashCode, KeyArg &&key, ValueArgs &&...valueArgs)
+      -> Node * {
+    auto [node, inserted] =
+        insertVal(hashCode, std::forward<KeyArg>(key),
+                  std::forward<ValueArgs>(valueArgs)...);
+    return inserted ? nullptr : node;
+  }
+
+  /**
+   * putVal that also hands out the new node: returns the existing node for
+   * key and false, or the new node and true. The new node is nullptr when
+   * the treeify or resize that followed it may have replaced it, which is
+   * rare enough for callers to look it up again.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  template <typename KeyArg, typename... ValueArgs>
+  auto insertVal(std::size_t hashCode, KeyArg &&key, ValueArgs &&...valueArgs)
+      -> std::pair<Node *, bool> {
+    // before the lookup, so that the node returned is not moved afterwards
+    rehashStep();
+    if (inOldTable(hashCode)) {
+      // a hit is answered from the old table, the bucket only moves if the
+      // key has to be added to it
+      std::size_t i = hashCode & (oldTables_.size() - 1);
+      if (Node *node = findInBin(oldTables_[i], hashCode, key);
+          node != nullptr) {
+        return {node, false};
+      }
+      migrateBin(i);
+    }
+
+    std::size_t index = hashCode & (capacity_ - 1);
+
+    if (tables_[index] == nullptr) {
+      Node *node = newNode(hashCode, std::forward<KeyArg>(key),
+                           std::forward<ValueArgs>(valueArgs)...);
+      tables_[index] = node;
+
+      if constexpr (TaggedBuckets) {
+        tags_[index].tag[0] = tagOf(hashCode);
+      }
+
+      return {grow() ? nullptr : node, true};
+    }
+
+    if (isTreeBin(tables_[index])) {
+      auto [node, inserted] =
+          putTreeVal(index, hashCode, std::forward<KeyArg>(key),
+                     std::forward<ValueArgs>(valueArgs)...);
+      if (inserted && grow()) {
+        return {nullptr, true};
+      }
+      return {node, inserted};
+    }
+
+    // tables_[index] != nullptr
+    Node *node = tables_[index];
+    std::size_t binCount = 0;
+    while (node->next != nullptr) {
+      if (matches(node, hashCode, key)) {
+        return {node, false};
+      }
+      node = node->next;
+      ++binCount;
+    }
+
+    // node -> next
+    if (matches(node, hashCode, key)) {
+      return {node, false};
+    }
+
+    Node *added = newNode(hashCode, std::forward<KeyArg>(key),
+                          std::forward<ValueArgs>(valueArgs)...);
+    node->next = added;
+
+    if constexpr (TaggedBuckets) {
+      if (binCount + 1 < BUCKET_TAG_WIDTH) {
+        tags_[index].tag[binCount + 1] = tagOf(hashCode);
+      }
+    }
+
+    if (binCount >= TREEIFY_THRESHOLD - 1) {
+      // the nodes of the bin are rebuilt as tree nodes
+      treeifyBin(index);
+      added = nullptr;
+    }
+
+    return {grow() ? nullptr : added, true};
+  }
+
+  /**
+   * Counts an inserted node, resizing if the threshold has been passed.
+   * Returns whether the table was resized.
+   */
+  auto grow() noexcept -> bool {
+    if (++size_ > threshold_) {
+      resize();
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Number of threads to split work items among, at least PARALLEL_MIN_WORK
+   * items each. Without SetParallelism, one per hardware thread if
+   * byDefault, otherwise only the calling thread.
+   */
+  auto threadsFor(std::size_t work, bool byDefault) const noexcept
+      -> std::size_t {
+    std::size_t threads = 1;
+    if (parallelism_.has_value()) {
+      threads = *parallelism_ != 0 ? *parallelism_
+                                   : std::thread::hardware_concurrency();
+    } else if (byDefault) {
+      threads = std::thread::hardware_concurrency();
+    }
+    threads = std::min(threads, work / PARALLEL_MIN_WORK);
+    return std::max<std::size_t>(1, threads);
+  }
+
+  /**
+   * Calls fn(t) for every t below threads, on new threads and the calling
+   * one. If a thread cannot be started its share runs on the calling thread.
+   */
+  template <typename Fn>
+  static auto runParallel(std::size_t threads, Fn &fn) noexcept -> void {
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < threads; t++) {
+      try {
+        workers.emplace_back([&fn, t] { fn(t); });
+      } catch (const std::system_error &) {
+        fn(t);
+      } catch (const std::bad_alloc &) {
+        fn(t);
+      }
+    }
+    fn(0);
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  /**
+   * putVal for BulkLoad: inserts or assigns without treeifying or resizing,
+   * taking new nodes from pool. Touches bin index of tables_ only, so
+   * threads working on different bins do not interfere. Appends index to
+   * longBins when its chain grows past TREEIFY_THRESHOLD, and returns
+   * whether a node was inserted.
+   */
+  template <typename KeyArg, typename ValueArg>
+  auto bulkPut(ObjectPool &pool, std::size_t hashCode, KeyArg &&key,
+               ValueArg &&value, std::vector<std::size_t> &longBins) -> bool {
+    std::size_t index = hashCode & (capacity_ - 1);
+    Node *first = tables_[index];
+
+    if (isTreeBin(first)) {
+      // tree nodes come from treeNodeAllocator_, so this only runs on the
+      // calling thread
+      if (TreeNode *node =
+              find(static_cast<TreeNode *>(binHead(first))->root(), hashCode,
+                   key);
+          node != nullptr) {
+        node->value = std::forward<ValueArg>(value);
+        return false;
+      }
+      putTreeVal(index, hashCode, std::forward<KeyArg>(key),
+                 std::forward<ValueArg>(value));
+      return true;
+    }
+
+    Node **link = &tables_[index];
+    std::size_t binCount = 0;
+    for (Node *node = first; node != nullptr; node = node->next) {
+      if (matches(node, hashCode, key)) {
+        node->value = std::forward<ValueArg>(value);
+        return false;
+      }
+      link = &node->next;
+      ++binCount;
+    }
+
+    *link = new (pool.allocate()) Node(hashCode, nullptr,
+                                       std::forward<KeyArg>(key),
+                                       std::forward<ValueArg>(value));
+    if constexpr (TaggedBuckets) {
+      if (binCount < BUCKET_TAG_WIDTH) {
+        tags_[index].tag[binCount] = tagOf(hashCode);
+      }
+    }
+    if (binCount == TREEIFY_THRESHOLD) {
+      longBins.push_back(index);
+    }
+    return true;
+  }
+
+  /**
+   * BulkLoad for random access ranges large enough to be split among
+   * threads. Hash codes are computed in parallel, the entries are grouped
+   * by the range of buckets they fall into while keeping their order, and
+   * every thread then links the entries of its own bucket range. Entries
+   * for bins that already are trees are put on the calling thread after,
+   * which keeps their order as a bin belongs to a single range.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  template <typename RandomIt>
+  auto bulkLoadParallel(RandomIt first, std::size_t n, std::size_t threads)
+      -> void {
+    std::vector<std::size_t> hashes(n);
+    // counts[t * threads + p]: entries of slice t that fall into part p
+    std::vector<std::size_t> counts(threads * threads, 0);
+    std::size_t span = (capacity_ + threads - 1) / threads;
+
+    auto hashSlice = [&](std::size_t t) {
+      std::size_t *count = &counts[t * threads];
+      for (std::size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+        hashes[i] = hash(first[i].first);
+        ++count[(hashes[i] & (capacity_ - 1)) / span];
+      }
+    };
+    runParallel(threads, hashSlice);
+
+    // offsets[t * threads + p]: where slice t starts writing part p, parts
+    // are laid out one after the other and slices in order inside a part
+    std::vector<std::size_t> offsets(threads * threads);
+    std::vector<std::size_t> partEnd(threads);
+    std::size_t offset = 0;
+    for (std::size_t p = 0; p < threads; p++) {
+      for (std::size_t t = 0; t < threads; t++) {
+        offsets[t * threads + p] = offset;
+        offset += counts[t * threads + p];
+      }
+      partEnd[p] = offset;
+    }
+
+    std::vector<std::size_t> order(n);
+    auto scatterSlice = [&](std::size_t t) {
+      std::size_t *next = &offsets[t * threads];
+      for (std::size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+        order[next[(hashes[i] & (capacity_ - 1)) / span]++] = i;
+      }
+    };
+    runParallel(threads, scatterSlice);
+
+    // nodes come from one pool per thread, merged into objectPool_ after
+    Alloc alloc(treeNodeAllocator_);
+    std::vector<std::unique_ptr<ObjectPool>> pools;
+    for (std::size_t p = 0; p < threads; p++) {
+      pools.emplace_back(std::make_unique<ObjectPool>(alloc));
+    }
+    std::vector<std::vector<std::size_t>> longBins(threads);
+    std::vector<std::vector<std::size_t>> treeEntries(threads);
+    std::vector<std::size_t> inserted(threads, 0);
+
+    auto linkPart = [&](std::size_t p) {
+      for (std::size_t k = p == 0 ? 0 : partEnd[p - 1]; k < partEnd[p]; k++) {
+        std::size_t i = order[k];
+        if (isTreeBin(tables_[hashes[i] & (capacity_ - 1)])) {
+          treeEntries[p].push_back(i);
+          continue;
+        }
+        const auto &entry = first[i];
+        if (bulkPut(*pools[p], hashes[i], entry.first, entry.second,
+                    longBins[p])) {
+          ++inserted[p];
+        }
+      }
+    };
+    runParallel(threads, linkPart);
+
+    for (std::size_t p = 0; p < threads; p++) {
+      objectPool_.merge(*pools[p]);
+      size_ += inserted[p];
+      for (std::size_t i : treeEntries[p]) {
+        const auto &entry = first[i];
+        if (bulkPut(objectPool_, hashes[i], entry.first, entry.second,
+                    longBins[p])) {
+          ++size_;
+        }
+      }
+      for (std::size_t index : longBins[p]) {
+        treeifyBin(index);
+      }
+    }
+  }
+
+  /**
+   * Returns a power of two size for the given target capacity.
+   */
+  static auto tableSizeFor(std::size_t cap) noexcept -> std::size_t {
+    if (cap <= 1) {
+      return 1;
+    }
+    if (cap >= MAXIMUM_CAPACITY) {
+      return MAXIMUM_CAPACITY;
+    }
+    std::size_t n = cap - 1;
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    n |= n >> 8;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    n |= n >> 16;
+    return n + 1;
+  }
+
+  /**
+   * The size at which a table of cap buckets is resized.
+   */
+  auto thresholdFor(std::size_t cap) const noexcept -> std::size_t {
+    float ft = static_cast<float>(cap) * loadFactor;
+    return cap < MAXIMUM_CAPACITY && ft < static_cast<float>(MAXIMUM_CAPACITY)
+               ? static_cast<std::size_t>(ft)
+               : std::numeric_limits<std::size_t>::max();
+  }
+
+  /**
+   * The table size needed to hold n entries without a resize.
+   */
+  auto capacityFor(std::size_t n) const noexcept -> std::size_t {
+    float ft = static_cast<float>(n) / loadFactor + 1.0F;
+    return ft < static_cast<float>(MAXIMUM_CAPACITY)
+               ? tableSizeFor(static_cast<std::size_t>(ft))
+               : MAXIMUM_CAPACITY;
+  }
+
+  /**
+   * Moves every node into a new table of newCap buckets, which may be
+   * smaller than the current one. Unlike resize() bins cannot be split in
+   * place, so tree bins are flattened first and rebuilt where their nodes
+   * end up.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  auto rehashTo(std::size_t newCap) noexcept -> void {
+    finishRehash();
+    ResizeTimer timer(*this);
+    NodeTable newTable(newCap, nullptr, tables_.get_allocator());
+    for (Node *bin : tables_) {
+      Node *e = isTreeBin(bin) ? untreeify(binHead(bin)) : bin;
+      while (e != nullptr) {
+        Node *next = e->next;
+        Node *&head = newTable[hashOf(e) & (newCap - 1)];
+        e->next = head;
+        head = e;
+        e = next;
+      }
+    }
+
+    capacity_ = newCap;
+    threshold_ = thresholdFor(newCap);
+    tables_ = std::move(newTable);
+    tags_ = TagTable(TaggedBuckets ? newCap : 0, BucketTags{},
+                     tags_.get_allocator());
+
+    for (std::size_t i = 0; i < newCap; i++) {
+      std::size_t binCount = 0;
+      for (Node *e = tables_[i]; e != nullptr; e = e->next) {
+        ++binCount;
+      }
+      if (binCount > TREEIFY_THRESHOLD && newCap >= MIN_TREEIFY_CAPACITY) {
+        treeifyBin(i);
+      } else if constexpr (TaggedBuckets) {
+        refreshTags(tags_[i], tables_[i]);
+      }
+    }
+  }
+
+  /**
+   * Moves the nodes of bin e, bucket i of a table of oldCap buckets, into
+   * buckets i and i + oldCap of newTable, keeping their order.
+   */
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  auto transferBin(Node *e, std::size_t i, std::size_t oldCap,
+                   NodeTable &newTable, TagTable &newTags) noexcept -> void {
+    if (isTreeBin(e)) {
+      split(newTable, static_cast<TreeNode *>(binHead(e)), i, oldCap);
+    } else if (e->next == nullptr) {
+      // table -> e -> nullptr
+      newTable[hashOf(e) & ((oldCap << 1) - 1)] = e;
+    } else {
+      // table -> e1 -> e2 -> ...
+      Node *loHead = nullptr;
+      Node *loTail = nullptr;
+
+      Node *hiHead = nullptr;
+      Node *hiTail = nullptr;
+
+      Node *next = nullptr;
+
+      do {
+        next = e->next;
+
+        if ((hashOf(e) & oldCap) == 0) {
+          // no need to move(because the bit length <= oldCap)
+          if (loTail == nullptr) {
+            loHead = e;
+          } else {
+            loTail->next = e;
+          }
+          loTail = e;
+        } else {
+          // need to move
+          if (hiTail == nullptr) {
+            hiHead = e;
+          } else {
+            hiTail->next = e;
+          }
+          hiTail = e;
+        }
+
+      } while ((e = next) != nullptr);
+
+      if (loTail != nullptr) {
+        loTail->next = nullptr;
+        newTable[i] = loHead;
+      }
+
+      if (hiTail != nullptr) {
+        hiTail->next = nullptr;
+        newTable[i + oldCap] = hiHead;
+      }
+    }
+
+    if constexpr (TaggedBuckets) {
+      // the nodes were just visited, so this stays in cache
+      refreshTags(newTags[i], newTable[i]);
+      refreshTags(newTags[i + oldCap], newTable[i + oldCap]);
+    }
+  }
+
+  /**
+   * Moves bucket i of the old table into tables_.
+   */
+  auto migrateBin(std::size_t i) noexcept -> void {
+    Node *e = oldTables_[i];
+    if (e == movedBin()) {
+      return;
+    }
+    std::size_t oldCap = oldTables_.size();
+    oldTables_[i] = movedBin();
+    tables_[i] = nullptr;
+    tables_[i + oldCap] = nullptr;
+    if constexpr (TaggedBuckets) {
+      tags_[i] = BucketTags{};
+      tags_[i + oldCap] = BucketTags{};
+    }
+    if (e != nullptr) {
+      transferBin(e, i, oldCap, tables_, tags_);
+    }
+  }
+
+  /**
+   * Moves the next few buckets of a running incremental resize, and drops
+   * the old table once it is empty.
+   */
+  auto rehashStep() noexcept -> void {
+    if constexpr (IncrementalResize) {
+      if (oldTables_.empty()) {
+        return;
+      }
+      std::size_t end = std::min(migrateIndex_ + INCREMENTAL_RESIZE_BUCKETS,
+                                 oldTables_.size());
+      for (; migrateIndex_ < end; ++migrateIndex_) {
+        migrateBin(migrateIndex_);
+      }
+      if (migrateIndex_ == oldTables_.size()) {
+        oldTables_ = NodeTable(oldTables_.get_allocator());
+        migrateIndex_ = 0;
+      }
+    }
+  }
+
+  /**
+   * Moves everything left in the old table, so that all entries are in
+   * tables_ afterwards.
+   */
+  auto finishRehash() noexcept -> void {
+    if constexpr (IncrementalResize) {
+      while (!oldTables_.empty()) {
+        rehashStep();
+      }
+    }
+  }
+
+  /**
+   * Appends value to out the way operator<< prints it. Numbers go through
+   * std::to_chars and strings are copied, only other types are printed
+   * into stream, which is reused for every one of them.
+   */
+  template <typename T>
+  static auto formatTo(std::string &out, const T &value,
+                       std::ostringstream &stream) -> void {
+    if constexpr (std::is_arithmetic_v<T> && !is_character<T>::value) {
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      std::array<char, 64> chars{};
+      std::to_chars_result result{};
+      if constexpr (std::is_same_v<T, bool>) {
+        result = std::to_chars(chars.data(), chars.data() + chars.size(),
+                               static_cast<int>(value));
+      } else if constexpr (std::is_floating_point_v<T>) {
+        // the default precision of operator<<
+        result = std::to_chars(chars.data(), chars.data() + chars.size(),
+                               value, std::chars_format::general,
+                               FORMAT_FLOAT_PRECISION);
+      } else {
+        result =
+            std::to_chars(chars.data(), chars.data() + chars.size(), value);
+      }
+      out.append(chars.data(), result.ptr);
+    } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+      out.append(std::string_view(value));
+    } else {
+      static_assert(is_streamable<T>::value, "type must impl operator << ");
+      stream.str(std::string());
+      stream << value;
+      out.append(stream.str());
+    }
+  }
+
+  /**
+   * Prints the map into out as {key=value,...}, handing out to flush
+   * whenever it reaches DUMP_BUFFER_BYTES. Only every every-th entry is
+   * printed, and at most limit of them; "..." marks that some were left
+   * out.
+   */
+  template <typename Flush>
+  auto formatEntries(std::string &out, std::size_t limit, std::size_t every,
+                     Flush &&flush) const -> void {
+    every = std::max<std::size_t>(every, 1);
+    std::ostringstream stream;
+    std::size_t seen = 0;
+    std::size_t printed = 0;
+    bool skipped = false;
+    out.push_back('{');
+    forEachBin([&](Node *bin) -> bool {
+      for (const Node *node = binHead(bin); node != nullptr;
+           node = node->next) {
+        if (seen++ % every != 0) {
+          continue;
+        }
+        if (printed == limit) {
+          skipped = true;
+          break;
+        }
+        if (printed++ != 0) {
+          out.push_back(',');
+        }
+        formatTo(out, node->key, stream);
+        out.push_back('=');
+        formatTo(out, node->value, stream);
+        if (out.size() >= DUMP_BUFFER_BYTES) {
+          flush(out);
+        }
+      }
+      return !skipped;
+    });
+    if (skipped || (every > 1 && size_ > printed)) {
+      out.append(printed != 0 ? ",..." : "...");
+    }
+    out.push_back('}');
+  }
+
+  auto resize() noexcept -> void {
+    // only one resize can run at a time
+    finishRehash();
+
+    std::size_t oldCap = tables_.size();
+    std::size_t oldThr = threshold_;
+    std::size_t newCap = 0;
+    std::size_t newThr = 0;
+
+    if (oldCap >= MAXIMUM_CAPACITY) {
+      threshold_ = std::numeric_limits<std::size_t>::max();
+      return;
+    }
+
+    ResizeTimer timer(*this);
+
+    if ((newCap = (oldCap << 1)) < MAXIMUM_CAPACITY &&
+        oldCap >= DEFAULT_INITIAL_CAPACITY) {
+      newThr = oldThr << 1;
+    }
+
+    if (newThr == 0) {
+      newThr = thresholdFor(newCap);
+    }
+
+    capacity_ = newCap;
+    threshold_ = newThr;
+
+    if constexpr (IncrementalResize) {
+      // the new buckets are left unwritten until their old bucket moves, so
+      // starting the resize does not touch the whole new table. The old tags
+      // are dropped, lookups in the old table walk the chains
+      oldTables_ = std::move(tables_);
+      migrateIndex_ = 0;
+      tables_ = NodeTable(newCap, oldTables_.get_allocator());
+      tags_ = TagTable(TaggedBuckets ? newCap : 0, tags_.get_allocator());
+    } else {
+      NodeTable newTable(newCap, nullptr, tables_.get_allocator());
+      TagTable newTags(TaggedBuckets ? newCap : 0, BucketTags{},
+                       tags_.get_allocator());
+      // move data. Every list bin only writes its own two buckets of
+      // newTable, so ranges of bins can move on different threads. Tree
+      // bins allocate while they split and are moved afterwards.
+      std::size_t threads = threadsFor(oldCap, false);
+      std::vector<std::vector<std::size_t>> treeBins(threads);
+      auto moveRange = [&](std::size_t t) {
+        for (std::size_t i = oldCap * t / threads;
+             i < oldCap * (t + 1) / threads; i++) {
+          Node *e = tables_[i];
+          if (isTreeBin(e)) {
+            treeBins[t].push_back(i);
+          } else if (e != nullptr) {
+            transferBin(e, i, oldCap, newTable, newTags);
+          }
+        }
+      };
+      runParallel(threads, moveRange);
+      for (const std::vector<std::size_t> &bins : treeBins) {
+        for (std::size_t i : bins) {
+          transferBin(tables_[i], i, oldCap, newTable, newTags);
+        }
+      }
+      tables_ = std::move(newTable);
+      tags_ = std::move(newTags);
+    }
+  };
+
+ public:
+  /**
+   * Forward iterator over all entries, bucket by bucket in table order and
+   * along the chain inside each bucket. Dereferencing yields a pair of
+   * references to the key and the value, so both
+   * for (auto [key, value] : map) and it->second = v work.
+   *
+   * Any Put, Del or resize invalidates all iterators, except for the one
+   * returned by Erase. With IncrementalResize, begin() first finishes a
+   * running resize, which does not change the entries, while cbegin() leaves
+   * the map alone and walks the old table and then the new one. Erase does
+   * not move buckets either, so erasing along a walk from cbegin() still
+   * visits every entry once.
+   */
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::pair<const K, V>;
+    using reference =
+        std::pair<const K &, std::conditional_t<Const, const V &, V &>>;
+
+    struct pointer {
+      // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+      reference ref;
+
+      auto operator->() noexcept -> reference * { return &ref; }
+    };
+
+    Iterator() noexcept = default;
+
+    // a mutable iterator converts to a const one
+    template <bool OtherConst,
+              std::enable_if_t<Const && !OtherConst, int> = 0>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    Iterator(const Iterator<OtherConst> &other) noexcept
+        : bins_(other.bins_),
+          capacity_(other.capacity_),
+          oldBins_(other.oldBins_),
+          oldCapacity_(other.oldCapacity_),
+          inOld_(other.inOld_),
+          index_(other.index_),
+          pos_(other.pos_),
+          node_(other.node_) {}
+
+    auto operator*() const noexcept -> reference {
+      return reference(node_->key, node_->value);
+    }
+
+    auto operator->() const noexcept -> pointer { return pointer{**this}; }
+
+    auto operator++() noexcept -> Iterator & {
+      node_ = node_->next;
+      ++pos_;
+      if (node_ == nullptr) {
+        ++index_;
+        seek();
+      }
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> Iterator {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    auto operator==(const Iterator &other) const noexcept -> bool {
+      return node_ == other.node_;
+    }
+
+    auto operator!=(const Iterator &other) const noexcept -> bool {
+      return node_ != other.node_;
+    }
+
+   private:
+    friend class HashMap;
+
+    template <bool>
+    friend class Iterator;
+
+    Node *const *bins_ = nullptr;
+
+    std::size_t capacity_ = 0;
+
+    // the old table of a running incremental resize, walked before bins_
+    Node *const *oldBins_ = nullptr;
+
+    std::size_t oldCapacity_ = 0;
+
+    bool inOld_ = false;
+
+    std::size_t index_ = 0;
+
+    // position of node_ in the chain of its bucket, used by Erase
+    std::size_t pos_ = 0;
+
+    Node *node_ = nullptr;
+
+    Iterator(Node *const *bins, std::size_t capacity, std::size_t index,
+             std::size_t pos, Node *node) noexcept
+        : bins_(bins),
+          capacity_(capacity),
+          index_(index),
+          pos_(pos),
+          node_(node) {}
+
+    /**
+     * Moves to the head of the first non-empty bucket at or after index_.
+     * During an incremental resize the buckets of oldBins_ that have not
+     * been moved come first, then the buckets of bins_ that they were moved
+     * into, the others in bins_ are not filled in yet.
+     */
+    auto seek() noexcept -> void {
+      pos_ = 0;
+      node_ = nullptr;
+      if (inOld_) {
+        for (; index_ < oldCapacity_; ++index_) {
+          Node *bin = oldBins_[index_];
+          if (bin != nullptr && bin != movedBin()) {
+            node_ = binHead(bin);
+            return;
+          }
+        }
+        inOld_ = false;
+        index_ = 0;
+      }
+      for (; index_ < capacity_; ++index_) {
+        if (oldBins_ != nullptr &&
+            oldBins_[index_ & (oldCapacity_ - 1)] != movedBin()) {
+          continue;
+        }
+        if (bins_[index_] != nullptr) {
+          node_ = binHead(bins_[index_]);
+          return;
+        }
+      }
+    }
+  };
+
+  using iterator = Iterator<false>;
+
+  using const_iterator = Iterator<true>;
+
+ private:
+  auto beginAt(std::size_t index) noexcept -> iterator {
+    iterator it(tables_.data(), capacity_, index, 0, nullptr);
+    it.seek();
+    return it;
+  }
+
+ public:
+
+  HashMap() noexcept : HashMap(Hash()){};
+
+  explicit HashMap(const Alloc &alloc) noexcept
+      : HashMap(Hash(), KeyEqual(), alloc){};
+
+  explicit HashMap(const Hash &hasher, const KeyEqual &keyEqual = KeyEqual(),
+                   const Alloc &alloc = Alloc()) noexcept
+      : objectPool_(alloc),
+        hasher_(hasher),
+        keyEqual_(keyEqual),
+        treeNodeAllocator_(alloc),
+        capacity_(DEFAULT_INITIAL_CAPACITY),
+        threshold_(capacity_ * DEFAULT_LOAD_FACTOR),
+        tables_(DEFAULT_INITIAL_CAPACITY, nullptr, alloc),
+        tags_(TaggedBuckets ? DEFAULT_INITIAL_CAPACITY : 0, BucketTags{},
+              alloc),
+        oldTables_(alloc),
+        loadFactor(DEFAULT_LOAD_FACTOR){};
+
+  /**
+   * Constructs an empty map whose table holds initialCapacity buckets,
+   * rounded up to a power of two, and that resizes once its size exceeds
+   * loadFactor times the number of buckets.
+   *
+   * Throws std::invalid_argument if loadFactor is not positive.
+   */
+  explicit HashMap(std::size_t initialCapacity,
+                   float loadFactor = DEFAULT_LOAD_FACTOR,
+                   const Hash &hasher = Hash(),
+                   const KeyEqual &keyEqual = KeyEqual(),
+                   const Alloc &alloc = Alloc())
+      : objectPool_(alloc),
+        hasher_(hasher),
+        keyEqual_(keyEqual),
+        treeNodeAllocator_(alloc),
+        capacity_(tableSizeFor(initialCapacity)),
+        threshold_(0),
+        tables_(alloc),
+        tags_(alloc),
+        oldTables_(alloc),
+        loadFactor(loadFactor) {
+    // also rejects NaN
+    if (!(loadFactor > 0)) {
+      throw std::invalid_argument("Illegal load factor: " +
+                                  std::to_string(loadFactor));
     }
+    threshold_ = thresholdFor(capacity_);
+    tables_.resize(capacity_, nullptr);
+    tags_.resize(TaggedBuckets ? capacity_ : 0, BucketTags{});
+  };
 
-    if (ans.length() != 1) {
-      ans[ans.length() - 1] = '}';
+  /**
+   * Constructs a map holding the key/value pairs of [first, last), see
+   * BulkLoad.
+   */
+  template <typename InputIt,
+            std::enable_if_t<is_iterator<InputIt>::value, int> = 0>
+  HashMap(InputIt first, InputIt last, const Hash &hasher = Hash(),
+          const KeyEqual &keyEqual = KeyEqual(), const Alloc &alloc = Alloc())
+      : HashMap(hasher, keyEqual, alloc) {
+    BulkLoad(first, last);
+  }
+
+  template <typename KeyType, typename ValueType>
+  auto Put(KeyType &&key, ValueType &&value) noexcept -> void {
+    // type check
+    using DecayedKeyType = std::decay_t<KeyType>;
+    using DecayedValueType = std::decay_t<ValueType>;
+    static_assert(std::is_same_v<DecayedKeyType, K>,
+                  "KeyType must be the same as K");
+    static_assert(std::is_same_v<DecayedValueType, V>,
+                  "ValueType must be the same as V");
+
+    InsertOrAssign(std::forward<KeyType>(key), std::forward<ValueType>(value));
+  };
+
+  /**
+   * Builds the key from keyArg and the value from valueArgs inside the new
+   * node. Returns false and leaves the map unchanged if the key is present.
+   */
+  template <typename KeyArg, typename... ValueArgs>
+  auto Emplace(KeyArg &&keyArg, ValueArgs &&...valueArgs) noexcept -> bool {
+    if constexpr (std::is_same_v<std::decay_t<KeyArg>, K>) {
+      return TryEmplace(std::forward<KeyArg>(keyArg),
+                        std::forward<ValueArgs>(valueArgs)...);
     } else {
-      ans.append("}");
+      // the key has to exist before it can be hashed
+      return TryEmplace(K(std::forward<KeyArg>(keyArg)),
+                        std::forward<ValueArgs>(valueArgs)...);
+    }
+  }
+
+  /**
+   * Inserts a value built in place from valueArgs if key is absent. Neither
+   * key nor valueArgs are touched when key is already present.
+   */
+  template <typename... ValueArgs>
+  auto TryEmplace(const K &key, ValueArgs &&...valueArgs) noexcept -> bool {
+    OpTrace trace(*this, MapOp::PUT);
+    return putVal(hash(key), key, std::forward<ValueArgs>(valueArgs)...) ==
+           nullptr;
+  }
+
+  template <typename... ValueArgs>
+  auto TryEmplace(K &&key, ValueArgs &&...valueArgs) noexcept -> bool {
+    OpTrace trace(*this, MapOp::PUT);
+    std::size_t hashCode = hash(key);
+    return putVal(hashCode, std::move(key),
+                  std::forward<ValueArgs>(valueArgs)...) == nullptr;
+  }
+
+  /**
+   * Inserts value under key, or assigns it to the existing value. Returns
+   * true if a new entry was inserted.
+   */
+  template <typename ValueType>
+  auto InsertOrAssign(const K &key, ValueType &&value) noexcept -> bool {
+    OpTrace trace(*this, MapOp::PUT);
+    Node *node = putVal(hash(key), key, std::forward<ValueType>(value));
+    if (node != nullptr) {
+      node->value = std::forward<ValueType>(value);
+    }
+    return node == nullptr;
+  }
+
+  template <typename ValueType>
+  auto InsertOrAssign(K &&key, ValueType &&value) noexcept -> bool {
+    OpTrace trace(*this, MapOp::PUT);
+    std::size_t hashCode = hash(key);
+    Node *node =
+        putVal(hashCode, std::move(key), std::forward<ValueType>(value));
+    if (node != nullptr) {
+      node->value = std::forward<ValueType>(value);
+    }
+    return node == nullptr;
+  }
+
+  auto Get(const K &key) const noexcept -> std::optional<V> {
+    OpTrace trace(*this, MapOp::GET);
+    Node *node = getNode(hash(key), key);
+    return node == nullptr ? std::nullopt : std::make_optional(node->value);
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Get(const Q &key) const noexcept -> std::optional<V> {
+    OpTrace trace(*this, MapOp::GET);
+    Node *node = getNode(hash(key), key);
+    return node == nullptr ? std::nullopt : std::make_optional(node->value);
+  }
+
+  /**
+   * Returns a pointer to the value of key, or nullptr if key is absent. The
+   * pointer stays valid until the next insertion or removal.
+   */
+  auto Find(const K &key) noexcept -> V * {
+    OpTrace trace(*this, MapOp::GET);
+    Node *node = getNode(hash(key), key);
+    return node == nullptr ? nullptr : &node->value;
+  }
+
+  auto Find(const K &key) const noexcept -> const V * {
+    OpTrace trace(*this, MapOp::GET);
+    Node *node = getNode(hash(key), key);
+    return node == nullptr ? nullptr : &node->value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Find(const Q &key) noexcept -> V * {
+    OpTrace trace(*this, MapOp::GET);
+    Node *node = getNode(hash(key), key);
+    return node == nullptr ? nullptr : &node->value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Find(const Q &key) const noexcept -> const V * {
+    OpTrace trace(*this, MapOp::GET);
+    Node *node = getNode(hash(key), key);
+    return node == nullptr ? nullptr : &node->value;
+  }
+
+  /**
+   * Java's getOrDefault.
+   */
+  auto GetOr(const K &key, const V &defaultValue) const noexcept -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto GetOr(const Q &key, const V &defaultValue) const noexcept -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  auto Contain(const K &key) const noexcept -> bool {
+    OpTrace trace(*this, MapOp::GET);
+    return getNode(hash(key), key) != nullptr;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Contain(const Q &key) const noexcept -> bool {
+    OpTrace trace(*this, MapOp::GET);
+    return getNode(hash(key), key) != nullptr;
+  }
+
+  /**
+   * Stores the value of keys[i], or std::nullopt, in out[i] for every i in
+   * [0, count). Faster than count calls of Get on a table that does not fit
+   * in the cache, because the lookups are interleaved and their memory
+   * accesses overlap.
+   */
+  template <typename Q,
+            std::enable_if_t<std::is_same_v<Q, K> || is_key_like<Q>::value,
+                             int> = 0>
+  auto GetMany(const Q *keys, std::size_t count,
+               std::optional<V> *out) const noexcept -> void {
+    lookupMany(keys, count, [out](std::size_t i, Node *node) {
+      out[i] = node == nullptr ? std::nullopt : std::make_optional(node->value);
+    });
+  }
+
+  template <typename Q,
+            std::enable_if_t<std::is_same_v<Q, K> || is_key_like<Q>::value,
+                             int> = 0>
+  auto GetMany(const std::vector<Q> &keys) const
+      -> std::vector<std::optional<V>> {
+    std::vector<std::optional<V>> values(keys.size());
+    GetMany(keys.data(), keys.size(), values.data());
+    return values;
+  }
+
+  /**
+   * Stores whether keys[i] is present in out[i] for every i in [0, count),
+   * see GetMany. Returns how many of them are.
+   */
+  template <typename Q,
+            std::enable_if_t<std::is_same_v<Q, K> || is_key_like<Q>::value,
+                             int> = 0>
+  auto ContainMany(const Q *keys, std::size_t count, bool *out) const noexcept
+      -> std::size_t {
+    std::size_t found = 0;
+    lookupMany(keys, count, [out, &found](std::size_t i, Node *node) {
+      out[i] = node != nullptr;
+      found += static_cast<std::size_t>(out[i]);
+    });
+    return found;
+  }
+
+  auto Del(const K &key) noexcept -> bool {
+    OpTrace trace(*this, MapOp::DEL);
+    return removeNode(hash(key), key);
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Del(const Q &key) noexcept -> bool {
+    OpTrace trace(*this, MapOp::DEL);
+    return removeNode(hash(key), key);
+  }
+
+  /**
+   * Applies fn to the value of key in place. Returns false if key is absent.
+   */
+  template <typename Fn>
+  auto Update(const K &key, Fn &&fn) -> bool {
+    rehashStep();
+    V *value = Find(key);
+    if (value == nullptr) {
+      return false;
+    }
+    std::forward<Fn>(fn)(*value);
+    return true;
+  }
+
+  /**
+   * Java's compute: fn(key, old) gets a pointer to the current value, or
+   * nullptr if key is absent, and returns the new value. Returning
+   * std::nullopt removes the entry. Returns a pointer to the stored value,
+   * or nullptr if there is none afterwards.
+   */
+  template <typename Fn>
+  auto Compute(const K &key, Fn &&fn) -> V * {
+    rehashStep();
+    std::size_t hashCode = hash(key);
+    migrateBinOf(hashCode);
+    Node *node = getNode(hashCode, key);
+    std::optional<V> value =
+        std::forward<Fn>(fn)(key, node == nullptr ? nullptr : &node->value);
+
+    if (node != nullptr) {
+      if (value.has_value()) {
+        node->value = std::move(*value);
+        return &node->value;
+      }
+      removeFoundNode(hashCode, node);
+      return nullptr;
+    }
+
+    if (!value.has_value()) {
+      return nullptr;
+    }
+    node = insertVal(hashCode, key, std::move(*value)).first;
+    if (node == nullptr) {
+      // the insertion treeified or resized the bin
+      node = getNode(hashCode, key);
+    }
+    return &node->value;
+  }
+
+  /**
+   * Java's computeIfAbsent: returns the value of key, inserting fn(key)
+   * first if key is absent. fn is not called when key is present.
+   */
+  template <typename Fn>
+  auto ComputeIfAbsent(const K &key, Fn &&fn) -> V & {
+    std::size_t hashCode = hash(key);
+    auto make = [&fn, &key]() -> decltype(auto) {
+      return std::forward<Fn>(fn)(key);
+    };
+    // one walk of the bucket, fn only runs once it has missed
+    Node *node =
+        insertVal(hashCode, key, ValueFrom<decltype(make)>{make}).first;
+    if (node == nullptr) {
+      node = getNode(hashCode, key);
     }
+    return node->value;
+  }
+
+  /**
+   * Java's merge: inserts value if key is absent, otherwise replaces the
+   * current value with fn(old, value). Returning std::nullopt from fn
+   * removes the entry. Returns a pointer to the stored value, or nullptr if
+   * the entry was removed.
+   */
+  template <typename ValueType, typename Fn>
+  auto Merge(const K &key, ValueType &&value, Fn &&fn) -> V * {
+    std::size_t hashCode = hash(key);
+    migrateBinOf(hashCode);
+    auto [node, inserted] =
+        insertVal(hashCode, key, std::forward<ValueType>(value));
+    if (inserted) {
+      if (node == nullptr) {
+        node = getNode(hashCode, key);
+      }
+      return &node->value;
+    }
+
+    std::optional<V> merged =
+        std::forward<Fn>(fn)(node->value, std::forward<ValueType>(value));
+    if (!merged.has_value()) {
+      removeFoundNode(hashCode, node);
+      return nullptr;
+    }
+    node->value = std::move(*merged);
+    return &node->value;
+  }
+
+  [[nodiscard]] auto toString() const noexcept -> std::string {
+    return Format();
+  }
 
+  /**
+   * toString of at most limit entries, taking only every every-th entry of
+   * the table when every is above 1. Numbers and strings are printed
+   * straight into the result, without a stream per entry.
+   */
+  [[nodiscard]] auto Format(
+      std::size_t limit = std::numeric_limits<std::size_t>::max(),
+      std::size_t every = 1) const -> std::string {
+    std::string ans;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ans.reserve(std::min(size_ / std::max<std::size_t>(every, 1), limit) * 16 +
+                2);
+    formatEntries(ans, limit, every, [](std::string & /*unused*/) {});
     return ans;
   }
 
+  /**
+   * Writes Format(limit, every) to out through a buffer of
+   * DUMP_BUFFER_BYTES, so a map of any size is printed without building
+   * its whole text in memory. Failures are left in the state of out.
+   */
+  auto Dump(std::ostream &out,
+            std::size_t limit = std::numeric_limits<std::size_t>::max(),
+            std::size_t every = 1) const -> void {
+    std::string buffer;
+    buffer.reserve(DUMP_BUFFER_BYTES + DUMP_BUFFER_BYTES / 2);
+    auto flush = [&out](std::string &text) {
+      out.write(text.data(), static_cast<std::streamsize>(text.size()));
+      text.clear();
+    };
+    formatEntries(buffer, limit, every, flush);
+    flush(buffer);
+  }
+
+  /**
+   * Writes every entry to a file at path that a MappedHashMap of the same
+   * K, V and Hash serves lookups from without loading it. K and V must be
+   * trivially copyable or std::string. A Hash with state, such as
+   * SeededHash, has to be handed to the MappedHashMap as hash_function()
+   * returns it.
+   *
+   * Throws std::ios_base::failure if the file cannot be written.
+   */
+  auto SaveSnapshot(const std::string &path) const -> void {
+    snapshot::write<K, V>(path, size_, [this](auto &&add) {
+      ForEach([this, &add](const K &key, const V &value) {
+        add(hasher_(key), key, value);
+      });
+    });
+  }
+
+  /**
+   * Writes every entry to out as a framed binary stream, each key and value
+   * encoded by KeyCodec and ValueCodec, see Codec. Failures are left in the
+   * state of out.
+   */
+  template <typename KeyCodec = Codec<K>, typename ValueCodec = Codec<V>>
+  auto Serialize(std::ostream &out) const -> void {
+    serialization::write<KeyCodec, ValueCodec>(
+        [this](auto &&add) { ForEach(add); }, serialization::streamSink(out));
+  }
+
+  /**
+   * Appends the stream Serialize writes to buffer.
+   */
+  template <typename KeyCodec = Codec<K>, typename ValueCodec = Codec<V>>
+  auto Serialize(std::string &buffer) const -> void {
+    serialization::write<KeyCodec, ValueCodec>(
+        [this](auto &&add) { ForEach(add); },
+        serialization::bufferSink(buffer));
+  }
+
+  /**
+   * Reads a stream written by Serialize from in and puts its entries into
+   * the map, a frame at a time as they arrive, so the whole input is never
+   * held in memory. Entries replace the values of keys already present.
+   * Returns the number of entries read.
+   *
+   * Throws std::runtime_error if the stream is malformed or ends early, the
+   * entries decoded until then stay in the map.
+   */
+  template <typename KeyCodec = Codec<K>, typename ValueCodec = Codec<V>>
+  auto Deserialize(std::istream &in) -> std::size_t {
+    return serialization::read<K, V, KeyCodec, ValueCodec>(
+        serialization::streamSource(in), [this](K &&key, V &&value) {
+          InsertOrAssign(std::move(key), std::move(value));
+        });
+  }
+
+  template <typename KeyCodec = Codec<K>, typename ValueCodec = Codec<V>>
+  auto Deserialize(std::string_view buffer) -> std::size_t {
+    return serialization::read<K, V, KeyCodec, ValueCodec>(
+        serialization::bufferSource(buffer), [this](K &&key, V &&value) {
+          InsertOrAssign(std::move(key), std::move(value));
+        });
+  }
+
   [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
 
   [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
 
+  /**
+   * The Hash the map was built with.
+   */
+  [[nodiscard]] auto hash_function() const -> Hash { return hasher_; }
+
+  /**
+   * Number of buckets of the table.
+   */
+  [[nodiscard]] auto bucketCount() const noexcept -> std::size_t {
+    return capacity_;
+  }
+
+  /**
+   * Bytes of memory held by the map: the map itself, its bucket arrays, the
+   * node slabs with their free cells and the nodes of tree bins. Walks the
+   * tree bins, so it takes time linear in the number of buckets.
+   */
+  [[nodiscard]] auto MemoryUsage() const noexcept -> std::size_t {
+    std::size_t bytes =
+        sizeof(*this) + objectPool_.bytes() +
+        (tables_.capacity() + oldTables_.capacity()) * sizeof(Node *) +
+        tags_.capacity() * sizeof(BucketTags);
+    forEachBin([&bytes](Node *bin) {
+      if (isTreeBin(bin)) {
+        for (Node *node = binHead(bin); node != nullptr; node = node->next) {
+          bytes += sizeof(TreeNode);
+        }
+      }
+    });
+    return bytes;
+  }
+
+  /**
+   * Bucket count, load, chain lengths and memory of the map, and the resizes
+   * it went through. Walks every bucket, while keeping the resize counters
+   * up to date only costs a clock read per resize. With IncrementalResize
+   * the resize time leaves out the buckets moved by later operations.
+   */
+  [[nodiscard]] auto Stats() const -> HashMapStats {
+    HashMapStats stats;
+    stats.size = size_;
+    stats.bucketCount = capacity_;
+    stats.load = static_cast<double>(size_) / static_cast<double>(capacity_);
+    forEachBin([&stats](Node *bin) {
+      std::size_t length = 0;
+      for (Node *node = binHead(bin); node != nullptr; node = node->next) {
+        ++length;
+      }
+      if (length >= stats.chainLengths.size()) {
+        stats.chainLengths.resize(length + 1, 0);
+      }
+      ++stats.chainLengths[length];
+      stats.maxChain = std::max(stats.maxChain, length);
+      if (isTreeBin(bin)) {
+        ++stats.treeBins;
+        stats.bytesLive += length * sizeof(TreeNode);
+      } else {
+        stats.bytesLive += length * sizeof(Node);
+      }
+    });
+    stats.slabs = objectPool_.slabCount();
+    stats.freeCells = objectPool_.freeCells();
+    stats.bytesReserved = MemoryUsage();
+#if HASHMAP_STATS
+    stats.resizes = resizes_;
+    stats.resizeTime = resizeTime_;
+#endif
+    return stats;
+  }
+
+  /**
+   * Sets the observer that Get, Put and Del report their probes and latency
+   * to, along with resizes and node slab allocations, or removes it if
+   * observer is nullptr. The observer must outlive the map or be removed
+   * first. Ignored unless the map is built with HASHMAP_TRACE.
+   */
+  auto SetObserver([[maybe_unused]] HashMapObserver *observer) noexcept
+      -> void {
+#if HASHMAP_TRACE
+    observer_ = observer;
+    objectPool_.setObserver(observer);
+#endif
+  }
+
+  /**
+   * Grows the table so that n entries fit without any further resize.
+   */
+  auto Reserve(std::size_t n) noexcept -> void {
+    std::size_t newCap = capacityFor(n);
+    if (newCap > capacity_) {
+      rehashTo(newCap);
+    }
+  }
+
+  /**
+   * Rebuilds the table with at least buckets buckets, and never fewer than
+   * the current size needs. The table may shrink.
+   */
+  auto Rehash(std::size_t buckets) noexcept -> void {
+    std::size_t newCap = std::max(tableSizeFor(buckets), capacityFor(size_));
+    if (newCap != capacity_) {
+      rehashTo(newCap);
+    }
+  }
+
+  /**
+   * Shrinks the table to the smallest one holding the current entries, e.g.
+   * after many Del calls.
+   */
+  auto ShrinkToFit() noexcept -> void { Rehash(0); }
+
+  /**
+   * Puts every pair (key, value) of [first, last) in order, so a later pair
+   * wins over an earlier one with the same key. The table is sized for all
+   * of them up front. Large random access ranges are hashed and linked on
+   * several threads, each one owning a range of buckets: by default only
+   * when Alloc is std::allocator, otherwise after SetParallelism.
+   */
+  template <typename InputIt>
+  auto BulkLoad(InputIt first, InputIt last) -> void {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      auto n = static_cast<std::size_t>(std::distance(first, last));
+      Reserve(size_ + n);
+      finishRehash();
+      if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                      Category>) {
+        std::size_t threads = threadsFor(n, is_std_allocator<Alloc>::value);
+        if (threads > 1) {
+          bulkLoadParallel(first, n, threads);
+          return;
+        }
+      }
+    }
+    for (; first != last; ++first) {
+      const auto &entry = *first;
+      InsertOrAssign(entry.first, entry.second);
+    }
+  }
+
+  /**
+   * Sets the number of threads BulkLoad and resize may use, 0 for one per
+   * hardware thread and 1 to stay on the calling thread. Until it is called,
+   * resize stays on the calling thread and BulkLoad uses one thread per
+   * hardware thread if Alloc is std::allocator and the calling thread
+   * otherwise.
+   */
+  auto SetParallelism(std::size_t threads) noexcept -> void {
+    parallelism_ = threads;
+  }
+
+  auto begin() noexcept -> iterator {
+    finishRehash();
+    return beginAt(0);
+  }
+
+  auto begin() const noexcept -> const_iterator { return cbegin(); }
+
+  auto cbegin() const noexcept -> const_iterator {
+    const_iterator it(tables_.data(), capacity_, 0, 0, nullptr);
+    if (!oldTables_.empty()) {
+      it.oldBins_ = oldTables_.data();
+      it.oldCapacity_ = oldTables_.size();
+      it.inOld_ = true;
+    }
+    it.seek();
+    return it;
+  }
+
+  auto end() noexcept -> iterator { return iterator(); }
+
+  auto end() const noexcept -> const_iterator { return const_iterator(); }
+
+  auto cend() const noexcept -> const_iterator { return const_iterator(); }
+
+  /**
+   * Removes the entry at it and returns an iterator to the entry after it.
+   * A running incremental resize is not advanced, so an iterator from
+   * cbegin() still visits every other entry exactly once.
+   */
+  auto Erase(const_iterator it) noexcept -> iterator {
+    Node *node = it.node_;
+    std::size_t index = it.index_;
+    // it walks a bucket of the old table until it has passed all of them
+    NodeTable &table = it.inOld_ ? oldTables_ : tables_;
+    bool wasTree = isTreeBin(table[index]);
+    Node *next = node->next;
+
+    if (wasTree) {
+      removeTreeNode(table, static_cast<TreeNode *>(node), false);
+      deleteTreeNode(static_cast<TreeNode *>(node));
+      size_--;
+    } else {
+      Node *prev = nullptr;
+      for (Node *e = table[index]; e != node; e = e->next) {
+        prev = e;
+      }
+      unlinkNode(table, index, prev, node, it.pos_);
+    }
+
+    if (wasTree && !isTreeBin(table[index])) {
+      // the bin was rebuilt as a list with the same order, and the node that
+      // followed the erased one is now where it used to be
+      next = table[index];
+      for (std::size_t i = 0; i < it.pos_; i++) {
+        next = next->next;
+      }
+    }
+
+    iterator following(it.bins_, it.capacity_, index, it.pos_, next);
+    following.oldBins_ = it.oldBins_;
+    following.oldCapacity_ = it.oldCapacity_;
+    following.inOld_ = it.inOld_;
+    if (next == nullptr) {
+      ++following.index_;
+      following.seek();
+    }
+    return following;
+  }
+
+  /**
+   * Removes every entry for which pred(key, value) is true and returns how
+   * many were removed.
+   */
+  template <typename Pred>
+  auto EraseIf(Pred &&pred) -> std::size_t {
+    std::size_t removed = 0;
+    for (iterator it = begin(); it != end();) {
+      if (pred(it.node_->key, it.node_->value)) {
+        it = Erase(it);
+        ++removed;
+      } else {
+        ++it;
+      }
+    }
+    return removed;
+  }
+
+  /**
+   * Calls fn(key, value) for every entry. Cheaper than iterators since the
+   * table is walked in one loop.
+   */
+  template <typename Fn>
+  auto ForEach(Fn &&fn) -> void {
+    forEachBin([&fn](Node *bin) {
+      for (Node *node = binHead(bin); node != nullptr; node = node->next) {
+        fn(static_cast<const K &>(node->key), node->value);
+      }
+    });
+  }
+
+  template <typename Fn>
+  auto ForEach(Fn &&fn) const -> void {
+    forEachBin([&fn](Node *bin) {
+      for (const Node *node = binHead(bin); node != nullptr;
+           node = node->next) {
+        fn(node->key, node->value);
+      }
+    });
+  }
+
   ~HashMap() {
-    for (Node *tableNode : tables_) {
-      Node *curr = tableNode;
-      Node *next = tableNode;
+    forEachBin([this](Node *tableNode) {
+      bool tree = isTreeBin(tableNode);
+      Node *curr = binHead(tableNode);
+      Node *next = curr;
       while (curr != nullptr) {
         next = curr->next;
-        objectPool_.deallocate(curr);
+        if (tree) {
+          deleteTreeNode(static_cast<TreeNode *>(curr));
+        } else {
+          objectPool_.deallocate(curr);
+        }
         curr = next;
       }
-    }
+    });
   }
 };
 
+/**
+ * HashMap whose buckets carry inline hash tag arrays, see TaggedBuckets.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+using TaggedHashMap = HashMap<K, V, Hash, KeyEqual, Alloc, true>;
+
+/**
+ * HashMap that spreads every resize over later operations, see
+ * IncrementalResize.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+using IncrementalHashMap = HashMap<K, V, Hash, KeyEqual, Alloc, false, true>;
+
+/**
+ * HashMap with its own random SeededHash, for keys that may be chosen to
+ * collide. String keys can be looked up by std::string_view and
+ * const char *.
+ */
+template <typename K, typename V,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+using SeededHashMap = HashMap<K, V, SeededHash, std::equal_to<>, Alloc>;
+
 }  // namespace JAVA
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace JAVA {
+
+namespace detail {
+
+/**
+ * Whether T declares a member type is_transparent, is_avalanching or
+ * is_expensive, the hints a Hash or KeyEqual gives the maps, see HashMap.
+ */
+template <typename T>
+struct is_transparent {
+  template <typename U>
+  static auto test(int)
+      -> decltype(std::declval<typename U::is_transparent *>(),
+                  std::true_type{});
+
+  template <typename>
+  static auto test(...) -> std::false_type;
+
+  static constexpr bool value = decltype(test<T>(0))::value;
+};
+
+template <typename T>
+struct is_avalanching {
+  template <typename U>
+  static auto test(int)
+      -> decltype(std::declval<typename U::is_avalanching *>(),
+                  std::true_type{});
+
+  template <typename>
+  static auto test(...) -> std::false_type;
+
+  static constexpr bool value = decltype(test<T>(0))::value;
+};
+
+template <typename T>
+struct is_expensive {
+  template <typename U>
+  static auto test(int)
+      -> decltype(std::declval<typename U::is_expensive *>(),
+                  std::true_type{});
+
+  template <typename>
+  static auto test(...) -> std::false_type;
+
+  static constexpr bool value = decltype(test<T>(0))::value;
+};
+
+}  // namespace detail
+
+/**
+ * Transparent hash of std::string. Together with std::equal_to<> it lets a
+ * HashMap<std::string, V> be queried with std::string_view or const char *
+ * without building a temporary std::string for every lookup.
+ */
+struct StringHash {
+  using is_transparent = void;
+
+  auto operator()(std::string_view key) const noexcept -> std::size_t {
+    return std::hash<std::string_view>{}(key);
+  }
+
+  auto operator()(const std::string &key) const noexcept -> std::size_t {
+    return std::hash<std::string_view>{}(key);
+  }
+
+  auto operator()(const char *key) const noexcept -> std::size_t {
+    return std::hash<std::string_view>{}(key);
+  }
+};
+
+namespace hashing {
+
+constexpr inline auto rotl(std::uint64_t x, unsigned bits) noexcept
+    -> std::uint64_t {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  return (x << bits) | (x >> (64 - bits));
+}
+
+/**
+ * SipHash-c-d of data[0, size) under the 128-bit key (k0, k1), as in
+ * "SipHash: a fast short-input PRF" by Aumasson and Bernstein. Words are
+ * read little-endian.
+ */
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+auto sipHash(std::uint64_t k0, std::uint64_t k1, const char *data,
+             std::size_t size) noexcept -> std::uint64_t {
+  // NOLINTBEGIN(readability-magic-numbers)
+  std::uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  std::uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  std::uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  std::uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+  auto round = [&](unsigned rounds) {
+    for (unsigned r = 0; r < rounds; r++) {
+      v0 += v1;
+      v1 = rotl(v1, 13);
+      v1 ^= v0;
+      v0 = rotl(v0, 32);
+      v2 += v3;
+      v3 = rotl(v3, 16);
+      v3 ^= v2;
+      v0 += v3;
+      v3 = rotl(v3, 21);
+      v3 ^= v0;
+      v2 += v1;
+      v1 = rotl(v1, 17);
+      v1 ^= v2;
+      v2 = rotl(v2, 32);
+    }
+  };
+
+  std::size_t end = size - size % sizeof(std::uint64_t);
+  for (std::size_t i = 0; i < end; i += sizeof(std::uint64_t)) {
+    std::uint64_t m = 0;
+    std::memcpy(&m, data + i, sizeof(m));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    m = __builtin_bswap64(m);
+#endif
+    v3 ^= m;
+    round(CompressionRounds);
+    v0 ^= m;
+  }
+
+  // the last word holds the remaining bytes and the low byte of the size
+  std::uint64_t last = static_cast<std::uint64_t>(size) << 56;
+  for (std::size_t i = end; i < size; i++) {
+    last |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i]))
+            << (8 * (i - end));
+  }
+  v3 ^= last;
+  round(CompressionRounds);
+  v0 ^= last;
+
+  v2 ^= 0xff;
+  round(FinalizationRounds);
+  return v0 ^ v1 ^ v2 ^ v3;
+  // NOLINTEND(readability-magic-numbers)
+}
+
+/**
+ * High and low half of the 128-bit product of a and b folded together, the
+ * mixing step of wyhash.
+ */
+constexpr inline auto foldedMultiply(std::uint64_t a, std::uint64_t b) noexcept
+    -> std::uint64_t {
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  return static_cast<std::uint64_t>(product) ^
+         static_cast<std::uint64_t>(product >> 64);
+}
+
+/**
+ * Finalizer of SplitMix64, a bijection whose output bits all depend on
+ * every input bit.
+ */
+constexpr inline auto splitMix(std::uint64_t x) noexcept -> std::uint64_t {
+  // NOLINTBEGIN(readability-magic-numbers)
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+  // NOLINTEND(readability-magic-numbers)
+}
+
+/**
+ * FNV-1a of the characters of key.
+ */
+constexpr inline auto fnv1a(std::string_view key) noexcept -> std::uint64_t {
+  // NOLINTBEGIN(readability-magic-numbers)
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+  for (char c : key) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+  }
+  return h;
+  // NOLINTEND(readability-magic-numbers)
+}
+
+}  // namespace hashing
+
+/**
+ * Hash that can run at compile time, the default of StaticHashMap. Integers
+ * and enums go through the SplitMix64 finalizer, strings through FNV-1a and
+ * then the same finalizer. Transparent over std::string, std::string_view
+ * and const char *, though only the last two hash at compile time.
+ */
+struct StaticHash {
+  using is_transparent = void;
+
+  using is_avalanching = void;
+
+  constexpr auto operator()(std::string_view key) const noexcept
+      -> std::size_t {
+    return static_cast<std::size_t>(hashing::splitMix(hashing::fnv1a(key)));
+  }
+
+  auto operator()(const std::string &key) const noexcept -> std::size_t {
+    return (*this)(std::string_view(key));
+  }
+
+  constexpr auto operator()(const char *key) const noexcept -> std::size_t {
+    return (*this)(std::string_view(key));
+  }
+
+  template <typename T,
+            std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>,
+                             int> = 0>
+  constexpr auto operator()(T key) const noexcept -> std::size_t {
+    if constexpr (std::is_enum_v<T>) {
+      return static_cast<std::size_t>(hashing::splitMix(
+          static_cast<std::uint64_t>(
+              static_cast<std::underlying_type_t<T>>(key))));
+    } else {
+      return static_cast<std::size_t>(
+          hashing::splitMix(static_cast<std::uint64_t>(key)));
+    }
+  }
+};
+
+/**
+ * Keyed hash for maps whose keys come from outside, e.g.
+ * HashMap<std::string, V, SeededHash, std::equal_to<>>. With a fixed hash
+ * anyone who controls the keys can pick keys that all land in one bucket;
+ * here the buckets depend on a 128-bit seed that differs for every
+ * SeededHash built without one, so they cannot be predicted.
+ *
+ * Strings are hashed with SipHash-1-3 and integers, enums and pointers with
+ * two keyed folded multiplications. Other types go through std::hash first,
+ * so keys that collide there still collide. Like StringHash it is
+ * transparent over std::string, std::string_view and const char *, and its
+ * hash codes are used as they are by HashMap.
+ *
+ * The seeds of default constructed instances are derived from one random
+ * seed per process and a counter, which keeps construction cheap enough for
+ * every map to have its own.
+ */
+class SeededHash {
+ public:
+  using is_transparent = void;
+
+  using is_avalanching = void;
+
+  /**
+   * Hashes with a seed no other default constructed SeededHash has.
+   */
+  SeededHash() noexcept {
+    static const std::pair<std::uint64_t, std::uint64_t> BASE = processSeed();
+    static std::atomic<std::uint64_t> instances{0};
+    std::uint64_t n = instances.fetch_add(1, std::memory_order_relaxed);
+    k0_ = hashing::splitMix(BASE.first + n * SEED_STEP);
+    k1_ = hashing::splitMix(BASE.second ^ k0_);
+  }
+
+  /**
+   * Hashes with the given seed. Built from the Seed of another SeededHash it
+   * gives the same hash codes, e.g. from map.hash_function().Seed() to open
+   * the snapshot of map with a MappedHashMap.
+   */
+  SeededHash(std::uint64_t k0, std::uint64_t k1) noexcept : k0_(k0), k1_(k1) {}
+
+  [[nodiscard]] auto Seed() const noexcept
+      -> std::pair<std::uint64_t, std::uint64_t> {
+    return {k0_, k1_};
+  }
+
+  auto operator()(std::string_view key) const noexcept -> std::size_t {
+    return static_cast<std::size_t>(
+        hashing::sipHash<1, 3>(k0_, k1_, key.data(), key.size()));
+  }
+
+  auto operator()(const std::string &key) const noexcept -> std::size_t {
+    return (*this)(std::string_view(key));
+  }
+
+  auto operator()(const char *key) const noexcept -> std::size_t {
+    return (*this)(std::string_view(key));
+  }
+
+  template <typename T,
+            std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>,
+                             int> = 0>
+  auto operator()(T key) const noexcept -> std::size_t {
+    if constexpr (std::is_enum_v<T>) {
+      return mix(static_cast<std::uint64_t>(
+          static_cast<std::underlying_type_t<T>>(key)));
+    } else {
+      // sign extended, so that equal values of different types hash equal
+      return mix(static_cast<std::uint64_t>(key));
+    }
+  }
+
+  template <typename T>
+  auto operator()(T *key) const noexcept -> std::size_t {
+    return mix(reinterpret_cast<std::uintptr_t>(key));
+  }
+
+  template <typename T,
+            std::enable_if_t<!std::is_integral_v<T> && !std::is_enum_v<T> &&
+                                 !std::is_pointer_v<T> &&
+                                 !std::is_convertible_v<const T &,
+                                                        std::string_view>,
+                             int> = 0>
+  auto operator()(const T &key) const -> std::size_t {
+    return mix(static_cast<std::uint64_t>(std::hash<T>{}(key)));
+  }
+
+ private:
+  constexpr static std::uint64_t SEED_STEP = 0x9E3779B97F4A7C15ULL;
+
+  // odd constants out of the SHA-2 initial hash values
+  constexpr static std::uint64_t MIX_A = 0x6A09E667F3BCC909ULL;
+
+  constexpr static std::uint64_t MIX_B = 0xBB67AE8584CAA73BULL;
+
+  std::uint64_t k0_;
+
+  std::uint64_t k1_;
+
+  /**
+   * Random seed shared by the process, from std::random_device if it works
+   * and from the clock and an address otherwise.
+   */
+  static auto processSeed() noexcept
+      -> std::pair<std::uint64_t, std::uint64_t> {
+    auto draw = []() -> std::uint64_t {
+      std::random_device device;
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+    };
+    try {
+      return {draw(), draw()};
+    } catch (...) {
+      static const int anchor = 0;
+      auto now = static_cast<std::uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+      return {hashing::splitMix(now),
+              hashing::splitMix(reinterpret_cast<std::uintptr_t>(&anchor))};
+    }
+  }
+
+  [[nodiscard]] auto mix(std::uint64_t x) const noexcept -> std::size_t {
+    std::uint64_t h = hashing::foldedMultiply(x ^ k0_, (k1_ ^ MIX_A) | 1);
+    return static_cast<std::size_t>(hashing::foldedMultiply(h ^ k1_, MIX_B));
+  }
+};
+
+}  // namespace JAVA
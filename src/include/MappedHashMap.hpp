@@ -0,0 +1,327 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "Hasher.hpp"
+#include "Snapshot.hpp"
+
+namespace JAVA {
+
+/**
+ * Read-only map served straight from a file written by
+ * HashMap::SaveSnapshot. The file is mapped into memory and looked up in
+ * place, so opening it costs the same for any size and pages are only read
+ * from disk once a lookup touches them.
+ *
+ * K and V must be the types of the map that wrote the snapshot, and Hash
+ * must give the same hash codes as its Hash did, which is checked against
+ * the hash code stored with the first record. Values are returned by
+ * copy, except for std::string values which are returned as a
+ * std::string_view into the mapping. Like HashMap, Get and Contain accept
+ * any type the Hash and KeyEqual can take when both declare is_transparent;
+ * for std::string keys only Hash has to, as the stored keys are compared as
+ * std::string_view.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class MappedHashMap {
+  static_assert(snapshot::is_storable<K> && snapshot::is_storable<V>,
+                "K and V must be trivially copyable non-pointers or std::string");
+
+ public:
+  using value_view =
+      std::conditional_t<snapshot::is_string<V>::value, std::string_view, V>;
+
+ private:
+  using Layout = snapshot::Layout<K, V>;
+
+  template <typename Q>
+  struct is_key_like
+      : std::bool_constant<detail::is_transparent<Hash>::value &&
+                           (snapshot::is_string<K>::value
+                                ? std::is_convertible_v<const Q &,
+                                                        std::string_view>
+                                : detail::is_transparent<KeyEqual>::value) &&
+                           !std::is_same_v<std::decay_t<Q>, K>> {};
+
+  Hash hasher_;
+
+  KeyEqual keyEqual_;
+
+  const unsigned char *data_ = nullptr;
+
+  std::size_t length_ = 0;
+
+  const std::uint64_t *buckets_ = nullptr;
+
+  const unsigned char *records_ = nullptr;
+
+  const char *strings_ = nullptr;
+
+  std::size_t stringsSize_ = 0;
+
+  std::uint32_t bucketBits_ = 0;
+
+  std::size_t size_ = 0;
+
+  // far more buckets than any file could hold records for
+  constexpr static std::uint32_t MAX_BUCKET_BITS = 48;
+
+  [[noreturn]] static auto fail(const std::string &path) -> void {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  /**
+   * Checks that the mapped file is a snapshot of a map of K and V whose
+   * sections all lie inside the file. The contents of the sections are
+   * trusted, apart from bucket bounds past the last record and strings past
+   * the end of the strings section, which are cut off where they are read.
+   */
+  auto validate(const std::string &path) const -> void {
+    auto bad = [&path]() {
+      throw std::runtime_error("Not a snapshot of this map type: " + path);
+    };
+    if (length_ < sizeof(snapshot::Header)) {
+      bad();
+    }
+    snapshot::Header header{};
+    std::memcpy(&header, data_, sizeof(header));
+    if (header.magic != snapshot::MAGIC ||
+        header.version != snapshot::VERSION || header.keySize != sizeof(K) ||
+        header.valueSize != sizeof(V) ||
+        header.recordSize != Layout::RECORD_SIZE ||
+        header.bucketBits >= MAX_BUCKET_BITS) {
+      bad();
+    }
+    // sizes are compared against the room between offsets rather than added
+    // to them, so that offsets near 2^64 cannot wrap around
+    if (header.bucketsOffset % snapshot::SECTION_ALIGN != 0 ||
+        header.recordsOffset % snapshot::SECTION_ALIGN != 0 ||
+        header.stringsOffset > length_ ||
+        header.recordsOffset > header.stringsOffset ||
+        header.bucketsOffset < sizeof(snapshot::Header) ||
+        header.bucketsOffset > header.recordsOffset ||
+        (std::uint64_t{1} << header.bucketBits) + 1 >
+            (header.recordsOffset - header.bucketsOffset) /
+                sizeof(std::uint64_t) ||
+        header.size > (header.stringsOffset - header.recordsOffset) /
+                          Layout::RECORD_SIZE ||
+        header.stringsSize > length_ - header.stringsOffset) {
+      bad();
+    }
+  }
+
+  /**
+   * Whether hasher_ gives the key of record the hash code stored with it.
+   * Every record holds the hash code of its key under the Hash of the map
+   * that wrote it, so a Hash that differs, e.g. a SeededHash with another
+   * seed, would make every lookup miss.
+   */
+  auto hashMatches(const unsigned char *record) const -> bool {
+    const unsigned char *field = record + Layout::KEY_OFFSET;
+    std::uint64_t hashCode = 0;
+    if constexpr (snapshot::is_string<K>::value) {
+      hashCode = static_cast<std::uint64_t>(hasher_(K(stringAt(field))));
+    } else {
+      hashCode = static_cast<std::uint64_t>(
+          hasher_(*reinterpret_cast<const K *>(field)));
+    }
+    return hashCode == hashAt(record);
+  }
+
+  auto release() noexcept -> void {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<unsigned char *>(data_), length_);
+      data_ = nullptr;
+    }
+  }
+
+  static inline auto hashAt(const unsigned char *record) noexcept
+      -> std::uint64_t {
+    std::uint64_t hashCode = 0;
+    std::memcpy(&hashCode, record, sizeof(hashCode));
+    return hashCode;
+  }
+
+  auto stringAt(const unsigned char *field) const noexcept
+      -> std::string_view {
+    const auto *ref = reinterpret_cast<const snapshot::StringRef *>(field);
+    std::uint64_t offset = std::min<std::uint64_t>(ref->offset, stringsSize_);
+    return {strings_ + offset,
+            std::min<std::uint64_t>(ref->length, stringsSize_ - offset)};
+  }
+
+  template <typename Q>
+  auto keyMatches(const unsigned char *record, const Q &key) const noexcept
+      -> bool {
+    const unsigned char *field = record + Layout::KEY_OFFSET;
+    if constexpr (snapshot::is_string<K>::value) {
+      return stringAt(field) == std::string_view(key);
+    } else {
+      return keyEqual_(*reinterpret_cast<const K *>(field), key);
+    }
+  }
+
+  auto valueAt(const unsigned char *record) const noexcept -> value_view {
+    const unsigned char *field = record + Layout::VALUE_OFFSET;
+    if constexpr (snapshot::is_string<V>::value) {
+      return stringAt(field);
+    } else {
+      return *reinterpret_cast<const V *>(field);
+    }
+  }
+
+  template <typename Q>
+  auto findRecord(const Q &key) const noexcept -> const unsigned char * {
+    auto hashCode = static_cast<std::uint64_t>(hasher_(key));
+    std::uint64_t b = snapshot::bucketOf(hashCode, bucketBits_);
+    std::uint64_t end = std::min<std::uint64_t>(buckets_[b + 1], size_);
+    for (std::uint64_t i = buckets_[b]; i < end; i++) {
+      const unsigned char *record = records_ + i * Layout::RECORD_SIZE;
+      if (hashAt(record) == hashCode && keyMatches(record, key)) {
+        return record;
+      }
+    }
+    return nullptr;
+  }
+
+ public:
+  /**
+   * Maps the snapshot at path.
+   *
+   * Throws std::system_error if the file cannot be opened or mapped, and
+   * std::runtime_error if it is not a snapshot of a map of K and V or was
+   * written with a Hash giving other hash codes than hasher.
+   */
+  explicit MappedHashMap(const std::string &path, const Hash &hasher = Hash(),
+                         const KeyEqual &keyEqual = KeyEqual())
+      : hasher_(hasher), keyEqual_(keyEqual) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      fail(path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      int error = errno;
+      ::close(fd);
+      errno = error;
+      fail(path);
+    }
+    length_ = static_cast<std::size_t>(st.st_size);
+    void *data = length_ == 0 ? MAP_FAILED
+                              : ::mmap(nullptr, length_, PROT_READ,
+                                       MAP_SHARED, fd, 0);
+    int error = length_ == 0 ? EINVAL : errno;
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      errno = error;
+      fail(path);
+    }
+    data_ = static_cast<const unsigned char *>(data);
+
+    try {
+      validate(path);
+      snapshot::Header header{};
+      std::memcpy(&header, data_, sizeof(header));
+      buckets_ = reinterpret_cast<const std::uint64_t *>(data_ +
+                                                         header.bucketsOffset);
+      records_ = data_ + header.recordsOffset;
+      strings_ = reinterpret_cast<const char *>(data_ + header.stringsOffset);
+      stringsSize_ = header.stringsSize;
+      bucketBits_ = header.bucketBits;
+      size_ = header.size;
+      if (size_ > 0 && !hashMatches(records_)) {
+        throw std::runtime_error("Snapshot written with another Hash: " +
+                                 path);
+      }
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  MappedHashMap(const MappedHashMap &) = delete;
+
+  auto operator=(const MappedHashMap &) -> MappedHashMap & = delete;
+
+  MappedHashMap(MappedHashMap &&other) noexcept
+      : hasher_(std::move(other.hasher_)),
+        keyEqual_(std::move(other.keyEqual_)),
+        data_(std::exchange(other.data_, nullptr)),
+        length_(other.length_),
+        buckets_(other.buckets_),
+        records_(other.records_),
+        strings_(other.strings_),
+        stringsSize_(other.stringsSize_),
+        bucketBits_(other.bucketBits_),
+        size_(std::exchange(other.size_, 0)) {}
+
+  auto operator=(MappedHashMap &&other) noexcept -> MappedHashMap & {
+    if (this != &other) {
+      release();
+      hasher_ = std::move(other.hasher_);
+      keyEqual_ = std::move(other.keyEqual_);
+      data_ = std::exchange(other.data_, nullptr);
+      length_ = other.length_;
+      buckets_ = other.buckets_;
+      records_ = other.records_;
+      strings_ = other.strings_;
+      stringsSize_ = other.stringsSize_;
+      bucketBits_ = other.bucketBits_;
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  ~MappedHashMap() { release(); }
+
+  auto Get(const K &key) const noexcept -> std::optional<value_view> {
+    const unsigned char *record = findRecord(key);
+    return record == nullptr ? std::nullopt
+                             : std::make_optional(valueAt(record));
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Get(const Q &key) const noexcept -> std::optional<value_view> {
+    const unsigned char *record = findRecord(key);
+    return record == nullptr ? std::nullopt
+                             : std::make_optional(valueAt(record));
+  }
+
+  auto Contain(const K &key) const noexcept -> bool {
+    return findRecord(key) != nullptr;
+  }
+
+  template <typename Q, std::enable_if_t<is_key_like<Q>::value, int> = 0>
+  auto Contain(const Q &key) const noexcept -> bool {
+    return findRecord(key) != nullptr;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+  [[nodiscard]] auto bucketCount() const noexcept -> std::size_t {
+    return std::size_t{1} << bucketBits_;
+  }
+};
+
+}  // namespace JAVA
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace JAVA {
+
+/**
+ * Binary encoding of a T for HashMap::Serialize and Deserialize. encode
+ * appends value to out, decode takes one value off the front of in and
+ * returns std::nullopt if in does not start with a valid encoding.
+ *
+ * Integers are zigzag LEB128 varints, other trivially copyable types are
+ * copied byte for byte and std::string is its varint length followed by its
+ * characters. Pointers have no Codec, the bytes of an address are of no use
+ * to the process reading them. Other types need a specialization of Codec,
+ * or codecs passed to Serialize and Deserialize explicitly.
+ */
+template <typename T, typename = void>
+struct Codec;
+
+namespace serialization {
+
+// a byte with the high bit set is followed by more bytes of the same varint
+constexpr static std::uint8_t VARINT_MORE = 0x80;
+
+constexpr static std::uint8_t VARINT_BITS = 7;
+
+inline auto putVarint(std::uint64_t n, std::string &out) -> void {
+  while (n >= VARINT_MORE) {
+    out.push_back(static_cast<char>(n | VARINT_MORE));
+    n >>= VARINT_BITS;
+  }
+  out.push_back(static_cast<char>(n));
+}
+
+inline auto getVarint(std::string_view &in) noexcept
+    -> std::optional<std::uint64_t> {
+  std::uint64_t n = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (unsigned shift = 0; shift < 64 && !in.empty(); shift += VARINT_BITS) {
+    auto byte = static_cast<std::uint8_t>(in.front());
+    in.remove_prefix(1);
+    // the tenth byte only has room for bit 63
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (shift == 63 && byte > 1) {
+      return std::nullopt;
+    }
+    n |= static_cast<std::uint64_t>(byte & ~VARINT_MORE) << shift;
+    if ((byte & VARINT_MORE) == 0) {
+      return n;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace serialization
+
+template <typename T>
+struct Codec<T, std::enable_if_t<std::is_integral_v<T>>> {
+  static auto encode(T value, std::string &out) -> void {
+    if constexpr (std::is_signed_v<T>) {
+      // zigzag, so small negative numbers stay short
+      auto n = static_cast<std::int64_t>(value);
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      serialization::putVarint((static_cast<std::uint64_t>(n) << 1) ^
+                                   static_cast<std::uint64_t>(n >> 63),
+                               out);
+    } else {
+      serialization::putVarint(static_cast<std::uint64_t>(value), out);
+    }
+  }
+
+  static auto decode(std::string_view &in) noexcept -> std::optional<T> {
+    std::optional<std::uint64_t> n = serialization::getVarint(in);
+    if (!n.has_value()) {
+      return std::nullopt;
+    }
+    if constexpr (std::is_signed_v<T>) {
+      auto value = static_cast<std::int64_t>((*n >> 1) ^ (~(*n & 1) + 1));
+      if (value < std::numeric_limits<T>::min() ||
+          value > std::numeric_limits<T>::max()) {
+        return std::nullopt;
+      }
+      return static_cast<T>(value);
+    } else {
+      if (*n > std::numeric_limits<T>::max()) {
+        return std::nullopt;
+      }
+      return static_cast<T>(*n);
+    }
+  }
+};
+
+template <typename T>
+struct Codec<T, std::enable_if_t<!std::is_integral_v<T> &&
+                                 !std::is_pointer_v<T> &&
+                                 !std::is_member_pointer_v<T> &&
+                                 std::is_trivially_copyable_v<T> &&
+                                 std::is_default_constructible_v<T>>> {
+  static auto encode(const T &value, std::string &out) -> void {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  static auto decode(std::string_view &in) noexcept -> std::optional<T> {
+    if (in.size() < sizeof(T)) {
+      return std::nullopt;
+    }
+    std::optional<T> value(std::in_place);
+    std::memcpy(&*value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return value;
+  }
+};
+
+template <>
+struct Codec<std::string> {
+  static auto encode(const std::string &value, std::string &out) -> void {
+    serialization::putVarint(value.size(), out);
+    out.append(value);
+  }
+
+  static auto decode(std::string_view &in) -> std::optional<std::string> {
+    std::optional<std::uint64_t> length = serialization::getVarint(in);
+    if (!length.has_value() || *length > in.size()) {
+      return std::nullopt;
+    }
+    std::string value(in.substr(0, *length));
+    in.remove_prefix(*length);
+    return value;
+  }
+};
+
+/**
+ * Framed stream of HashMap entries written by HashMap::Serialize:
+ *
+ *   MAGIC, varint VERSION
+ *   frames: varint entry count, varint byte length, the entries
+ *   an empty frame (count 0, length 0) at the end
+ *
+ * Every entry is its key and then its value in their codecs. Frames are cut
+ * at about FRAME_BYTES, so neither side holds more than a frame of encoded
+ * data at once, and a reader can insert the entries of a frame while the
+ * next one is still on its way. An entry too large to stay under
+ * MAX_FRAME_BYTES with the ones before it gets a frame of its own.
+ */
+namespace serialization {
+
+constexpr static std::string_view MAGIC = "JHMS";
+
+constexpr static std::uint64_t VERSION = 1;
+
+constexpr static std::size_t FRAME_BYTES = 1 << 16;
+
+// frames of more than one entry larger than this are taken as corrupt input
+// rather than allocated, it leaves the entry that crosses FRAME_BYTES room to
+// overshoot the cut
+constexpr static std::uint64_t MAX_FRAME_BYTES = 4 * FRAME_BYTES;
+
+[[noreturn]] inline auto malformed() -> void {
+  throw std::runtime_error("Malformed HashMap stream");
+}
+
+/**
+ * Encodes the entries forEach(fn) passes to fn(key, value) and hands the
+ * encoded bytes to sink(data, size) a frame at a time.
+ */
+template <typename KeyCodec, typename ValueCodec, typename ForEach,
+          typename Sink>
+auto write(ForEach &&forEach, Sink &&sink) -> void {
+  std::string header(MAGIC);
+  putVarint(VERSION, header);
+  sink(header.data(), header.size());
+
+  std::string frame;
+  std::string prefix;
+  std::uint64_t count = 0;
+  auto flush = [&]() {
+    prefix.clear();
+    putVarint(count, prefix);
+    putVarint(frame.size(), prefix);
+    sink(prefix.data(), prefix.size());
+    sink(frame.data(), frame.size());
+    frame.clear();
+    count = 0;
+  };
+
+  frame.reserve(FRAME_BYTES);
+  std::forward<ForEach>(forEach)([&](const auto &key, const auto &value) {
+    std::size_t mark = frame.size();
+    KeyCodec::encode(key, frame);
+    ValueCodec::encode(value, frame);
+    ++count;
+    if (frame.size() < FRAME_BYTES) {
+      return;
+    }
+    if (frame.size() > MAX_FRAME_BYTES && count > 1) {
+      // the entries before it go first, the entry gets a frame of its own
+      std::string entry = frame.substr(mark);
+      frame.resize(mark);
+      --count;
+      flush();
+      frame = std::move(entry);
+      count = 1;
+    }
+    flush();
+  });
+  if (count != 0) {
+    flush();
+  }
+  flush();
+}
+
+/**
+ * Decodes a stream written by write, frame by frame, and calls
+ * fn(key, value) with every entry as soon as its frame has been read.
+ * source(data, size) has to fill data with the next size bytes and return
+ * false if there are not that many. Returns the number of entries.
+ *
+ * Throws std::runtime_error if the stream is malformed or ends early.
+ */
+template <typename K, typename V, typename KeyCodec, typename ValueCodec,
+          typename Source, typename Fn>
+auto read(Source &&source, Fn &&fn) -> std::size_t {
+  // varints are read a byte at a time, they are only found outside frames
+  auto readVarint = [&source]() -> std::uint64_t {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    std::array<char, 10> bytes{};
+    std::size_t n = 0;
+    do {
+      if (n == bytes.size() || !source(&bytes[n], 1)) {
+        malformed();
+      }
+    } while ((static_cast<std::uint8_t>(bytes[n++]) & VARINT_MORE) != 0);
+    std::string_view in(bytes.data(), n);
+    std::optional<std::uint64_t> value = getVarint(in);
+    if (!value.has_value()) {
+      malformed();
+    }
+    return *value;
+  };
+
+  std::string magic(MAGIC.size(), '\0');
+  if (!source(magic.data(), magic.size()) || magic != MAGIC ||
+      readVarint() != VERSION) {
+    malformed();
+  }
+
+  std::size_t entries = 0;
+  std::string frame;
+  for (;;) {
+    std::uint64_t count = readVarint();
+    std::uint64_t length = readVarint();
+    if (count == 0) {
+      if (length != 0) {
+        malformed();
+      }
+      return entries;
+    }
+    // every entry takes at least a byte
+    if (count > length || (count > 1 && length > MAX_FRAME_BYTES)) {
+      malformed();
+    }
+    // a frame of a single entry may be larger, it is read in pieces so that
+    // a corrupt length runs into the end of the stream before much is
+    // allocated
+    frame.clear();
+    while (frame.size() < length) {
+      std::size_t at = frame.size();
+      auto n = static_cast<std::size_t>(
+          std::min<std::uint64_t>(length - at, MAX_FRAME_BYTES));
+      frame.resize(at + n);
+      if (!source(frame.data() + at, n)) {
+        malformed();
+      }
+    }
+    std::string_view in(frame);
+    for (std::uint64_t i = 0; i < count; i++) {
+      std::optional<K> key = KeyCodec::decode(in);
+      if (!key.has_value()) {
+        malformed();
+      }
+      std::optional<V> value = ValueCodec::decode(in);
+      if (!value.has_value()) {
+        malformed();
+      }
+      fn(std::move(*key), std::move(*value));
+    }
+    if (!in.empty()) {
+      malformed();
+    }
+    entries += count;
+  }
+}
+
+/**
+ * Sources and sinks for streams and in-memory buffers.
+ */
+inline auto streamSink(std::ostream &out) {
+  return [&out](const char *data, std::size_t size) {
+    out.write(data, static_cast<std::streamsize>(size));
+  };
+}
+
+inline auto bufferSink(std::string &buffer) {
+  return [&buffer](const char *data, std::size_t size) {
+    buffer.append(data, size);
+  };
+}
+
+inline auto streamSource(std::istream &in) {
+  return [&in](char *data, std::size_t size) -> bool {
+    in.read(data, static_cast<std::streamsize>(size));
+    return static_cast<std::size_t>(in.gcount()) == size;
+  };
+}
+
+inline auto bufferSource(std::string_view &buffer) {
+  return [&buffer](char *data, std::size_t size) -> bool {
+    if (buffer.size() < size) {
+      return false;
+    }
+    std::memcpy(data, buffer.data(), size);
+    buffer.remove_prefix(size);
+    return true;
+  };
+}
+
+}  // namespace serialization
+
+}  // namespace JAVA
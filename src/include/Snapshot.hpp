@@ -0,0 +1,327 @@
+#pragma once
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace JAVA {
+
+/**
+ * File format of HashMap::SaveSnapshot, read by MappedHashMap. Everything is
+ * addressed by offsets from the start of the file, so the file can be
+ * mapped anywhere and used in place:
+ *
+ *   Header
+ *   buckets: (1 << bucketBits) + 1 uint64, bucket b holds the records
+ *            [buckets[b], buckets[b + 1])
+ *   records: size records of recordSize bytes, grouped by bucket
+ *   strings: the characters of the std::string keys and values
+ *
+ * A record is the 64-bit hash code of its key followed by the key and the
+ * value, each one either stored as is or, for std::string, as a StringRef
+ * into the strings section. Sections start at multiples of SECTION_ALIGN.
+ * The format is that of the machine writing it, and the hash codes are
+ * those of the Hash of the map, so both have to match when reading.
+ */
+namespace snapshot {
+
+// "JAVAHMAP"
+constexpr static std::uint64_t MAGIC = 0x50414D484156414AULL;
+
+constexpr static std::uint32_t VERSION = 1;
+
+constexpr static std::size_t SECTION_ALIGN = 64;
+
+constexpr static std::uint64_t BUCKET_MIX = 0x9E3779B97F4A7C15ULL;
+
+template <typename T>
+struct is_string : std::is_same<T, std::string> {};
+
+/**
+ * Types a snapshot can hold: trivially copyable types, copied byte for
+ * byte, and std::string. Pointers are trivially copyable too, but the
+ * addresses they hold mean nothing in another process.
+ */
+template <typename T>
+constexpr static bool is_storable =
+    (std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> &&
+     !std::is_member_pointer_v<T>) ||
+    is_string<T>::value;
+
+/**
+ * Place of a std::string in the strings section.
+ */
+struct StringRef {
+  std::uint64_t offset;
+
+  std::uint64_t length;
+};
+
+template <typename T>
+using Field = std::conditional_t<is_string<T>::value, StringRef, T>;
+
+struct Header {
+  std::uint64_t magic;
+
+  std::uint32_t version;
+
+  std::uint32_t bucketBits;
+
+  std::uint64_t size;
+
+  // sizes of the key, value and record types, to reject the snapshot of a
+  // map of other types
+  std::uint64_t keySize;
+
+  std::uint64_t valueSize;
+
+  std::uint64_t recordSize;
+
+  std::uint64_t bucketsOffset;
+
+  std::uint64_t recordsOffset;
+
+  std::uint64_t stringsOffset;
+
+  std::uint64_t stringsSize;
+};
+
+constexpr auto alignUp(std::size_t n, std::size_t align) noexcept
+    -> std::size_t {
+  return (n + align - 1) / align * align;
+}
+
+/**
+ * Where the hash code, key and value sit in a record of K and V.
+ */
+template <typename K, typename V>
+struct Layout {
+  static_assert(alignof(Field<K>) <= SECTION_ALIGN &&
+                    alignof(Field<V>) <= SECTION_ALIGN,
+                "K and V must be aligned to at most 64 bytes");
+
+  constexpr static std::size_t KEY_OFFSET =
+      alignUp(sizeof(std::uint64_t), alignof(Field<K>));
+
+  constexpr static std::size_t VALUE_OFFSET =
+      alignUp(KEY_OFFSET + sizeof(Field<K>), alignof(Field<V>));
+
+  constexpr static std::size_t RECORD_SIZE =
+      alignUp(VALUE_OFFSET + sizeof(Field<V>),
+              std::max({alignof(std::uint64_t), alignof(Field<K>),
+                        alignof(Field<V>)}));
+};
+
+/**
+ * Bucket of hashCode in a table of 1 << bits buckets. Fibonacci hashing,
+ * so that even identity hash codes spread over the high bits.
+ */
+constexpr auto bucketOf(std::uint64_t hashCode, std::uint32_t bits) noexcept
+    -> std::uint64_t {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  return bits == 0 ? 0 : (hashCode * BUCKET_MIX) >> (64 - bits);
+}
+
+/**
+ * Writes the sections of a snapshot described by header to path, records
+ * in the order of order.
+ */
+template <typename K, typename V, typename Entry>
+auto writeSections(const std::string &path, const Header &header,
+                   const std::vector<std::uint64_t> &buckets,
+                   const std::vector<const Entry *> &order) -> void {
+  using L = Layout<K, V>;
+
+  std::ofstream out;
+  out.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+  out.open(path, std::ios_base::binary | std::ios_base::trunc);
+
+  std::uint64_t written = 0;
+  auto put = [&out, &written](const void *data, std::size_t n) {
+    out.write(static_cast<const char *>(data),
+              static_cast<std::streamsize>(n));
+    written += n;
+  };
+  auto padTo = [&put, &written](std::uint64_t offset) {
+    static constexpr std::array<char, SECTION_ALIGN> ZEROS{};
+    put(ZEROS.data(), offset - written);
+  };
+
+  put(&header, sizeof(Header));
+  padTo(header.bucketsOffset);
+  put(buckets.data(), buckets.size() * sizeof(std::uint64_t));
+  padTo(header.recordsOffset);
+
+  // records go out in chunks, the strings they refer to are laid out in the
+  // same order afterwards
+  constexpr std::size_t CHUNK_RECORDS = (1 << 16) / L::RECORD_SIZE + 1;
+  std::vector<unsigned char> chunk(CHUNK_RECORDS * L::RECORD_SIZE);
+  std::uint64_t stringsSize = 0;
+  auto field = [&stringsSize](unsigned char *at, const auto &item) {
+    using T = std::decay_t<decltype(item)>;
+    if constexpr (is_string<T>::value) {
+      StringRef ref{stringsSize, item.size()};
+      std::memcpy(at, &ref, sizeof(StringRef));
+      stringsSize += item.size();
+    } else {
+      std::memcpy(at, &item, sizeof(T));
+    }
+  };
+  for (std::size_t base = 0; base < order.size(); base += CHUNK_RECORDS) {
+    std::size_t n = std::min(CHUNK_RECORDS, order.size() - base);
+    std::fill(chunk.begin(), chunk.end(), 0);
+    for (std::size_t i = 0; i < n; i++) {
+      const Entry &entry = *order[base + i];
+      unsigned char *record = chunk.data() + i * L::RECORD_SIZE;
+      std::memcpy(record, &entry.hashCode, sizeof(std::uint64_t));
+      field(record + L::KEY_OFFSET, *entry.key);
+      field(record + L::VALUE_OFFSET, *entry.value);
+    }
+    put(chunk.data(), n * L::RECORD_SIZE);
+  }
+  padTo(header.stringsOffset);
+
+  if constexpr (is_string<K>::value || is_string<V>::value) {
+    for (const Entry *entry : order) {
+      if constexpr (is_string<K>::value) {
+        put(entry->key->data(), entry->key->size());
+      }
+      if constexpr (is_string<V>::value) {
+        put(entry->value->data(), entry->value->size());
+      }
+    }
+  }
+  out.close();
+}
+
+[[noreturn]] inline auto fail(const std::string &path) -> void {
+  throw std::ios_base::failure(
+      path, std::error_code(errno, std::generic_category()));
+}
+
+/**
+ * Writes a snapshot of size entries to path. forEach(fn) has to call
+ * fn(hashCode, key, value) once for every entry.
+ *
+ * The snapshot is written to a temporary file next to path, synced and then
+ * renamed over path, so a MappedHashMap still mapping the old file keeps
+ * reading it and a crash never leaves a partly written snapshot at path.
+ *
+ * Throws std::ios_base::failure if the file cannot be written.
+ */
+template <typename K, typename V, typename ForEach>
+auto write(const std::string &path, std::size_t size, ForEach &&forEach)
+    -> void {
+  static_assert(is_storable<K> && is_storable<V>,
+                "K and V must be trivially copyable non-pointers or std::string");
+  using L = Layout<K, V>;
+
+  struct Entry {
+    std::uint64_t hashCode;
+
+    const K *key;
+
+    const V *value;
+  };
+
+  // one bucket per entry at most
+  std::uint32_t bits = 0;
+  while ((std::uint64_t{1} << bits) < size) {
+    ++bits;
+  }
+  std::size_t bucketCount = std::size_t{1} << bits;
+
+  std::vector<Entry> entries;
+  entries.reserve(size);
+  std::forward<ForEach>(forEach)(
+      [&entries](std::size_t hashCode, const K &key, const V &value) {
+        entries.push_back(Entry{hashCode, &key, &value});
+      });
+
+  // counting sort by bucket, buckets[b] ends up as the first record of b
+  std::vector<std::uint64_t> buckets(bucketCount + 1, 0);
+  for (const Entry &entry : entries) {
+    ++buckets[bucketOf(entry.hashCode, bits) + 1];
+  }
+  for (std::size_t b = 0; b < bucketCount; b++) {
+    buckets[b + 1] += buckets[b];
+  }
+  std::vector<const Entry *> order(entries.size());
+  {
+    std::vector<std::uint64_t> next(buckets.begin(), buckets.end() - 1);
+    for (const Entry &entry : entries) {
+      order[next[bucketOf(entry.hashCode, bits)]++] = &entry;
+    }
+  }
+
+  Header header{};
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.bucketBits = bits;
+  header.size = entries.size();
+  header.keySize = sizeof(K);
+  header.valueSize = sizeof(V);
+  header.recordSize = L::RECORD_SIZE;
+  header.bucketsOffset = alignUp(sizeof(Header), SECTION_ALIGN);
+  header.recordsOffset =
+      alignUp(header.bucketsOffset + buckets.size() * sizeof(std::uint64_t),
+              SECTION_ALIGN);
+  header.stringsOffset = alignUp(
+      header.recordsOffset + entries.size() * L::RECORD_SIZE, SECTION_ALIGN);
+  for (const Entry &entry : entries) {
+    if constexpr (is_string<K>::value) {
+      header.stringsSize += entry.key->size();
+    }
+    if constexpr (is_string<V>::value) {
+      header.stringsSize += entry.value->size();
+    }
+  }
+
+  std::string tmpPath = path + ".XXXXXX";
+  int fd = ::mkstemp(tmpPath.data());
+  if (fd < 0) {
+    fail(path);
+  }
+  try {
+    // mkstemp creates the file readable by its owner only
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    if (::fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0) {
+      fail(tmpPath);
+    }
+    writeSections<K, V>(tmpPath, header, buckets, order);
+    if (::fsync(fd) != 0) {
+      fail(tmpPath);
+    }
+    if (::close(std::exchange(fd, -1)) != 0) {
+      fail(tmpPath);
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+      fail(path);
+    }
+  } catch (...) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    std::remove(tmpPath.c_str());
+    throw;
+  }
+}
+
+}  // namespace snapshot
+
+}  // namespace JAVA
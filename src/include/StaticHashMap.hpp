@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "Hasher.hpp"
+
+namespace JAVA {
+
+/**
+ * Map of at most N entries whose buckets and nodes are arrays inside the
+ * object, for paths that must not touch the heap. Nothing is allocated and
+ * nothing throws after construction: the table never resizes, and TryPut
+ * returns false instead of growing when all N nodes hold entries.
+ *
+ * Like HashMap every bucket is a chain of nodes, but the links are indices
+ * into the node array, so the map can be copied as it is and, when K and V
+ * are literal types, built and queried at compile time:
+ *
+ *   constexpr StaticHashMap<std::string_view, int, 4> COLORS{
+ *       {"red", 1}, {"green", 2}, {"blue", 3}};
+ *   static_assert(COLORS.Get("green") == 2);
+ *
+ * Hash must then be usable in constant expressions, as StaticHash is. K and
+ * V must be default constructible, removed entries are reset to K() and
+ * V(). The table has a bucket per node, rounded up to a power of two.
+ */
+template <typename K, typename V, std::size_t N, typename Hash = StaticHash,
+          typename KeyEqual = std::equal_to<>>
+class StaticHashMap {
+  static_assert(N > 0, "N must be positive");
+
+  static_assert(N < std::numeric_limits<std::uint32_t>::max(),
+                "N must fit in 32 bits");
+
+  static_assert(std::is_default_constructible_v<K> &&
+                    std::is_default_constructible_v<V>,
+                "K and V must be default constructible");
+
+ public:
+  using key_type = K;
+
+  using mapped_type = V;
+
+  using size_type = std::size_t;
+
+ private:
+  // the smallest type that holds every position plus one
+  using Index = std::conditional_t<
+      (N < std::numeric_limits<std::uint8_t>::max()), std::uint8_t,
+      std::conditional_t<(N < std::numeric_limits<std::uint16_t>::max()),
+                         std::uint16_t, std::uint32_t>>;
+
+  // links hold the position of a node plus one, so that zero initialized
+  // buckets and links are empty
+  constexpr static Index NONE = 0;
+
+  constexpr static int HASHCODE_REMOVE_SIZE = 16;
+
+  static constexpr auto bucketsFor(std::size_t n) noexcept -> std::size_t {
+    std::size_t buckets = 1;
+    while (buckets < n) {
+      buckets <<= 1;
+    }
+    return buckets;
+  }
+
+  constexpr static std::size_t BUCKETS = bucketsFor(N);
+
+  struct Node {
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    K key{};
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    V value{};
+
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    Index next = NONE;
+  };
+
+  Hash hasher_;
+
+  KeyEqual keyEqual_;
+
+  std::array<Index, BUCKETS> buckets_{};
+
+  std::array<Node, N> nodes_{};
+
+  // nodes given back by Del, linked through next
+  Index freeList_ = NONE;
+
+  // nodes taken from the untouched tail of nodes_ so far
+  std::size_t carved_ = 0;
+
+  std::size_t size_ = 0;
+
+  // not constexpr, so that building a constant map with more than N
+  // entries does not compile
+  static auto tooManyEntries() noexcept -> void {}
+
+  template <typename Q>
+  constexpr auto bucketOf(const Q &key) const noexcept -> std::size_t {
+    auto h = static_cast<std::size_t>(hasher_(key));
+    if constexpr (!detail::is_avalanching<Hash>::value) {
+      h ^= h >> HASHCODE_REMOVE_SIZE;
+    }
+    return h & (BUCKETS - 1);
+  }
+
+  constexpr auto findIndex(const K &key) const noexcept -> Index {
+    Index i = buckets_[bucketOf(key)];
+    while (i != NONE && !keyEqual_(nodes_[i - 1].key, key)) {
+      i = nodes_[i - 1].next;
+    }
+    return i;
+  }
+
+  constexpr auto allocate() noexcept -> Index {
+    if (freeList_ != NONE) {
+      Index i = freeList_;
+      freeList_ = nodes_[i - 1].next;
+      return i;
+    }
+    if (carved_ < N) {
+      return static_cast<Index>(++carved_);
+    }
+    return NONE;
+  }
+
+  template <typename KeyArg, typename ValueArg>
+  constexpr auto putVal(KeyArg &&key, ValueArg &&value) noexcept -> bool {
+    std::size_t b = bucketOf(key);
+    for (Index i = buckets_[b]; i != NONE; i = nodes_[i - 1].next) {
+      if (keyEqual_(nodes_[i - 1].key, key)) {
+        nodes_[i - 1].value = std::forward<ValueArg>(value);
+        return true;
+      }
+    }
+    Index i = allocate();
+    if (i == NONE) {
+      return false;
+    }
+    Node &node = nodes_[i - 1];
+    node.key = std::forward<KeyArg>(key);
+    node.value = std::forward<ValueArg>(value);
+    node.next = buckets_[b];
+    buckets_[b] = i;
+    ++size_;
+    return true;
+  }
+
+ public:
+  constexpr StaticHashMap() noexcept = default;
+
+  constexpr explicit StaticHashMap(
+      const Hash &hasher, const KeyEqual &keyEqual = KeyEqual()) noexcept
+      : hasher_(hasher), keyEqual_(keyEqual) {}
+
+  /**
+   * Builds the map from entries, later entries overwriting the values of
+   * earlier ones with the same key. More than N distinct keys do not
+   * compile in a constant expression, at run time the keys past the N-th
+   * are dropped.
+   */
+  constexpr StaticHashMap(std::initializer_list<std::pair<K, V>> entries,
+                          const Hash &hasher = Hash(),
+                          const KeyEqual &keyEqual = KeyEqual()) noexcept
+      : hasher_(hasher), keyEqual_(keyEqual) {
+    for (const std::pair<K, V> &entry : entries) {
+      if (!putVal(entry.first, entry.second)) {
+        tooManyEntries();
+      }
+    }
+  }
+
+  /**
+   * Inserts value under key, or assigns it to the existing value. Returns
+   * false and leaves the map unchanged if key is absent and the map is
+   * full.
+   */
+  template <typename ValueType>
+  constexpr auto TryPut(const K &key, ValueType &&value) noexcept -> bool {
+    return putVal(key, std::forward<ValueType>(value));
+  }
+
+  template <typename ValueType>
+  constexpr auto TryPut(K &&key, ValueType &&value) noexcept -> bool {
+    return putVal(std::move(key), std::forward<ValueType>(value));
+  }
+
+  constexpr auto Get(const K &key) const noexcept -> std::optional<V> {
+    Index i = findIndex(key);
+    return i == NONE ? std::nullopt : std::optional<V>(nodes_[i - 1].value);
+  }
+
+  /**
+   * Returns a pointer to the value of key, or nullptr if key is absent. The
+   * pointer stays valid until key is removed.
+   */
+  constexpr auto Find(const K &key) noexcept -> V * {
+    Index i = findIndex(key);
+    return i == NONE ? nullptr : &nodes_[i - 1].value;
+  }
+
+  constexpr auto Find(const K &key) const noexcept -> const V * {
+    Index i = findIndex(key);
+    return i == NONE ? nullptr : &nodes_[i - 1].value;
+  }
+
+  constexpr auto GetOr(const K &key, const V &defaultValue) const noexcept
+      -> V {
+    const V *value = Find(key);
+    return value == nullptr ? defaultValue : *value;
+  }
+
+  constexpr auto Contain(const K &key) const noexcept -> bool {
+    return findIndex(key) != NONE;
+  }
+
+  constexpr auto Del(const K &key) noexcept -> bool {
+    Index *link = &buckets_[bucketOf(key)];
+    while (*link != NONE) {
+      Index i = *link;
+      Node &node = nodes_[i - 1];
+      if (keyEqual_(node.key, key)) {
+        *link = node.next;
+        node.key = K();
+        node.value = V();
+        node.next = freeList_;
+        freeList_ = i;
+        --size_;
+        return true;
+      }
+      link = &node.next;
+    }
+    return false;
+  }
+
+  constexpr auto Clear() noexcept -> void {
+    for (std::size_t i = 0; i < carved_; i++) {
+      nodes_[i] = Node();
+    }
+    buckets_ = {};
+    freeList_ = NONE;
+    carved_ = 0;
+    size_ = 0;
+  }
+
+  /**
+   * Calls fn(key, value) with every entry, in bucket order.
+   */
+  template <typename Fn>
+  constexpr auto ForEach(Fn &&fn) -> void {
+    for (Index head : buckets_) {
+      for (Index i = head; i != NONE; i = nodes_[i - 1].next) {
+        fn(static_cast<const K &>(nodes_[i - 1].key), nodes_[i - 1].value);
+      }
+    }
+  }
+
+  template <typename Fn>
+  constexpr auto ForEach(Fn &&fn) const -> void {
+    for (Index head : buckets_) {
+      for (Index i = head; i != NONE; i = nodes_[i - 1].next) {
+        fn(nodes_[i - 1].key, nodes_[i - 1].value);
+      }
+    }
+  }
+
+  [[nodiscard]] constexpr auto size() const noexcept -> std::size_t {
+    return size_;
+  }
+
+  [[nodiscard]] constexpr auto empty() const noexcept -> bool {
+    return size_ == 0;
+  }
+
+  [[nodiscard]] constexpr auto full() const noexcept -> bool {
+    return size_ == N;
+  }
+
+  [[nodiscard]] static constexpr auto capacity() noexcept -> std::size_t {
+    return N;
+  }
+
+  [[nodiscard]] static constexpr auto bucketCount() noexcept -> std::size_t {
+    return BUCKETS;
+  }
+};
+
+}  // namespace JAVA
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace JAVA {
+
+/**
+ * Operations a HashMap reports to its HashMapObserver.
+ */
+enum class MapOp : std::uint8_t { GET, PUT, DEL };
+
+/**
+ * Histogram of non-negative values with a bounded relative error, in the
+ * manner of HdrHistogram. Values below SUB_BUCKETS get a bucket each, every
+ * power of two above that is split into SUB_BUCKETS / 2 buckets, so a value
+ * is off by at most 1 / (SUB_BUCKETS / 2) of itself in the percentiles.
+ * Recording is a few shifts and an increment and never allocates.
+ */
+class LatencyHistogram {
+ public:
+  constexpr static unsigned SUB_BUCKET_BITS = 5;
+
+  constexpr static std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+
+ private:
+  constexpr static std::size_t HALF_BUCKETS = SUB_BUCKETS / 2;
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  constexpr static unsigned VALUE_BITS = 64;
+
+  constexpr static std::size_t BUCKETS =
+      SUB_BUCKETS + (VALUE_BITS - SUB_BUCKET_BITS) * HALF_BUCKETS;
+
+  std::array<std::uint64_t, BUCKETS> counts_{};
+
+  std::uint64_t count_ = 0;
+
+  std::uint64_t min_ = std::numeric_limits<std::uint64_t>::max();
+
+  std::uint64_t max_ = 0;
+
+  // for the mean, wraps around only after 2^64 of the recorded unit
+  std::uint64_t sum_ = 0;
+
+  static constexpr auto indexOf(std::uint64_t value) noexcept -> std::size_t {
+    if (value < SUB_BUCKETS) {
+      return static_cast<std::size_t>(value);
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto exponent = static_cast<unsigned>(63 - __builtin_clzll(value));
+    unsigned shift = exponent - SUB_BUCKET_BITS + 1;
+    return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * HALF_BUCKETS +
+           static_cast<std::size_t>((value >> shift) - HALF_BUCKETS);
+  }
+
+  /**
+   * Largest value that lands in bucket index.
+   */
+  static constexpr auto highestOf(std::size_t index) noexcept
+      -> std::uint64_t {
+    if (index < SUB_BUCKETS) {
+      return index;
+    }
+    std::size_t exponent = (index - SUB_BUCKETS) / HALF_BUCKETS;
+    std::size_t sub = (index - SUB_BUCKETS) % HALF_BUCKETS + HALF_BUCKETS;
+    std::size_t shift = exponent + 1;
+    return ((static_cast<std::uint64_t>(sub) + 1) << shift) - 1;
+  }
+
+ public:
+  auto Record(std::uint64_t value) noexcept -> void {
+    ++counts_[indexOf(value)];
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  auto Record(std::chrono::nanoseconds latency) noexcept -> void {
+    Record(static_cast<std::uint64_t>(std::max<std::int64_t>(
+        0, static_cast<std::int64_t>(latency.count()))));
+  }
+
+  auto Merge(const LatencyHistogram &other) noexcept -> void {
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+      counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  auto Reset() noexcept -> void { *this = LatencyHistogram(); }
+
+  [[nodiscard]] auto Count() const noexcept -> std::uint64_t { return count_; }
+
+  [[nodiscard]] auto Min() const noexcept -> std::uint64_t {
+    return count_ == 0 ? 0 : min_;
+  }
+
+  [[nodiscard]] auto Max() const noexcept -> std::uint64_t { return max_; }
+
+  [[nodiscard]] auto Mean() const noexcept -> double {
+    return count_ == 0
+               ? 0
+               : static_cast<double>(sum_) / static_cast<double>(count_);
+  }
+
+  /**
+   * Smallest recorded value, up to the precision of its bucket, that
+   * percentile percent of the recorded values do not exceed. percentile is
+   * clamped to [0, 100], an empty histogram gives 0.
+   */
+  [[nodiscard]] auto Percentile(double percentile) const noexcept
+      -> std::uint64_t {
+    if (count_ == 0) {
+      return 0;
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    double clamped = std::clamp(percentile, 0.0, 100.0);
+    // rounded up, so that e.g. the 99th percentile of three values is the
+    // largest of them
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto rank = static_cast<std::uint64_t>(
+        std::ceil(clamped / 100.0 * static_cast<double>(count_)));
+    rank = std::clamp<std::uint64_t>(rank, 1, count_);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return std::clamp(highestOf(i), Min(), max_);
+      }
+    }
+    return max_;
+  }
+};
+
+/**
+ * Hooks a HashMap calls from its hot paths when built with HASHMAP_TRACE,
+ * see HashMap::SetObserver. Every hook does nothing unless overridden, and
+ * runs on the thread of the operation it reports, inside that operation.
+ */
+class HashMapObserver {
+ public:
+  HashMapObserver() = default;
+
+  HashMapObserver(const HashMapObserver &) = default;
+
+  HashMapObserver(HashMapObserver &&) = default;
+
+  auto operator=(const HashMapObserver &) -> HashMapObserver & = default;
+
+  auto operator=(HashMapObserver &&) -> HashMapObserver & = default;
+
+  virtual ~HashMapObserver() = default;
+
+  /**
+   * A Get, Put or Del (or one of their variants) finished after comparing
+   * the key with probes nodes.
+   */
+  virtual auto OnOperation(MapOp /*op*/, std::size_t /*probes*/,
+                           std::chrono::nanoseconds /*latency*/) -> void {}
+
+  /**
+   * The table went from oldCapacity to newCapacity buckets. For an
+   * incremental resize duration only covers starting it.
+   */
+  virtual auto OnResize(std::size_t /*oldCapacity*/,
+                        std::size_t /*newCapacity*/,
+                        std::chrono::nanoseconds /*duration*/) -> void {}
+
+  /**
+   * The node pool took a new slab of bytes from the allocator.
+   */
+  virtual auto OnSlabAllocate(std::size_t /*bytes*/) -> void {}
+};
+
+/**
+ * Observer that keeps a latency and a probe length histogram per operation,
+ * plus the resizes and slab allocations it has seen. Not synchronized, like
+ * the HashMap it observes.
+ */
+class HistogramObserver : public HashMapObserver {
+ public:
+  struct Operation {
+    // nanoseconds
+    LatencyHistogram latency;
+
+    LatencyHistogram probes;
+  };
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  Operation get;
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  Operation put;
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  Operation del;
+
+  // nanoseconds per resize
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  LatencyHistogram resizes;
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  std::size_t lastCapacity = 0;
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  std::size_t slabs = 0;
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  std::size_t slabBytes = 0;
+
+  auto OnOperation(MapOp op, std::size_t probes,
+                   std::chrono::nanoseconds latency) -> void override {
+    Operation &operation = op == MapOp::GET ? get
+                           : op == MapOp::PUT ? put
+                                              : del;
+    operation.latency.Record(latency);
+    operation.probes.Record(probes);
+  }
+
+  auto OnResize(std::size_t /*oldCapacity*/, std::size_t newCapacity,
+                std::chrono::nanoseconds duration) -> void override {
+    resizes.Record(duration);
+    lastCapacity = newCapacity;
+  }
+
+  auto OnSlabAllocate(std::size_t bytes) -> void override {
+    ++slabs;
+    slabBytes += bytes;
+  }
+};
+
+}  // namespace JAVA
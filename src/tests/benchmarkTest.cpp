@@ -1,123 +1,521 @@
 #include <benchmark/benchmark.h>
 
-#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "../include/ConcurrentHashMap.hpp"
+#include "../include/FlatHashMap.hpp"
 #include "../include/HashMap.hpp"
+#include "../include/MappedHashMap.hpp"
 #include "display.h"
 
 constexpr int NUM_COUNT = 5000000;
 
-auto HashMapBenchmark() noexcept -> void {
-  JAVA::HashMap<int, int> h1;
-
-  for (int i = 0; i < NUM_COUNT; i++) {
-    h1.Put(i, i + 1);
-  }
+template <typename Map>
+static void CustomMissHeavyLookupBenchmark(benchmark::State& state) {
+  // scatter the keys so that neither the buckets nor the nodes are visited
+  // in allocation order
+  auto scatter = [](int i) -> int {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    return static_cast<int>(static_cast<unsigned>(i) * 2654435761U);
+  };
 
+  Map h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h1.Contain(i);
+    h1.Put(scatter(i), i + 1);
   }
 
-  for (int i = NUM_COUNT - 1; i >= 0; i--) {
-    h1.Del(i);
+  for (auto _ : state) {
+    // none of these keys are present
+    for (int i = NUM_COUNT; i < 2 * NUM_COUNT; i++) {
+      benchmark::DoNotOptimize(h1.Contain(scatter(i)));
+    }
   }
+}
 
-  JAVA::HashMap<std::string, std::string> h2;
+// keys longer than the small string buffer, so every std::string built for a
+// lookup goes to the heap
+static auto MakeStringKeys() -> std::vector<std::string> {
+  std::vector<std::string> keys;
+  keys.reserve(NUM_COUNT);
   for (int i = 0; i < NUM_COUNT; i++) {
-    h2.Put(std::to_string(i), std::to_string(i + 1));
+    keys.push_back("benchmark-string-key-" + std::to_string(i));
   }
+  return keys;
+}
 
+static void CustomStringLookupBenchmark(benchmark::State& state) {
+  std::vector<std::string> keys = MakeStringKeys();
+  JAVA::HashMap<std::string, int> h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h2.Contain(std::to_string(i));
+    h1.Put(std::string(keys[i]), i + 1);
   }
+  std::vector<std::string_view> views(keys.begin(), keys.end());
 
-  for (int i = NUM_COUNT - 1; i >= 0; i--) {
-    h2.Del(std::to_string(i));
+  for (auto _ : state) {
+    for (std::string_view view : views) {
+      benchmark::DoNotOptimize(h1.Get(std::string(view)));
+    }
   }
 }
 
-auto StdUnorderedMapBenchmark() noexcept -> void {
-  std::unordered_map<int, int> h1;
-
+static void CustomStringViewLookupBenchmark(benchmark::State& state) {
+  std::vector<std::string> keys = MakeStringKeys();
+  JAVA::HashMap<std::string, int, JAVA::StringHash, std::equal_to<>> h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h1[i] = i + 1;
+    h1.Put(std::string(keys[i]), i + 1);
   }
+  std::vector<std::string_view> views(keys.begin(), keys.end());
+
+  for (auto _ : state) {
+    for (std::string_view view : views) {
+      benchmark::DoNotOptimize(h1.Get(view));
+    }
+  }
+}
 
+/**
+ * Random hits on a map far larger than the last level cache, state.range(0)
+ * keys per call. A batch of 1 is the plain Get loop, larger batches go
+ * through GetMany and overlap their cache misses.
+ */
+template <typename Map>
+static void CustomBatchedLookupBenchmark(benchmark::State& state) {
+  Map h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h1.count(i);
+    h1.Put(i, i + 1);
+  }
+  constexpr int LOOKUPS = 1 << 20;
+  std::mt19937 rng(NUM_COUNT);
+  std::uniform_int_distribution<int> dist(0, NUM_COUNT - 1);
+  std::vector<int> keys(LOOKUPS);
+  for (int& key : keys) {
+    key = dist(rng);
   }
+  auto batch = static_cast<std::size_t>(state.range(0));
+  std::vector<std::optional<int>> values(batch);
 
-  for (int i = NUM_COUNT - 1; i >= 0; i--) {
-    h1.erase(i);
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i + batch <= keys.size(); i += batch) {
+      if (batch == 1) {
+        values[0] = h1.Get(keys[i]);
+      } else {
+        h1.GetMany(&keys[i], batch, values.data());
+      }
+      for (const std::optional<int>& value : values) {
+        sum += *value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
   }
+  state.SetItemsProcessed(state.iterations() * LOOKUPS);
+}
 
-  std::unordered_map<std::string, std::string> h2;
+/**
+ * Same hash as std::hash<int>, declared expensive so that nodes keep caching
+ * the hash code, for comparison with the compact nodes of int keys.
+ */
+struct CachedIntHash : std::hash<int> {
+  using is_expensive = void;
+};
 
-  for (int i = 0; i < NUM_COUNT; i++) {
-    h2[std::to_string(i)] = std::to_string(i + 1);
+/**
+ * Reports the memory a map of NUM_COUNT entries takes per entry.
+ */
+template <typename Map>
+static void CustomBytesPerEntryBenchmark(benchmark::State& state) {
+  for (auto _ : state) {
+    Map h1;
+    for (int i = 0; i < NUM_COUNT; i++) {
+      h1.Put(i, i + 1);
+    }
+    state.counters["bytes/entry"] = static_cast<double>(h1.MemoryUsage()) /
+                                    static_cast<double>(h1.size());
   }
+}
 
-  for (int i = 0; i < NUM_COUNT; i++) {
-    h2.count(std::to_string(i));
+static void CustomBulkLoadBenchmark(benchmark::State& state) {
+  for (auto _ : state) {
+    JAVA::HashMap<int, int> h1;
+    for (int i = 0; i < NUM_COUNT; i++) {
+      h1.Put(i, i + 1);
+    }
+    benchmark::DoNotOptimize(h1.size());
   }
+}
 
-  for (int i = NUM_COUNT - 1; i >= 0; i--) {
-    h2.erase(std::to_string(i));
+static void CustomPresizedBulkLoadBenchmark(benchmark::State& state) {
+  for (auto _ : state) {
+    JAVA::HashMap<int, int> h1;
+    h1.Reserve(NUM_COUNT);
+    for (int i = 0; i < NUM_COUNT; i++) {
+      h1.Put(i, i + 1);
+    }
+    benchmark::DoNotOptimize(h1.size());
   }
 }
 
-auto StdMapBenchmark() noexcept -> void {
-  std::map<int, int> h1;
+// keys looked up right after a restart, spread over the whole map
+constexpr int COLD_START_LOOKUPS = 1000;
+
+/**
+ * What a restarted process pays before it can answer COLD_START_LOOKUPS
+ * lookups when it rebuilds its map with Put.
+ */
+static void CustomRebuildColdStartBenchmark(benchmark::State& state) {
+  for (auto _ : state) {
+    JAVA::HashMap<int, int> h1;
+    for (int i = 0; i < NUM_COUNT; i++) {
+      h1.Put(i, i + 1);
+    }
+    for (int i = 0; i < NUM_COUNT; i += NUM_COUNT / COLD_START_LOOKUPS) {
+      benchmark::DoNotOptimize(h1.Get(i));
+    }
+  }
+}
 
+/**
+ * The same when it maps a snapshot saved before the restart instead. The
+ * file stays in the page cache between iterations.
+ */
+static void CustomSnapshotColdStartBenchmark(benchmark::State& state) {
+  std::string path = (std::filesystem::temp_directory_path() /
+                      "HashMapColdStartBenchmark.snapshot")
+                         .string();
+  {
+    JAVA::HashMap<int, int> h1;
+    for (int i = 0; i < NUM_COUNT; i++) {
+      h1.Put(i, i + 1);
+    }
+    h1.SaveSnapshot(path);
+  }
+  for (auto _ : state) {
+    JAVA::MappedHashMap<int, int> m1(path);
+    for (int i = 0; i < NUM_COUNT; i += NUM_COUNT / COLD_START_LOOKUPS) {
+      benchmark::DoNotOptimize(m1.Get(i));
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+/**
+ * Encoding throughput of Serialize in MB/s of output, for a map of int keys
+ * and values and one of string keys and values.
+ */
+template <typename K, typename V>
+static void CustomSerializeBenchmark(benchmark::State& state) {
+  JAVA::HashMap<K, V> h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h1[i] = i + 1;
+    if constexpr (std::is_same_v<K, std::string>) {
+      h1.Put(std::to_string(i), std::to_string(i + 1));
+    } else {
+      h1.Put(i, i + 1);
+    }
   }
+  std::string buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    h1.Serialize(buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(buffer.size()));
+}
 
+/**
+ * Decoding throughput of Deserialize in MB/s of input, inserting into an
+ * empty map.
+ */
+template <typename K, typename V>
+static void CustomDeserializeBenchmark(benchmark::State& state) {
+  std::string buffer;
+  {
+    JAVA::HashMap<K, V> h1;
+    for (int i = 0; i < NUM_COUNT; i++) {
+      if constexpr (std::is_same_v<K, std::string>) {
+        h1.Put(std::to_string(i), std::to_string(i + 1));
+      } else {
+        h1.Put(i, i + 1);
+      }
+    }
+    h1.Serialize(buffer);
+  }
+  for (auto _ : state) {
+    JAVA::HashMap<K, V> h1;
+    benchmark::DoNotOptimize(h1.Deserialize(buffer));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(buffer.size()));
+}
+
+/**
+ * Builds the same map as CustomBulkLoadBenchmark through the range
+ * constructor, hashing and linking on state.range(0) threads.
+ */
+static void CustomParallelBulkLoadBenchmark(benchmark::State& state) {
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(NUM_COUNT);
   for (int i = 0; i < NUM_COUNT; i++) {
-    h1.count(i);
+    pairs.emplace_back(i, i + 1);
+  }
+  for (auto _ : state) {
+    JAVA::HashMap<int, int> h1;
+    h1.SetParallelism(static_cast<std::size_t>(state.range(0)));
+    h1.BulkLoad(pairs.begin(), pairs.end());
+    benchmark::DoNotOptimize(h1.size());
   }
+}
 
-  for (int i = NUM_COUNT - 1; i >= 0; i--) {
-    h1.erase(i);
+/**
+ * Times every single Put of a bulk load and reports latency percentiles, the
+ * throughput alone hides the inserts that pay for a whole resize.
+ */
+template <typename Map>
+static void CustomPutLatencyBenchmark(benchmark::State& state) {
+  std::vector<std::int64_t> latencies;
+  latencies.reserve(NUM_COUNT);
+  for (auto _ : state) {
+    Map h1;
+    latencies.clear();
+    for (int i = 0; i < NUM_COUNT; i++) {
+      auto start = std::chrono::steady_clock::now();
+      h1.Put(i, i + 1);
+      auto stop = std::chrono::steady_clock::now();
+      latencies.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+              .count());
+    }
+    benchmark::DoNotOptimize(h1.size());
   }
 
-  std::map<std::string, std::string> h2;
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    auto index = static_cast<std::size_t>(
+        p * static_cast<double>(latencies.size() - 1));
+    return static_cast<double>(latencies[index]);
+  };
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  state.counters["p50_ns"] = percentile(0.5);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  state.counters["p99_ns"] = percentile(0.99);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  state.counters["p99.9_ns"] = percentile(0.999);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  state.counters["p99.99_ns"] = percentile(0.9999);
+  state.counters["max_ns"] = static_cast<double>(latencies.back());
+}
 
+static void CustomHashMapIterationBenchmark(benchmark::State& state) {
+  JAVA::HashMap<int, int> h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h2[std::to_string(i)] = std::to_string(i + 1);
+    h1.Put(i, i + 1);
   }
 
+  for (auto _ : state) {
+    long long sum = 0;
+    for (auto [key, value] : h1) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+static void CustomHashMapForEachBenchmark(benchmark::State& state) {
+  JAVA::HashMap<int, int> h1;
   for (int i = 0; i < NUM_COUNT; i++) {
-    h2.count(std::to_string(i));
+    h1.Put(i, i + 1);
   }
 
-  for (int i = NUM_COUNT - 1; i >= 0; i--) {
-    h2.erase(std::to_string(i));
+  for (auto _ : state) {
+    long long sum = 0;
+    h1.ForEach([&sum](int /*key*/, int value) { sum += value; });
+    benchmark::DoNotOptimize(sum);
   }
 }
 
-static void CustomHashMapBenchmark(benchmark::State& state) {
+static void CustomStdUnorderedMapIterationBenchmark(benchmark::State& state) {
+  std::unordered_map<int, int> h1;
+  for (int i = 0; i < NUM_COUNT; i++) {
+    h1.emplace(i, i + 1);
+  }
+
   for (auto _ : state) {
-    HashMapBenchmark();
+    long long sum = 0;
+    for (auto [key, value] : h1) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
   }
 }
 
-static void CustomStdUnorderedMapBenchmark(benchmark::State& state) {
+constexpr int CONCURRENT_KEYS = 1 << 20;
+
+const int MAX_THREADS =
+    std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+// the map is shared by all benchmark threads, thread 0 builds and frees it
+JAVA::ConcurrentHashMap<int, int>* concurrentMap = nullptr;
+
+JAVA::HashMap<int, int>* lockedMap = nullptr;
+
+std::mutex lockedMapMutex;
+
+// state.range(0) is the percentage of operations that are reads
+static void CustomConcurrentHashMapMixedBenchmark(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    concurrentMap = new JAVA::ConcurrentHashMap<int, int>();
+    for (int i = 0; i < CONCURRENT_KEYS; i += 2) {
+      concurrentMap->Put(i, i);
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  auto key = static_cast<unsigned>(state.thread_index()) * 7919U;
   for (auto _ : state) {
-    StdUnorderedMapBenchmark();
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    key = key * 1664525U + 1013904223U;
+    int k = static_cast<int>(key % CONCURRENT_KEYS);
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (static_cast<int64_t>(key >> 25U) % 100 < state.range(0)) {
+      benchmark::DoNotOptimize(concurrentMap->Get(k));
+    } else if ((key & 1U) == 0) {
+      concurrentMap->Put(k, k);
+    } else {
+      concurrentMap->Del(k);
+    }
+  }
+
+  if (state.thread_index() == 0) {
+    delete concurrentMap;
   }
 }
 
-static void CustomStdMapBenchmark(benchmark::State& state) {
+static void CustomLockedHashMapMixedBenchmark(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    lockedMap = new JAVA::HashMap<int, int>();
+    for (int i = 0; i < CONCURRENT_KEYS; i += 2) {
+      lockedMap->Put(i, i);
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  auto key = static_cast<unsigned>(state.thread_index()) * 7919U;
   for (auto _ : state) {
-    StdMapBenchmark();
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    key = key * 1664525U + 1013904223U;
+    int k = static_cast<int>(key % CONCURRENT_KEYS);
+    std::lock_guard<std::mutex> lock(lockedMapMutex);
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (static_cast<int64_t>(key >> 25U) % 100 < state.range(0)) {
+      benchmark::DoNotOptimize(lockedMap->Get(k));
+    } else if ((key & 1U) == 0) {
+      lockedMap->Put(k, k);
+    } else {
+      lockedMap->Del(k);
+    }
+  }
+
+  if (state.thread_index() == 0) {
+    delete lockedMap;
   }
 }
 
-BENCHMARK(CustomHashMapBenchmark);
-BENCHMARK(CustomStdUnorderedMapBenchmark);
-BENCHMARK(CustomStdMapBenchmark);
+BENCHMARK_TEMPLATE(CustomMissHeavyLookupBenchmark, JAVA::HashMap<int, int>);
+BENCHMARK_TEMPLATE(CustomMissHeavyLookupBenchmark,
+                   JAVA::TaggedHashMap<int, int>);
+BENCHMARK(CustomStringLookupBenchmark);
+BENCHMARK(CustomStringViewLookupBenchmark);
+BENCHMARK_TEMPLATE(CustomBatchedLookupBenchmark, JAVA::HashMap<int, int>)
+    ->ArgName("batch")
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(1)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(16)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(256);
+BENCHMARK_TEMPLATE(CustomBatchedLookupBenchmark, JAVA::TaggedHashMap<int, int>)
+    ->ArgName("batch")
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(1)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(256);
+BENCHMARK_TEMPLATE(CustomBytesPerEntryBenchmark, JAVA::HashMap<int, int>)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomBytesPerEntryBenchmark,
+                   JAVA::HashMap<int, int, CachedIntHash>)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomBytesPerEntryBenchmark, JAVA::TaggedHashMap<int, int>)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(CustomBulkLoadBenchmark);
+BENCHMARK(CustomPresizedBulkLoadBenchmark);
+BENCHMARK(CustomRebuildColdStartBenchmark)->Unit(benchmark::kMillisecond);
+BENCHMARK(CustomSnapshotColdStartBenchmark)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomSerializeBenchmark, int, int)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomSerializeBenchmark, std::string, std::string)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomDeserializeBenchmark, int, int)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomDeserializeBenchmark, std::string, std::string)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(CustomParallelBulkLoadBenchmark)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)
+    ->Range(1, MAX_THREADS)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomPutLatencyBenchmark, JAVA::HashMap<int, int>)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(CustomPutLatencyBenchmark,
+                   JAVA::IncrementalHashMap<int, int>)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(CustomHashMapIterationBenchmark);
+BENCHMARK(CustomHashMapForEachBenchmark);
+BENCHMARK(CustomStdUnorderedMapIterationBenchmark);
+BENCHMARK(CustomConcurrentHashMapMixedBenchmark)
+    ->ArgName("read%")
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(50)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(90)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(99)
+    // read scaling, no writer ever takes a bin lock
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(100)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+BENCHMARK(CustomLockedHashMapMixedBenchmark)
+    ->ArgName("read%")
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(50)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(90)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(99)
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ->Arg(100)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
 
 auto main(int argc, char** argv) -> int {
   JAVA::display();
@@ -128,6 +526,21 @@ auto main(int argc, char** argv) -> int {
     argc = 1;
     argv = &args_default;
   }
+  // results also go to a JSON file for tracking regressions, unless the
+  // command line picks another one
+  std::vector<char*> args(argv, argv + argc);
+  // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+  char out_default[] = "--benchmark_out=HashMapBenchmark.json";
+  // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+  char format_default[] = "--benchmark_out_format=json";
+  if (std::none_of(args.begin(), args.end(), [](const char* arg) {
+        return std::string_view(arg).rfind("--benchmark_out=", 0) == 0;
+      })) {
+    args.push_back(out_default);
+    args.push_back(format_default);
+  }
+  argc = static_cast<int>(args.size());
+  argv = args.data();
   ::benchmark::Initialize(&argc, argv);
   if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
     return 1;
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/HashMap.hpp"
+#include "clusteredKey.hpp"
+
+// hashes ints like std::hash and remembers whether any other thread did
+struct ThreadCheckingHash {
+  std::thread::id owner = std::this_thread::get_id();
+
+  std::shared_ptr<bool> otherThread = std::make_shared<bool>(false);
+
+  auto operator()(int key) const -> std::size_t {
+    if (std::this_thread::get_id() != owner) {
+      *otherThread = true;
+    }
+    return std::hash<int>()(key);
+  }
+};
+
+// enough threads to take the parallel paths even on a single core
+constexpr std::size_t THREADS = 4;
+
+template <typename Map>
+class BulkLoadTest : public ::testing::Test {};
+
+using BulkLoadTestTypes =
+    ::testing::Types<JAVA::HashMap<int, int>, JAVA::TaggedHashMap<int, int>,
+                     JAVA::IncrementalHashMap<int, int>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(BulkLoadTest, BulkLoadTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(BulkLoadTest, LaterPairsWin) {
+  constexpr int KEYS = 200000;
+  std::vector<std::pair<int, int>> pairs;
+  // every key twice, the second time with its final value
+  for (int i = 0; i < KEYS; i++) {
+    pairs.emplace_back(i, -i);
+  }
+  for (int i = KEYS - 1; i >= 0; i--) {
+    pairs.emplace_back(i, i + 1);
+  }
+
+  TypeParam h;
+  h.SetParallelism(THREADS);
+  h.BulkLoad(pairs.begin(), pairs.end());
+  ASSERT_EQ(h.size(), KEYS);
+  for (int i = 0; i < 2 * KEYS; i++) {
+    ASSERT_EQ(h.Get(i), i < KEYS ? std::make_optional(i + 1) : std::nullopt);
+  }
+
+  // loading into a map that already has entries assigns the common keys
+  std::vector<std::pair<int, int>> more;
+  for (int i = KEYS / 2; i < KEYS * 3 / 2; i++) {
+    more.emplace_back(i, 2 * i);
+  }
+  h.BulkLoad(more.begin(), more.end());
+  ASSERT_EQ(h.size(), KEYS * 3 / 2);
+  for (int i = 0; i < KEYS * 3 / 2; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i < KEYS / 2 ? i + 1 : 2 * i));
+  }
+
+  std::size_t count = 0;
+  h.ForEach([&count](const int & /*unused*/, int & /*unused*/) { count++; });
+  ASSERT_EQ(count, h.size());
+  ASSERT_TRUE(h.Del(0));
+  ASSERT_EQ(h.size(), KEYS * 3 / 2 - 1);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(BulkLoadTest, ParallelResize) {
+  TypeParam h;
+  h.SetParallelism(THREADS);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 300000; i++) {
+    h.Put(i, i + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 300000; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_FALSE(h.Contain(300000));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(BulkLoadTestAllocator, AssertionTrue) {
+  constexpr int KEYS = 200000;
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < KEYS; i++) {
+    pairs.emplace_back(i, i + 1);
+  }
+
+  // an arena is not safe to share between threads, so without
+  // SetParallelism everything stays on the calling thread
+  std::pmr::unsynchronized_pool_resource arena;
+  using Alloc = std::pmr::polymorphic_allocator<std::pair<const int, int>>;
+  ThreadCheckingHash hasher;
+  JAVA::HashMap<int, int, ThreadCheckingHash, std::equal_to<int>, Alloc> h(
+      hasher, std::equal_to<int>(), Alloc(&arena));
+  h.BulkLoad(pairs.begin(), pairs.end());
+  for (int i = 0; i < KEYS; i++) {
+    h.Put(KEYS + i, i);
+  }
+  ASSERT_FALSE(*hasher.otherThread);
+  ASSERT_EQ(h.size(), 2 * KEYS);
+  for (int i = 0; i < KEYS; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(BulkLoadTestRangeConstructor, AssertionTrue) {
+  std::vector<std::pair<std::string, int>> pairs;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    pairs.emplace_back(std::to_string(i), i);
+  }
+  JAVA::HashMap<std::string, int> h1(pairs.begin(), pairs.end());
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h1.size(), 1000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h1.Get("999"), std::make_optional(999));
+
+  // not random access, loaded on the calling thread
+  std::list<std::pair<int, int>> list{{1, 1}, {2, 2}, {1, 3}};
+  JAVA::HashMap<int, int> h2(list.begin(), list.end());
+  ASSERT_EQ(h2.size(), 2);
+  ASSERT_EQ(h2.Get(1), std::make_optional(3));
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  JAVA::HashMap<int, int> h3(16, 4.0F);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h3.bucketCount(), 16);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(BulkLoadTestTreeBins, AssertionTrue) {
+  constexpr int KEYS = 100000;
+  std::vector<std::pair<ClusteredKey, std::string>> pairs;
+  for (int i = 0; i < KEYS; i += 2) {
+    pairs.emplace_back(ClusteredKey{i}, std::to_string(i));
+  }
+
+  // chains grow past the threshold while linking and are treeified after
+  JAVA::HashMap<ClusteredKey, std::string> h;
+  h.SetParallelism(THREADS);
+  h.BulkLoad(pairs.begin(), pairs.end());
+  ASSERT_EQ(h.size(), KEYS / 2);
+
+  // the second load inserts into tree bins
+  pairs.clear();
+  for (int i = 1; i < KEYS; i += 2) {
+    pairs.emplace_back(ClusteredKey{i}, std::to_string(i));
+  }
+  h.BulkLoad(pairs.begin(), pairs.end());
+  ASSERT_EQ(h.size(), KEYS);
+
+  // and the resizes that follow split them
+  for (int i = KEYS; i < 3 * KEYS; i++) {
+    h.Put(ClusteredKey{i}, std::to_string(i));
+  }
+  for (int i = 0; i < 3 * KEYS; i++) {
+    ASSERT_EQ(h.Get(ClusteredKey{i}), std::make_optional(std::to_string(i)));
+  }
+  for (int i = 0; i < 3 * KEYS; i += 3) {
+    ASSERT_TRUE(h.Del(ClusteredKey{i}));
+  }
+  ASSERT_EQ(h.size(), 2 * KEYS);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// runs of 16 consecutive ids share a hash code, so their bins become trees
+struct ClusteredKey {
+  int id;
+
+  auto operator==(const ClusteredKey &other) const noexcept -> bool {
+    return id == other.id;
+  }
+
+  auto operator<(const ClusteredKey &other) const noexcept -> bool {
+    return id < other.id;
+  }
+};
+
+template <>
+struct std::hash<ClusteredKey> {
+  auto operator()(const ClusteredKey &key) const -> std::size_t {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    return std::hash<int>()(key.id / 16);
+  }
+};
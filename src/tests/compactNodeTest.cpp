@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include "../include/HashMap.hpp"
+#include "clusteredKey.hpp"
+
+/**
+ * Same hash as Hash, but nodes keep caching it.
+ */
+template <typename Hash>
+struct ExpensiveHash : Hash {
+  using is_expensive = void;
+};
+
+template <typename Map>
+class CompactNodeTest : public ::testing::Test {};
+
+using CompactNodeTestTypes = ::testing::Types<
+    JAVA::HashMap<ClusteredKey, int>,
+    JAVA::HashMap<ClusteredKey, int, ExpensiveHash<std::hash<ClusteredKey>>>,
+    JAVA::TaggedHashMap<ClusteredKey, int>,
+    JAVA::IncrementalHashMap<ClusteredKey, int>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(CompactNodeTest, CompactNodeTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(CompactNodeTest, TreeBinsAndResize) {
+  // tree bins are ordered, split and rebuilt from hash codes that compact
+  // nodes recompute every time
+  TypeParam h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 20000; i++) {
+    h.Put(ClusteredKey{i}, i + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 40000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(ClusteredKey{i}),
+              i < 20000 ? std::make_optional(i + 1) : std::nullopt);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 20000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i % 16 != 0) {
+      ASSERT_TRUE(h.Del(ClusteredKey{i}));
+    }
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 1250);
+  h.ShrinkToFit();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 20000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Contain(ClusteredKey{i}), i % 16 == 0);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(CompactNodeTestMemoryUsage, AssertionTrue) {
+  JAVA::HashMap<int, int> compact;
+  JAVA::HashMap<int, int, ExpensiveHash<std::hash<int>>> cached;
+  ASSERT_GT(compact.MemoryUsage(), 0);
+  ASSERT_EQ(compact.MemoryUsage(), cached.MemoryUsage());
+
+  constexpr int ENTRIES = 100000;
+  for (int i = 0; i < ENTRIES; i++) {
+    compact.Put(i, i);
+    cached.Put(i, i);
+  }
+  // 8 bytes less per node, minus what the partly used last slab hides
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_LT(compact.MemoryUsage() + 6 * ENTRIES, cached.MemoryUsage());
+
+  // the nodes of tree bins are counted too
+  JAVA::HashMap<ClusteredKey, int> h;
+  std::size_t before = h.MemoryUsage();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 64; i++) {
+    h.Put(ClusteredKey{i}, i);
+  }
+  std::size_t slabs = h.MemoryUsage();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 64; i < 1000; i++) {
+    h.Put(ClusteredKey{i}, i);
+  }
+  ASSERT_GT(slabs, before);
+  ASSERT_GT(h.MemoryUsage(), slabs);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
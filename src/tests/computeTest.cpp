@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../include/FlatHashMap.hpp"
+#include "../include/HashMap.hpp"
+
+template <typename Map>
+class ComputeTest : public ::testing::Test {};
+
+using ComputeTestTypes =
+    ::testing::Types<JAVA::HashMap<std::string, std::string>,
+                     JAVA::TaggedHashMap<std::string, std::string>,
+                     JAVA::FlatHashMap<std::string, std::string>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(ComputeTest, ComputeTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(ComputeTest, FindAndGetOr) {
+  TypeParam h;
+  h.Put(std::string("Hello"), std::string("world"));
+
+  std::string *value = h.Find(std::string("Hello"));
+  ASSERT_NE(value, nullptr);
+  ASSERT_EQ(*value, "world");
+  value->append("!");
+  ASSERT_EQ(h.Get(std::string("Hello")), std::make_optional<std::string>("world!"));
+  ASSERT_EQ(h.Find(std::string("world")), nullptr);
+
+  const TypeParam &ch = h;
+  ASSERT_EQ(*ch.Find(std::string("Hello")), "world!");
+  ASSERT_EQ(ch.GetOr(std::string("Hello"), "none"), "world!");
+  ASSERT_EQ(ch.GetOr(std::string("world"), "none"), "none");
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(ComputeTest, Update) {
+  TypeParam h;
+  ASSERT_FALSE(h.Update(std::string("a"), [](std::string &v) { v += "x"; }));
+  h.Put(std::string("a"), std::string("a"));
+  ASSERT_TRUE(h.Update(std::string("a"), [](std::string &v) { v += "x"; }));
+  ASSERT_EQ(*h.Find(std::string("a")), "ax");
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(ComputeTest, Compute) {
+  TypeParam h;
+  auto append = [](const std::string &key,
+                   const std::string *old) -> std::optional<std::string> {
+    return old == nullptr ? key : *old + key;
+  };
+
+  ASSERT_EQ(*h.Compute(std::string("k"), append), "k");
+  ASSERT_EQ(*h.Compute(std::string("k"), append), "kk");
+  ASSERT_EQ(h.size(), 1);
+
+  auto remove = [](const std::string & /*unused*/,
+                   const std::string * /*unused*/) -> std::optional<std::string> {
+    return std::nullopt;
+  };
+  ASSERT_EQ(h.Compute(std::string("k"), remove), nullptr);
+  ASSERT_FALSE(h.Contain(std::string("k")));
+  ASSERT_EQ(h.Compute(std::string("k"), remove), nullptr);
+  ASSERT_TRUE(h.empty());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(ComputeTest, ComputeIfAbsent) {
+  TypeParam h;
+  int calls = 0;
+  auto make = [&calls](const std::string &key) -> std::string {
+    calls++;
+    return key + key;
+  };
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    std::string &value = h.ComputeIfAbsent(std::to_string(i), make);
+    ASSERT_EQ(value, std::to_string(i) + std::to_string(i));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h.ComputeIfAbsent(std::to_string(i), make).append("!");
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(calls, 1000);
+  ASSERT_EQ(h.GetOr(std::string("7"), ""), "77!");
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(ComputeTest, Merge) {
+  TypeParam h;
+  auto concat = [](const std::string &old,
+                   const std::string &value) -> std::optional<std::string> {
+    if (value.empty()) {
+      return std::nullopt;
+    }
+    return old + value;
+  };
+
+  ASSERT_EQ(*h.Merge(std::string("k"), std::string("a"), concat), "a");
+  ASSERT_EQ(*h.Merge(std::string("k"), std::string("b"), concat), "ab");
+  ASSERT_EQ(h.Merge(std::string("k"), std::string(), concat), nullptr);
+  ASSERT_TRUE(h.empty());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ComputeTestWordCount, AssertionTrue) {
+  // counting through Merge must give the same result as Get then Put, also
+  // once bins have become trees
+  struct ModHash {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto operator()(int key) const noexcept -> std::size_t { return key % 3; }
+  };
+  JAVA::HashMap<int, int, ModHash> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 30000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    h.Merge(i % 300, 1, [](int old, int one) { return old + one; });
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 300);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 300; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.GetOr(i, 0), 100);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 300; i += 2) {
+    ASSERT_EQ(h.Compute(i, [](int /*unused*/, const int * /*unused*/)
+                               -> std::optional<int> { return std::nullopt; }),
+              nullptr);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 150);
+  ASSERT_EQ(h.Find(0), nullptr);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(*h.Find(1), 100);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ComputeTestInsertedNode, AssertionTrue) {
+  // inserts treeify bins and resize the table, the values handed back must
+  // still be the stored ones
+  struct ModHash {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto operator()(int key) const noexcept -> std::size_t { return key % 7; }
+  };
+  JAVA::HashMap<int, int, ModHash> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 3000; i += 3) {
+    int *computed = h.Compute(
+        i, [](int key, const int * /*unused*/) -> std::optional<int> {
+          return key;
+        });
+    ASSERT_EQ(computed, h.Find(i));
+    int &absent = h.ComputeIfAbsent(i + 1, [](int key) { return key; });
+    ASSERT_EQ(&absent, h.Find(i + 1));
+    int *merged = h.Merge(i + 2, i + 2, [](int old, int /*unused*/) {
+      return std::make_optional(old);
+    });
+    ASSERT_EQ(merged, h.Find(i + 2));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 3000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 3000; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ComputeTestFlatGrowth, AssertionTrue) {
+  // the pointers handed back by inserting Compute and Merge calls point into
+  // the slots after the growth they caused
+  JAVA::FlatHashMap<int, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i += 2) {
+    int *computed = h.Compute(
+        i, [](int key, const int * /*unused*/) -> std::optional<int> {
+          return key;
+        });
+    ASSERT_EQ(*computed, i);
+    ASSERT_EQ(computed, h.Find(i));
+    int *merged = h.Merge(i + 1, i + 1, [](int old, int /*unused*/) {
+      return std::make_optional(old);
+    });
+    ASSERT_EQ(*merged, i + 1);
+    ASSERT_EQ(merged, h.Find(i + 1));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 1000);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ComputeTestRemoveFound, AssertionTrue) {
+  // Compute and Merge remove the node they found, from chains, tree bins
+  // and buckets an incremental resize has not moved yet
+  struct ModHash {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto operator()(int key) const noexcept -> std::size_t { return key % 5; }
+  };
+  JAVA::HashMap<int, int, ModHash, std::equal_to<int>,
+                std::allocator<std::pair<const int, int>>, true, true>
+      h;
+  auto drop = [](int /*unused*/, int /*unused*/) -> std::optional<int> {
+    return std::nullopt;
+  };
+  int next = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  while (next < 2000) {
+    std::size_t buckets = h.bucketCount();
+    while (h.bucketCount() == buckets) {
+      h.Put(next, next);
+      next++;
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = next / 2; i + 1 < next; i += 4) {
+      ASSERT_EQ(h.Merge(i, 0, drop), nullptr);
+      ASSERT_EQ(h.Compute(i + 1, [](int /*unused*/, const int * /*unused*/)
+                                     -> std::optional<int> {
+                  return std::nullopt;
+                }),
+                nullptr);
+      h.Put(i, i);
+      h.Put(i + 1, i + 1);
+    }
+  }
+  ASSERT_EQ(static_cast<int>(h.size()), next);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < next; i += 2) {
+    ASSERT_EQ(h.Merge(i, 0, drop), nullptr);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(static_cast<int>(h.size()), next / 2);
+  for (int i = 0; i < next; i++) {
+    ASSERT_EQ(h.Contain(i), i % 2 == 1);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(ComputeTestIfAbsentThrows, AssertionTrue) {
+  // fn only runs on a miss, and throwing from it leaves the map as it was
+  JAVA::TaggedHashMap<std::string, std::string> h;
+  h.Put(std::string("k"), std::string("v"));
+  auto fail = [](const std::string & /*unused*/) -> std::string {
+    throw std::runtime_error("no value");
+  };
+  ASSERT_EQ(h.ComputeIfAbsent(std::string("k"), fail), "v");
+  ASSERT_THROW(h.ComputeIfAbsent(std::string("x"), fail), std::runtime_error);
+  ASSERT_EQ(h.size(), 1);
+  ASSERT_FALSE(h.Contain(std::string("x")));
+  ASSERT_EQ(h.ComputeIfAbsent(std::string("x"),
+                              [](const std::string &key) { return key; }),
+            "x");
+  ASSERT_EQ(h.size(), 2);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(ComputeTestTransparentFind, AssertionTrue) {
+  JAVA::HashMap<std::string, int, JAVA::StringHash, std::equal_to<>> h;
+  h.Put(std::string("Hello"), 1);
+  ASSERT_EQ(*h.Find(std::string_view("Hello")), 1);
+  ASSERT_EQ(h.GetOr(std::string_view("world"), -1), -1);
+
+  JAVA::FlatHashMap<std::string, int, JAVA::StringHash, std::equal_to<>> f;
+  f.Put(std::string("Hello"), 1);
+  ASSERT_EQ(*f.Find(std::string_view("Hello")), 1);
+  ASSERT_EQ(f.GetOr(std::string_view("world"), -1), -1);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
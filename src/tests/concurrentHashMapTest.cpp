@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ConcurrentHashMap.hpp"
+
+constexpr int THREADS = 8;
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ConcurrentHashMapTestBasicType, AssertionTrue) {
+  JAVA::ConcurrentHashMap<int, int> h1;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    h1.Put(i, i + 1);
+    ASSERT_EQ(h1.size(), i + 1);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 200000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 100000) {
+      ASSERT_EQ(h1.Get(i), std::make_optional(i + 1));
+    } else {
+      ASSERT_FALSE(h1.Contain(i));
+      ASSERT_FALSE(h1.Del(i));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i += 2) {
+    h1.Put(i, -i);
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_TRUE(h1.Del(i + 1));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h1.size(), 50000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(h1.Get(i), i % 2 == 0 ? std::make_optional(-i) : std::nullopt);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(ConcurrentHashMapTestString, AssertionTrue) {
+  JAVA::ConcurrentHashMap<std::string, std::string> h;
+  h.Put(std::string("Hello"), std::string("world"));
+  h.Put(std::string("Hello"), std::string("world1"));
+  ASSERT_EQ(h.Get(std::string("Hello")), std::make_optional<std::string>("world1"));
+  ASSERT_EQ(h.size(), 1);
+  ASSERT_TRUE(h.Del(std::string("Hello")));
+  ASSERT_TRUE(h.empty());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(ConcurrentHashMapTestResizeThreshold, AssertionTrue) {
+  // the table grows at a load of 0.75 even when every key has its own bin
+  JAVA::ConcurrentHashMap<int, int> h;
+  std::size_t buckets = h.bucketCount();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    h.Put(i, i);
+    if (h.bucketCount() != buckets) {
+      ASSERT_EQ(h.size(), buckets - (buckets >> 2));
+      buckets = h.bucketCount();
+    }
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(buckets, 16384);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ConcurrentHashMapTestParallelPut, AssertionTrue) {
+  // disjoint keys per thread, so every insert races with resizes
+  JAVA::ConcurrentHashMap<int, int> h;
+  constexpr int PER_THREAD = 50000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&h, t] {
+      for (int i = t * PER_THREAD; i < (t + 1) * PER_THREAD; i++) {
+        h.Put(i, i + 1);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(h.size(), THREADS * PER_THREAD);
+  for (int i = 0; i < THREADS * PER_THREAD; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(ConcurrentHashMapTestMixed, AssertionTrue) {
+  // keys below STABLE are never removed and must stay visible to readers
+  // while writers insert, update and delete around them
+  constexpr int STABLE = 10000;
+  constexpr int CHURN = 20000;
+  JAVA::ConcurrentHashMap<int, std::string> h;
+  for (int i = 0; i < STABLE; i++) {
+    h.Put(i, std::to_string(i));
+  }
+
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    threads.emplace_back([&h, &failed, t] {
+      for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < CHURN; i++) {
+          int key = STABLE + ((i * THREADS + t) % CHURN);
+          if (t % 2 == 0) {
+            h.Put(key, std::to_string(key));
+            h.Del(key + 1);
+          } else {
+            std::optional<std::string> value = h.Get(i % STABLE);
+            if (value != std::make_optional(std::to_string(i % STABLE))) {
+              failed = true;
+            }
+            h.Put(i % STABLE, std::to_string(i % STABLE));
+            std::optional<std::string> churn = h.Get(key);
+            if (churn.has_value() && *churn != std::to_string(key)) {
+              failed = true;
+            }
+          }
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_FALSE(failed);
+  std::size_t count = 0;
+  for (int i = 0; i < STABLE + CHURN + 1; i++) {
+    count += h.Contain(i) ? 1 : 0;
+  }
+  ASSERT_EQ(h.size(), count);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <optional>
+#include <string>
+
+#include "../include/FlatHashMap.hpp"
 #include "../include/HashMap.hpp"
 
 // NOLINTNEXTLINE(modernize-use-trailing-return-type)
@@ -27,6 +31,68 @@ TEST(DelTest, AssertionTrue) {
   }
 }
 
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(DelTestReinsert, AssertionTrue) {
+  // emptying the map hands whole slabs back, refilling it must still work
+  JAVA::HashMap<int, std::string> h1;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int round = 0; round < 3; round++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 0; i < 20000; i++) {
+      h1.Put(i, std::to_string(i + round));
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 0; i < 20000; i++) {
+      ASSERT_EQ(h1.Get(i), std::make_optional(std::to_string(i + round)));
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 0; i < 20000; i++) {
+      ASSERT_TRUE(h1.Del(i));
+    }
+    ASSERT_TRUE(h1.empty());
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(DelTestFlatHashMap, AssertionTrue) {
+  JAVA::FlatHashMap<int, int> h1;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    h1.Put(i, i + 1);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(h1.Del(i));
+      ASSERT_FALSE(h1.Del(i));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    if (i % 2 == 0) {
+      ASSERT_FALSE(h1.Contain(i));
+    } else {
+      ASSERT_TRUE(h1.Contain(i));
+    }
+  }
+
+  // tombstones left behind by Del are reused and purged by rehashing
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int round = 0; round < 20; round++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 10000; i < 20000; i++) {
+      h1.Put(i, round);
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 10000; i < 20000; i++) {
+      ASSERT_TRUE(h1.Del(i));
+    }
+  }
+  ASSERT_EQ(h1.size(), 5000);
+}
+
 auto main(int argc, char **argv) -> int {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::FLAGS_gtest_output = "stdout:";
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "../include/HashMap.hpp"
+
+struct Money {
+  int cents;
+};
+
+auto operator<<(std::ostream &out, const Money &money) -> std::ostream & {
+  return out << '$' << money.cents / 100 << '.' << money.cents % 100;
+}
+
+/**
+ * What toString printed before Format: operator<< for every key and value.
+ */
+template <typename Map>
+static auto streamed(const Map &map) -> std::string {
+  std::ostringstream out;
+  out << '{';
+  bool first = true;
+  map.ForEach([&](const auto &key, const auto &value) {
+    out << (first ? "" : ",") << key << '=' << value;
+    first = false;
+  });
+  out << '}';
+  return out.str();
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(DumpTestToString, AssertionTrue) {
+  JAVA::HashMap<int, double> doubles;
+  ASSERT_EQ(doubles.toString(), "{}");
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = -500; i < 500; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    doubles.Put(i, i * 1234.56789 + 0.1);
+  }
+  doubles.Put(1 << 20, 1e-9);
+  ASSERT_EQ(doubles.toString(), streamed(doubles));
+
+  JAVA::HashMap<std::string, bool> flags;
+  flags.Put(std::string("on"), true);
+  flags.Put(std::string("off"), false);
+  ASSERT_EQ(flags.toString(), streamed(flags));
+
+  JAVA::HashMap<char, Money> prices;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  prices.Put('a', Money{1250});
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  prices.Put('b', Money{99});
+  ASSERT_EQ(prices.toString(), streamed(prices));
+  ASSERT_NE(prices.toString().find("a=$12.50"), std::string::npos);
+
+  JAVA::HashMap<long, unsigned> one;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  one.Put(-42L, 42U);
+  ASSERT_EQ(one.toString(), "{-42=42}");
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(DumpTestLimit, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100; i++) {
+    h.Put(i, i);
+  }
+  ASSERT_EQ(h.Format(), h.toString());
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.Format(100), h.toString());
+  ASSERT_EQ(h.Format(0), "{...}");
+
+  std::string three = h.Format(3);
+  ASSERT_EQ(three.substr(three.size() - 5), ",...}");
+  ASSERT_EQ(std::count(three.begin(), three.end(), '='), 3);
+
+  // every tenth entry
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  std::string sampled = h.Format(1000, 10);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(std::count(sampled.begin(), sampled.end(), '='), 10);
+  ASSERT_EQ(sampled.substr(sampled.size() - 5), ",...}");
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  std::string both = h.Format(4, 10);
+  ASSERT_EQ(std::count(both.begin(), both.end(), '='), 4);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(DumpTestStream, AssertionTrue) {
+  JAVA::HashMap<std::string, int> h;
+  // larger than the dump buffer
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i++) {
+    h.Put("key-" + std::to_string(i), i);
+  }
+  std::ostringstream out;
+  h.Dump(out);
+  ASSERT_EQ(out.str(), h.toString());
+  ASSERT_EQ(out.str(), streamed(h));
+
+  std::ostringstream limited;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Dump(limited, 10, 3);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(limited.str(), h.Format(10, 3));
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include "../include/FlatHashMap.hpp"
+#include "../include/HashMap.hpp"
+
+// counts how often values are copied and moved
+struct Tracked {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+  static inline int copies = 0;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+  static inline int moves = 0;
+
+  int id = 0;
+
+  Tracked() = default;
+
+  explicit Tracked(int id) : id(id) {}
+
+  Tracked(const Tracked &other) : id(other.id) { copies++; }
+
+  Tracked(Tracked &&other) noexcept : id(other.id) { moves++; }
+
+  auto operator=(const Tracked &other) -> Tracked & {
+    id = other.id;
+    copies++;
+    return *this;
+  }
+
+  auto operator=(Tracked &&other) noexcept -> Tracked & {
+    id = other.id;
+    moves++;
+    return *this;
+  }
+
+  ~Tracked() = default;
+
+  auto operator==(const Tracked &other) const noexcept -> bool {
+    return id == other.id;
+  }
+
+  static auto reset() -> void {
+    copies = 0;
+    moves = 0;
+  }
+};
+
+template <>
+struct std::hash<Tracked> {
+  auto operator()(const Tracked &key) const -> std::size_t {
+    return std::hash<int>()(key.id);
+  }
+};
+
+template <typename Map>
+class EmplaceTest : public ::testing::Test {};
+
+using EmplaceTestTypes =
+    ::testing::Types<JAVA::HashMap<Tracked, Tracked>,
+                     JAVA::TaggedHashMap<Tracked, Tracked>,
+                     JAVA::FlatHashMap<Tracked, Tracked>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(EmplaceTest, EmplaceTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(EmplaceTest, PutMovesRvalues) {
+  TypeParam h;
+  Tracked key(1);
+  Tracked value(2);
+
+  Tracked::reset();
+  h.Put(std::move(key), std::move(value));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 2);
+
+  // an update moves the new value in and leaves the key alone
+  Tracked::reset();
+  h.Put(Tracked(1), Tracked(3));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 1);
+
+  // lvalues are copied exactly once
+  Tracked lkey(4);
+  Tracked lvalue(5);
+  Tracked::reset();
+  h.Put(lkey, lvalue);
+  ASSERT_EQ(Tracked::copies, 2);
+  ASSERT_EQ(Tracked::moves, 0);
+  ASSERT_EQ(h.size(), 2);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(EmplaceTest, TryEmplace) {
+  TypeParam h;
+
+  Tracked::reset();
+  ASSERT_TRUE(h.TryEmplace(Tracked(1), 2));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 1);
+
+  // a present key neither builds the value nor consumes the key
+  Tracked key(1);
+  Tracked::reset();
+  ASSERT_FALSE(h.TryEmplace(std::move(key), 3));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 0);
+  ASSERT_EQ(key.id, 1);
+  ASSERT_EQ(h.Get(Tracked(1))->id, 2);
+
+  // the value is default constructed without arguments
+  ASSERT_TRUE(h.TryEmplace(Tracked(7)));
+  ASSERT_EQ(h.Get(Tracked(7))->id, 0);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(EmplaceTest, Emplace) {
+  TypeParam h;
+
+  // key and value are both built from ints
+  Tracked::reset();
+  ASSERT_TRUE(h.Emplace(1, 2));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 1);
+
+  ASSERT_FALSE(h.Emplace(1, 3));
+  ASSERT_EQ(h.Get(Tracked(1))->id, 2);
+  ASSERT_EQ(h.size(), 1);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(EmplaceTest, InsertOrAssign) {
+  TypeParam h;
+
+  Tracked::reset();
+  ASSERT_TRUE(h.InsertOrAssign(Tracked(1), Tracked(2)));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 2);
+
+  Tracked::reset();
+  ASSERT_FALSE(h.InsertOrAssign(Tracked(1), Tracked(3)));
+  ASSERT_EQ(Tracked::copies, 0);
+  ASSERT_EQ(Tracked::moves, 1);
+  ASSERT_EQ(h.Get(Tracked(1))->id, 3);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(EmplaceTestTreeBin, AssertionTrue) {
+  // every key collides, so the bins become trees that are built in place too
+  struct ZeroHash {
+    auto operator()(int /*unused*/) const noexcept -> std::size_t { return 0; }
+  };
+  JAVA::HashMap<int, std::string, ZeroHash> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_TRUE(h.TryEmplace(i, 3, 'a' + i % 26));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_FALSE(h.TryEmplace(i, "x"));
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(i), std::make_optional(std::string(3, 'a' + i % 26)));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_FALSE(h.InsertOrAssign(i, std::string("even")));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.Get(10), std::make_optional(std::string("even")));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 1000);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
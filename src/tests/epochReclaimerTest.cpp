@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ConcurrentHashMap.hpp"
+#include "../include/EpochReclaimer.hpp"
+
+constexpr int THREADS = 8;
+
+struct Owner {
+  std::atomic<int> freed{0};
+
+  static auto free(Owner *owner, void *ptr) noexcept -> void {
+    delete static_cast<int *>(ptr);
+    owner->freed++;
+  }
+};
+
+using Reclaimer = JAVA::EpochReclaimer<Owner>;
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(EpochReclaimerTestUnpinned, AssertionTrue) {
+  Owner owner;
+  constexpr int RETIRED = 1000;
+  {
+    Reclaimer reclaimer(&owner);
+    for (int i = 0; i < RETIRED; i++) {
+      reclaimer.Retire(new int(i), &Owner::free);
+    }
+    // nobody is pinned, so the epoch keeps moving and old batches go
+    ASSERT_GT(owner.freed, 0);
+    ASSERT_EQ(owner.freed + static_cast<int>(reclaimer.Pending()), RETIRED);
+  }
+  ASSERT_EQ(owner.freed, RETIRED);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(EpochReclaimerTestPinned, AssertionTrue) {
+  Owner owner;
+  Reclaimer reclaimer(&owner);
+  std::atomic<bool> pinned{false};
+  std::atomic<bool> release{false};
+  std::thread reader([&] {
+    Reclaimer::Guard outer(&reclaimer);
+    {
+      // leaving a nested guard must not unpin the thread
+      Reclaimer::Guard inner(&reclaimer);
+    }
+    pinned = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  while (!pinned) {
+    std::this_thread::yield();
+  }
+
+  constexpr int RETIRED = 2000;
+  for (int i = 0; i < RETIRED; i++) {
+    reclaimer.Retire(new int(i), &Owner::free);
+  }
+  ASSERT_EQ(owner.freed, 0);
+
+  release = true;
+  reader.join();
+  for (int i = 0; i < RETIRED; i++) {
+    reclaimer.Retire(new int(i), &Owner::free);
+  }
+  ASSERT_GE(owner.freed, RETIRED);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(EpochReclaimerTestExitedThreads, AssertionTrue) {
+  // what exited threads left behind is freed by the threads still running
+  Owner owner;
+  Reclaimer reclaimer(&owner);
+  constexpr int RETIRED = 100;
+  {
+    Reclaimer::Guard guard(&reclaimer);
+    for (int t = 0; t < THREADS; t++) {
+      std::thread([&reclaimer] {
+        for (int i = 0; i < RETIRED; i++) {
+          reclaimer.Retire(new int(i), &Owner::free);
+        }
+      }).join();
+    }
+    ASSERT_EQ(owner.freed, 0);
+    ASSERT_EQ(reclaimer.Pending(), THREADS * RETIRED);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    reclaimer.Retire(new int(i), &Owner::free);
+  }
+  ASSERT_GE(owner.freed, THREADS * RETIRED);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(owner.freed + static_cast<int>(reclaimer.Pending()),
+            THREADS * RETIRED + 1000);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(EpochReclaimerTestTwoReclaimers, AssertionTrue) {
+  // one thread alternating between two reclaimers, and outliving one
+  Owner owner;
+  constexpr int RETIRED = 1000;
+  Reclaimer first(&owner);
+  {
+    Reclaimer second(&owner);
+    for (int i = 0; i < RETIRED; i++) {
+      Reclaimer::Guard a(&first);
+      Reclaimer::Guard b(&second);
+      first.Retire(new int(i), &Owner::free);
+      second.Retire(new int(i), &Owner::free);
+    }
+  }
+  ASSERT_EQ(owner.freed + static_cast<int>(first.Pending()), 2 * RETIRED);
+  std::thread([&first] {
+    Reclaimer::Guard guard(&first);
+    first.Retire(new int(0), &Owner::free);
+  }).join();
+  ASSERT_EQ(owner.freed + static_cast<int>(first.Pending()), 2 * RETIRED + 1);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(EpochReclaimerTestReadersUnderChurn, AssertionTrue) {
+  // readers only ever look up stable keys, writers replace those values and
+  // churn other keys through enough inserts to resize several times, so
+  // readers keep walking nodes and tables that are being retired
+  constexpr int STABLE = 1000;
+  constexpr int CHURN = 100000;
+  constexpr int ROUNDS = 3;
+  JAVA::ConcurrentHashMap<int, std::string> h;
+  for (int i = 0; i < STABLE; i++) {
+    h.Put(i, std::to_string(i));
+  }
+
+  std::atomic<int> writersLeft{THREADS / 2};
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; t++) {
+    if (t % 2 == 0) {
+      threads.emplace_back([&h, &writersLeft, t] {
+        for (int round = 0; round < ROUNDS; round++) {
+          for (int i = t; i < CHURN; i += THREADS) {
+            h.Put(STABLE + i, std::to_string(i));
+            h.Put(i % STABLE, std::to_string(i % STABLE));
+          }
+          for (int i = t; i < CHURN; i += THREADS) {
+            h.Del(STABLE + i);
+          }
+        }
+        writersLeft--;
+      });
+    } else {
+      threads.emplace_back([&h, &writersLeft, &failed] {
+        int i = 0;
+        while (writersLeft > 0) {
+          std::optional<std::string> value = h.Get(i);
+          if (value != std::make_optional(std::to_string(i))) {
+            failed = true;
+          }
+          i = (i + 1) % STABLE;
+        }
+      });
+    }
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_FALSE(failed);
+  ASSERT_EQ(h.size(), STABLE);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../include/FrozenHashMap.hpp"
+#include "../include/HashMap.hpp"
+
+namespace {
+
+enum class Level : std::uint8_t { DEBUG, INFO, WARN, ERROR };
+
+constexpr JAVA::FrozenHashMap<std::string_view, Level, 4> LEVELS{
+    {"debug", Level::DEBUG},
+    {"info", Level::INFO},
+    {"warn", Level::WARN},
+    {"error", Level::ERROR}};
+
+// built and looked up at compile time
+static_assert(LEVELS.size() == 4);
+static_assert(LEVELS.Get("warn") == Level::WARN);
+static_assert(LEVELS.Contain(std::string_view("error")));
+static_assert(!LEVELS.Contain("fatal"));
+static_assert(LEVELS.GetOr("fatal", Level::ERROR) == Level::ERROR);
+
+// the reverse table, keyed by an enum
+constexpr JAVA::FrozenHashMap<Level, std::string_view, 4> NAMES{
+    {Level::DEBUG, "debug"},
+    {Level::INFO, "info"},
+    {Level::WARN, "warn"},
+    {Level::ERROR, "error"}};
+
+static_assert(NAMES.Get(Level::INFO) == "info");
+
+}  // namespace
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(FrozenHashMapTestConstexpr, AssertionTrue) {
+  for (Level level : {Level::DEBUG, Level::INFO, Level::WARN, Level::ERROR}) {
+    std::optional<std::string_view> name = NAMES.Get(level);
+    ASSERT_TRUE(name.has_value());
+    ASSERT_EQ(LEVELS.Get(*name), level);
+  }
+  std::size_t count = 0;
+  LEVELS.ForEach([&count](std::string_view name, Level level) {
+    ASSERT_EQ(NAMES.Get(level), name);
+    ++count;
+  });
+  ASSERT_EQ(count, LEVELS.size());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(FrozenHashMapTestRuntime, AssertionTrue) {
+  // every size up to a few hundred, to hit every shape of the buckets
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (std::uint64_t n = 0; n < 300; n++) {
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> entries;
+    for (std::uint64_t i = 0; i < n; i++) {
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      entries.emplace_back(i * 7919, i);
+    }
+    JAVA::FrozenHashMap<std::uint64_t, std::uint64_t> h(entries.begin(),
+                                                        entries.end());
+    ASSERT_EQ(h.size(), n);
+    for (std::uint64_t i = 0; i < n; i++) {
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      ASSERT_EQ(h.Get(i * 7919), i);
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_FALSE(h.Contain(n * 7919));
+    ASSERT_FALSE(h.Contain(1));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(FrozenHashMapTestFromHashMap, AssertionTrue) {
+  JAVA::HashMap<std::string, int> config;
+  constexpr int ENTRIES = 10000;
+  for (int i = 0; i < ENTRIES; i++) {
+    config.Put("config.key." + std::to_string(i), i);
+  }
+  JAVA::FrozenHashMap<std::string, int> frozen(config.begin(), config.end());
+  ASSERT_EQ(frozen.size(), config.size());
+  for (int i = 0; i < ENTRIES; i++) {
+    std::string key = "config.key." + std::to_string(i);
+    ASSERT_EQ(frozen.Get(key), i);
+    ASSERT_EQ(frozen.Get(std::string_view(key)), i);
+  }
+  ASSERT_FALSE(frozen.Contain("config.key.10000"));
+  const int *value = frozen.Find("config.key.42");
+  ASSERT_NE(value, nullptr);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(*value, 42);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(FrozenHashMapTestInvalid, AssertionTrue) {
+  using Map = JAVA::FrozenHashMap<std::string, int>;
+  ASSERT_THROW(Map({{"a", 1}, {"b", 2}, {"a", 3}}), std::invalid_argument);
+
+  using Fixed = JAVA::FrozenHashMap<int, int, 2>;
+  ASSERT_THROW(Fixed({{1, 1}}), std::invalid_argument);
+  ASSERT_THROW(Fixed({{1, 1}, {2, 2}, {3, 3}}), std::invalid_argument);
+
+  Map empty({});
+  ASSERT_TRUE(empty.empty());
+  ASSERT_FALSE(empty.Contain("a"));
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../include/HashMap.hpp"
+#include "clusteredKey.hpp"
+
+template <typename Map>
+class GetManyTest : public ::testing::Test {};
+
+using GetManyTestTypes =
+    ::testing::Types<JAVA::HashMap<int, int>, JAVA::TaggedHashMap<int, int>,
+                     JAVA::IncrementalHashMap<int, int>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(GetManyTest, GetManyTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(GetManyTest, MatchesGet) {
+  TypeParam h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i += 2) {
+    h.Put(i, i + 1);
+
+    // every count, not only multiples of the group size, and lookups while
+    // an incremental resize is still moving buckets
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i % 98 == 0) {
+      std::vector<int> keys;
+      for (int k = i; k >= 0 && keys.size() < static_cast<std::size_t>(i / 2);
+           k -= 3) {
+        keys.push_back(k);
+      }
+      std::vector<std::optional<int>> values = h.GetMany(keys);
+      ASSERT_EQ(values.size(), keys.size());
+      // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+      auto found = std::make_unique<bool[]>(keys.size());
+      std::size_t present =
+          h.ContainMany(keys.data(), keys.size(), found.get());
+
+      std::size_t expected = 0;
+      for (std::size_t j = 0; j < keys.size(); j++) {
+        ASSERT_EQ(values[j], h.Get(keys[j]));
+        ASSERT_EQ(found[j], h.Contain(keys[j]));
+        expected += static_cast<std::size_t>(h.Contain(keys[j]));
+      }
+      ASSERT_EQ(present, expected);
+    }
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST(GetManyTest, Empty) {
+  TypeParam h;
+  ASSERT_TRUE(h.GetMany(std::vector<int>{}).empty());
+  ASSERT_EQ(h.GetMany(std::vector<int>{1, 2}),
+            (std::vector<std::optional<int>>{std::nullopt, std::nullopt}));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(GetManyTestTreeBins, AssertionTrue) {
+  JAVA::HashMap<ClusteredKey, std::string> h;
+  std::vector<ClusteredKey> keys;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 2000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i % 5 != 0) {
+      h.Put(ClusteredKey{i}, std::to_string(i));
+    }
+    keys.push_back(ClusteredKey{i});
+  }
+
+  std::vector<std::optional<std::string>> values(keys.size());
+  h.GetMany(keys.data(), keys.size(), values.data());
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(values[i], i % 5 == 0 ? std::nullopt
+                                    : std::make_optional(std::to_string(i)));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(GetManyTestStringView, AssertionTrue) {
+  JAVA::HashMap<std::string, int, JAVA::StringHash, std::equal_to<>> h;
+  std::vector<std::string> storage;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    storage.push_back("get-many-" + std::to_string(i));
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 500) {
+      h.Put(storage.back(), i);
+    }
+  }
+
+  std::vector<std::string_view> views(storage.begin(), storage.end());
+  std::vector<std::optional<int>> values = h.GetMany(views);
+  for (std::size_t i = 0; i < views.size(); i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(values[i], i < 500 ? std::make_optional(static_cast<int>(i))
+                                 : std::nullopt);
+  }
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
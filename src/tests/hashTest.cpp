@@ -1,11 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory_resource>
+#include <optional>
 #include <string>
 #include <utility>
 
+#include "../include/FlatHashMap.hpp"
+#include "../include/HashMap.hpp"
+
 // NOLINTNEXTLINE(modernize-use-trailing-return-type)
 TEST(hashTestBasicType, AssertionTrue) {
   std::hash<int> int_hash;
@@ -56,6 +63,201 @@ TEST(hashTestMyClassType, AssertionTrue) {
   ASSERT_EQ(MyClass_hash(obj3), MyClass_hash(obj2));
 }
 
+// keys are already well distributed 64-bit ids
+struct IdentityHash {
+  using is_avalanching = void;
+
+  auto operator()(std::uint64_t id) const noexcept -> std::size_t {
+    return id;
+  }
+};
+
+struct CaseInsensitiveHash {
+  auto operator()(const std::string &s) const noexcept -> std::size_t {
+    std::string lower(s);
+    for (char &c : lower) {
+      c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return std::hash<std::string>()(lower);
+  }
+};
+
+struct CaseInsensitiveEqual {
+  auto operator()(const std::string &a, const std::string &b) const noexcept
+      -> bool {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.size(); i++) {
+      if (std::tolower(static_cast<unsigned char>(a[i])) !=
+          std::tolower(static_cast<unsigned char>(b[i]))) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(hashTestAvalanchingHash, AssertionTrue) {
+  JAVA::HashMap<std::uint64_t, int, IdentityHash> h1;
+  JAVA::FlatHashMap<std::uint64_t, int, IdentityHash> h2;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (std::uint64_t i = 0; i < 10000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    std::uint64_t id = i * 0x9E3779B97F4A7C15ULL;
+    h1.Put(id, static_cast<int>(i));
+    h2.Put(id, static_cast<int>(i));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (std::uint64_t i = 0; i < 10000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    std::uint64_t id = i * 0x9E3779B97F4A7C15ULL;
+    ASSERT_EQ(h1.Get(id), std::make_optional(static_cast<int>(i)));
+    ASSERT_EQ(h2.Get(id), std::make_optional(static_cast<int>(i)));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(hashTestKeyEqual, AssertionTrue) {
+  JAVA::HashMap<std::string, int, CaseInsensitiveHash, CaseInsensitiveEqual> h1;
+  h1.Put(std::string("Hello"), 1);
+  h1.Put(std::string("HELLO"), 2);
+  ASSERT_EQ(h1.size(), 1);
+  ASSERT_EQ(h1.Get(std::string("hello")), std::make_optional(2));
+  ASSERT_TRUE(h1.Del(std::string("hElLo")));
+  ASSERT_TRUE(h1.empty());
+
+  JAVA::FlatHashMap<std::string, int, CaseInsensitiveHash,
+                    CaseInsensitiveEqual>
+      h2;
+  h2.Put(std::string("World"), 1);
+  h2.Put(std::string("world"), 2);
+  ASSERT_EQ(h2.size(), 1);
+  ASSERT_EQ(h2.Get(std::string("WORLD")), std::make_optional(2));
+}
+
+// forwards to the default resource and counts what is still outstanding
+class CountingResource : public std::pmr::memory_resource {
+ private:
+  std::size_t outstanding_ = 0;
+
+  std::size_t allocations_ = 0;
+
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void * override {
+    outstanding_ += bytes;
+    allocations_++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  auto do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+      -> void override {
+    outstanding_ -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other)
+      const noexcept -> bool override {
+    return this == &other;
+  }
+
+ public:
+  [[nodiscard]] auto outstanding() const noexcept -> std::size_t {
+    return outstanding_;
+  }
+
+  [[nodiscard]] auto allocations() const noexcept -> std::size_t {
+    return allocations_;
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(hashTestPmrAllocator, AssertionTrue) {
+  using Alloc = std::pmr::polymorphic_allocator<std::pair<const int, int>>;
+  CountingResource resource;
+  {
+    JAVA::HashMap<int, int, std::hash<int>, std::equal_to<int>, Alloc> h1(
+        Alloc{&resource});
+    JAVA::FlatHashMap<int, int, std::hash<int>, std::equal_to<int>, Alloc> h2(
+        Alloc{&resource});
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 0; i < 10000; i++) {
+      h1.Put(i, i + 1);
+      h2.Put(i, i + 1);
+    }
+    ASSERT_GT(resource.allocations(), 0);
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (int i = 0; i < 10000; i++) {
+      ASSERT_EQ(h1.Get(i), std::make_optional(i + 1));
+      ASSERT_EQ(h2.Get(i), std::make_optional(i + 1));
+    }
+  }
+
+  // everything taken from the resource has been given back
+  ASSERT_EQ(resource.outstanding(), 0);
+}
+
+// only ever aligns to 16 bytes, whatever alignment is asked for
+class UnderAligningResource : public std::pmr::memory_resource {
+ private:
+  constexpr static std::size_t ALIGN = 16;
+
+  std::size_t maxAlignment_ = 0;
+
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void * override {
+    maxAlignment_ = std::max(maxAlignment_, alignment);
+    auto *p = static_cast<unsigned char *>(
+        std::pmr::new_delete_resource()->allocate(bytes + ALIGN, ALIGN));
+    return p + ALIGN;
+  }
+
+  auto do_deallocate(void *p, std::size_t bytes, std::size_t /*unused*/)
+      -> void override {
+    std::pmr::new_delete_resource()->deallocate(
+        static_cast<unsigned char *>(p) - ALIGN, bytes + ALIGN, ALIGN);
+  }
+
+  [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other)
+      const noexcept -> bool override {
+    return this == &other;
+  }
+
+ public:
+  [[nodiscard]] auto maxAlignment() const noexcept -> std::size_t {
+    return maxAlignment_;
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(hashTestUnderAligningAllocator, AssertionTrue) {
+  using Alloc = std::pmr::polymorphic_allocator<std::pair<const int, int>>;
+  UnderAligningResource resource;
+  JAVA::HashMap<int, int, std::hash<int>, std::equal_to<int>, Alloc> h(
+      Alloc{&resource});
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i++) {
+    h.Put(i, i + 1);
+  }
+  // slabs are not padded to their size for such allocators
+  ASSERT_LE(resource.maxAlignment(), alignof(std::max_align_t));
+
+  // freed nodes go back to the slab they came from
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i += 2) {
+    ASSERT_TRUE(h.Del(i));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i++) {
+    ASSERT_EQ(h.Get(i), i % 2 == 0 ? std::nullopt : std::make_optional(i + 1));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 1; i < 50000; i += 2) {
+    ASSERT_TRUE(h.Del(i));
+  }
+  ASSERT_EQ(h.size(), 0);
+  ASSERT_EQ(h.Stats().slabs, 1);
+}
+
 auto main(int argc, char **argv) -> int {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::FLAGS_gtest_output = "stdout:";
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "../include/FlatHashMap.hpp"
+#include "../include/HashMap.hpp"
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(HeterogeneousLookupTestStringView, AssertionTrue) {
+  JAVA::HashMap<std::string, int, JAVA::StringHash, std::equal_to<>> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    h.Put("heterogeneous-lookup-" + std::to_string(i), i);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 20000; i++) {
+    std::string key = "heterogeneous-lookup-" + std::to_string(i);
+    std::string_view view = key;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 10000) {
+      ASSERT_EQ(h.Get(view), std::make_optional(i));
+      ASSERT_TRUE(h.Contain(view));
+    } else {
+      ASSERT_EQ(h.Get(view), std::nullopt);
+      ASSERT_FALSE(h.Contain(view));
+      ASSERT_FALSE(h.Del(view));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i += 2) {
+    std::string key = "heterogeneous-lookup-" + std::to_string(i);
+    ASSERT_TRUE(h.Del(std::string_view(key)));
+  }
+  ASSERT_EQ(h.size(), 5000);
+
+  ASSERT_EQ(h.Get("heterogeneous-lookup-1"), std::make_optional(1));
+  ASSERT_FALSE(h.Contain("heterogeneous-lookup-0"));
+  ASSERT_EQ(h.Get(std::string("heterogeneous-lookup-3")), std::make_optional(3));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(HeterogeneousLookupTestTagged, AssertionTrue) {
+  JAVA::TaggedHashMap<std::string, int, JAVA::StringHash, std::equal_to<>> h;
+  h.Put(std::string("Hello world"), 1);
+  h.Put(std::string("Hello world1"), 2);
+
+  ASSERT_EQ(h.Get(std::string_view("Hello world")), std::make_optional(1));
+  ASSERT_EQ(h.Get(std::string_view("Hello world2")), std::nullopt);
+  ASSERT_TRUE(h.Del(std::string_view("Hello world1")));
+  ASSERT_FALSE(h.Contain(std::string_view("Hello world1")));
+}
+
+// a key whose low bits are always equal, so lookups walk tree bins
+struct TransparentCollidingHash {
+  using is_transparent = void;
+
+  auto operator()(std::string_view /*unused*/) const noexcept -> std::size_t {
+    return 0;
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(HeterogeneousLookupTestTreeBin, AssertionTrue) {
+  JAVA::HashMap<std::string, int, TransparentCollidingHash, std::equal_to<>> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h.Put(std::to_string(i), i);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    std::string key = std::to_string(i);
+    ASSERT_EQ(h.Get(std::string_view(key)), std::make_optional(i));
+  }
+  ASSERT_FALSE(h.Contain(std::string_view("-1")));
+  ASSERT_TRUE(h.Del(std::string_view("500")));
+  ASSERT_EQ(h.Get(std::string_view("500")), std::nullopt);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(HeterogeneousLookupTestFlatHashMap, AssertionTrue) {
+  JAVA::FlatHashMap<std::string, int, JAVA::StringHash, std::equal_to<>> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h.Put(std::to_string(i), i);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    std::string key = std::to_string(i);
+    ASSERT_EQ(h.Get(std::string_view(key)), std::make_optional(i));
+  }
+  ASSERT_TRUE(h.Del(std::string_view("7")));
+  ASSERT_FALSE(h.Contain(std::string_view("7")));
+  ASSERT_EQ(h.size(), 999);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
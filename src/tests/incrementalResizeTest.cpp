@@ -0,0 +1,429 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+
+#include "../include/HashMap.hpp"
+#include "clusteredKey.hpp"
+
+template <typename Map>
+class IncrementalResizeTest : public ::testing::Test {};
+
+template <typename K, typename V>
+using TaggedIncrementalHashMap =
+    JAVA::HashMap<K, V, std::hash<K>, std::equal_to<K>,
+                  std::allocator<std::pair<const K, V>>, true, true>;
+
+using IncrementalResizeTestTypes =
+    ::testing::Types<JAVA::IncrementalHashMap<int, int>,
+                     TaggedIncrementalHashMap<int, int>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(IncrementalResizeTest, IncrementalResizeTestTypes);
+
+/**
+ * Inserts into h until a resize starts, so that the next operations run
+ * while the old table is still being moved.
+ */
+template <typename Map>
+auto putUntilResize(Map &h, int &next) -> void {
+  std::size_t buckets = h.bucketCount();
+  while (h.bucketCount() == buckets) {
+    h.Put(next, next + 1);
+    next++;
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IncrementalResizeTest, PutGetDel) {
+  TypeParam h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    h.Put(i, i + 1);
+    ASSERT_EQ(h.size(), i + 1);
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+    ASSERT_EQ(h.Get(i / 2), std::make_optional(i / 2 + 1));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 200000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 100000) {
+      ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+    } else {
+      ASSERT_FALSE(h.Contain(i));
+      ASSERT_FALSE(h.Del(i));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i += 2) {
+    ASSERT_TRUE(h.Del(i));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 50000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(h.Contain(i), i % 2 == 1);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IncrementalResizeTest, OperationsDuringResize) {
+  TypeParam h;
+  int next = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  while (next < 5000) {
+    putUntilResize(h, next);
+    // every key is reachable whether its bucket has moved or not
+    for (int i = 0; i < next; i++) {
+      ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+    }
+
+    // an update moves a few buckets but never the node it returns
+    h.Put(0, 1);
+    ASSERT_TRUE(h.InsertOrAssign(-next, 0));
+    ASSERT_FALSE(h.InsertOrAssign(-next, 1));
+    ASSERT_EQ(h.Get(-next), std::make_optional(1));
+    ASSERT_TRUE(h.Del(-next));
+    ASSERT_FALSE(h.Del(-next));
+
+    auto add = [](int old, int delta) -> std::optional<int> {
+      return old + delta;
+    };
+    ASSERT_EQ(*h.Merge(next - 1, 1, add), next + 1);
+    h.Put(next - 1, next);
+    ASSERT_EQ(static_cast<int>(h.size()), next);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IncrementalResizeTest, UpdatesFinishResize) {
+  TypeParam h;
+  int next = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  while (next < 1000) {
+    h.Put(next, next + 1);
+    next++;
+  }
+  putUntilResize(h, next);
+  std::size_t during = h.MemoryUsage();
+
+  // lookups leave both tables in place
+  const TypeParam &ch = h;
+  for (int i = 0; i < next; i++) {
+    ASSERT_EQ(ch.Get(i), std::make_optional(i + 1));
+  }
+  ASSERT_EQ(h.MemoryUsage(), during);
+
+  // updates alone move every bucket and drop the old table
+  for (std::size_t i = 0; i < h.bucketCount(); i++) {
+    int key = static_cast<int>(i) % next;
+    if (i % 3 == 0) {
+      h.Put(key, key + 1);
+    } else if (i % 3 == 1) {
+      ASSERT_TRUE(h.Update(key, [](int &value) { value += 0; }));
+    } else {
+      ASSERT_EQ(*h.Compute(key, [](const int &k, int * /*unused*/) {
+        return std::make_optional(k + 1);
+      }), key + 1);
+    }
+  }
+  ASSERT_LT(h.MemoryUsage(), during);
+  ASSERT_EQ(static_cast<int>(h.size()), next);
+  for (int i = 0; i < next; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+  }
+
+  // and so do hits of ComputeIfAbsent, as a cache sees them
+  putUntilResize(h, next);
+  during = h.MemoryUsage();
+  for (std::size_t i = 0; i < h.bucketCount(); i++) {
+    int key = static_cast<int>(i) % next;
+    ASSERT_EQ(h.ComputeIfAbsent(key, [](const int & /*unused*/) { return 0; }),
+              key + 1);
+  }
+  ASSERT_LT(h.MemoryUsage(), during);
+  ASSERT_EQ(static_cast<int>(h.size()), next);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IncrementalResizeTest, EraseDuringResize) {
+  // keys spread over both halves of the new table, so that finishing the
+  // resize would move entries ahead of and behind the walk
+  constexpr int STEP = 7919;
+  TypeParam h;
+  int count = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int round = 0; round < 6; round++) {
+    std::size_t buckets = h.bucketCount();
+    while (h.bucketCount() == buckets) {
+      h.Put(count * STEP, count);
+      count++;
+    }
+    // which has moved a few buckets before the walk starts
+    h.Put(count * STEP, count);
+    count++;
+
+    // erasing along a walk from cbegin() leaves the rest of the walk alone
+    std::map<int, int> visits;
+    const TypeParam &ch = h;
+    for (auto it = ch.cbegin(); it != ch.cend();) {
+      ++visits[it->second];
+      if (it->second % 2 == 0) {
+        it = h.Erase(it);
+      } else {
+        ++it;
+      }
+    }
+    ASSERT_EQ(static_cast<int>(visits.size()), count);
+    for (auto [i, visited] : visits) {
+      ASSERT_EQ(visited, 1);
+    }
+    for (int i = 0; i < count; i++) {
+      ASSERT_EQ(h.Contain(i * STEP), i % 2 == 1);
+    }
+
+    // put the even keys back for the next round
+    for (int i = 0; i < count; i += 2) {
+      h.Put(i * STEP, i);
+    }
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IncrementalResizeTest, IterationDuringResize) {
+  TypeParam h;
+  int next = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int round = 0; round < 6; round++) {
+    putUntilResize(h, next);
+
+    std::size_t count = 0;
+    const TypeParam &ch = h;
+    ch.ForEach([&count](const int &key, const int &value) {
+      ASSERT_EQ(value, key + 1);
+      count++;
+    });
+    ASSERT_EQ(count, h.size());
+    ASSERT_NE(ch.toString(), "{}");
+  }
+
+  // cbegin() walks both tables without moving anything, and Erase accepts
+  // the iterators it hands out
+  putUntilResize(h, next);
+  {
+    const TypeParam &ch = h;
+    std::set<int> seen;
+    for (auto it = ch.cbegin(); it != ch.cend(); ++it) {
+      ASSERT_EQ(it->second, it->first + 1);
+      ASSERT_TRUE(seen.insert(it->first).second);
+    }
+    ASSERT_EQ(seen.size(), h.size());
+
+    auto it = ch.cbegin();
+    int erased = (*it).first;
+    auto after = h.Erase(it);
+    ASSERT_FALSE(h.Contain(erased));
+    std::size_t rest = 0;
+    for (; after != h.end(); ++after) {
+      ASSERT_NE(after->first, erased);
+      rest++;
+    }
+    ASSERT_LE(rest, h.size());
+    h.Put(erased, erased + 1);
+  }
+
+  // begin() finishes the resize, the iterator sees every entry once
+  putUntilResize(h, next);
+  std::set<int> seen;
+  for (auto [key, value] : h) {
+    ASSERT_EQ(value, key + 1);
+    ASSERT_TRUE(seen.insert(key).second);
+  }
+  ASSERT_EQ(seen.size(), h.size());
+
+  putUntilResize(h, next);
+  std::size_t removed =
+      h.EraseIf([](const int &key, int & /*unused*/) { return key % 3 == 0; });
+  ASSERT_EQ(removed, static_cast<std::size_t>((next + 2) / 3));
+  for (int i = 0; i < next; i++) {
+    ASSERT_EQ(h.Contain(i), i % 3 != 0);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IncrementalResizeTest, RehashDuringResize) {
+  TypeParam h;
+  int next = 0;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  while (next < 1000) {
+    putUntilResize(h, next);
+  }
+  putUntilResize(h, next);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Reserve(100000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_GE(h.bucketCount(), 100000);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    h.Put(i, i + 1);
+  }
+  for (int i = next; i < 100000; i++) {
+    ASSERT_TRUE(h.Del(i));
+  }
+  putUntilResize(h, next);
+  h.ShrinkToFit();
+  for (int i = 0; i < next; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+  }
+  ASSERT_EQ(static_cast<int>(h.size()), next);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(IncrementalResizeTestTreeBins, AssertionTrue) {
+  // tree bins of the old table are split while their buckets move
+  JAVA::IncrementalHashMap<ClusteredKey, std::string> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i++) {
+    h.Put(ClusteredKey{i}, std::to_string(i));
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i % 7 == 0) {
+      ASSERT_TRUE(h.Del(ClusteredKey{i / 2}));
+      h.Put(ClusteredKey{i / 2}, std::to_string(i / 2));
+    }
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 50000);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i++) {
+    ASSERT_EQ(h.Get(ClusteredKey{i}), std::make_optional(std::to_string(i)));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i += 2) {
+    ASSERT_TRUE(h.Del(ClusteredKey{i}));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 50000; i++) {
+    ASSERT_EQ(h.Contain(ClusteredKey{i}), i % 2 == 1);
+  }
+}
+
+// keys 1000 to 1011 hash to 60 and keys 2000 to 2003 to 124, so at capacity
+// 64 they share a tree bin whose split leaves the 124 half as a list
+struct SplitBinHash {
+  auto operator()(int key) const noexcept -> std::size_t {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (key >= 1000 && key < 1012) {
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      return 60;
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (key >= 2000 && key < 2004) {
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      return 124;
+    }
+    return static_cast<std::size_t>(key);
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(IncrementalResizeTestEraseTreeBin, AssertionTrue) {
+  // Erase of a cbegin() iterator into a tree bin that the resize untreeifies
+  JAVA::HashMap<int, int, SplitBinHash, std::equal_to<>,
+                std::allocator<std::pair<const int, int>>, false, true>
+      h(64);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 1000; i < 1012; i++) {
+    h.Put(i, i + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 2000; i < 2004; i++) {
+    h.Put(i, i + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.bucketCount(), 64);
+  int next = 0;
+  putUntilResize(h, next);
+
+  const auto &ch = h;
+  auto it = ch.cbegin();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  while (it != ch.cend() && (it->first < 2000 || it->first >= 2004)) {
+    ++it;
+  }
+  ASSERT_NE(it, ch.cend());
+  int erased = it->first;
+  std::size_t size = h.size();
+  auto after = h.Erase(it);
+  ASSERT_FALSE(h.Contain(erased));
+  ASSERT_EQ(h.size(), size - 1);
+  for (; after != h.end(); ++after) {
+    ASSERT_NE(after->first, erased);
+    ASSERT_EQ(after->second, after->first + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 1000; i < 1012; i++) {
+    ASSERT_EQ(h.Get(i), std::make_optional(i + 1));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 2000; i < 2004; i++) {
+    ASSERT_EQ(h.Contain(i), i != erased);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(IncrementalResizeTestEraseTreeBinWalk, AssertionTrue) {
+  // erasing every key of a tree bin of the old table along a cbegin() walk,
+  // which rebuilds the bin as a list part way through
+  JAVA::HashMap<int, int, SplitBinHash, std::equal_to<>,
+                std::allocator<std::pair<const int, int>>, false, true>
+      h(64);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 1000; i < 1012; i++) {
+    h.Put(i, i + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 2000; i < 2004; i++) {
+    h.Put(i, i + 1);
+  }
+  int next = 0;
+  putUntilResize(h, next);
+
+  std::map<int, int> visits;
+  const auto &ch = h;
+  for (auto it = ch.cbegin(); it != ch.cend();) {
+    ++visits[it->first];
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (it->first >= 1000 || it->first % 3 == 0) {
+      it = h.Erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(static_cast<int>(visits.size()), next + 16);
+  for (auto [key, count] : visits) {
+    ASSERT_EQ(count, 1);
+  }
+  for (int i = 0; i < next; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Contain(i), i % 3 != 0);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_FALSE(h.Contain(1000));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(static_cast<int>(h.size()), next - (next + 2) / 3);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "../include/HashMap.hpp"
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(IteratorTestRangeFor, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  ASSERT_TRUE(h.begin() == h.end());
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    h.Put(i, i + 1);
+  }
+
+  std::set<int> seen;
+  for (auto [key, value] : h) {
+    ASSERT_EQ(value, key + 1);
+    ASSERT_TRUE(seen.insert(key).second);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(seen.size(), 10000);
+
+  // values are writable through a mutable iterator
+  for (auto it = h.begin(); it != h.end(); ++it) {
+    it->second *= 2;
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.Get(41), std::make_optional(84));
+
+  const JAVA::HashMap<int, int> &ch = h;
+  std::size_t count = 0;
+  for (JAVA::HashMap<int, int>::const_iterator it = ch.begin(); it != ch.end();
+       it++) {
+    ASSERT_EQ((*it).second, 2 * ((*it).first + 1));
+    count++;
+  }
+  ASSERT_EQ(count, h.size());
+
+  JAVA::HashMap<int, int>::const_iterator cit = h.begin();
+  ASSERT_TRUE(cit == h.cbegin());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(IteratorTestForEach, AssertionTrue) {
+  JAVA::HashMap<std::string, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h.Put(std::to_string(i), i);
+  }
+
+  long long sum = 0;
+  h.ForEach([&sum](const std::string &key, int &value) {
+    sum += value;
+    value = static_cast<int>(key.size());
+  });
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(sum, 999 * 1000 / 2);
+
+  const JAVA::HashMap<std::string, int> &ch = h;
+  ch.ForEach([](const std::string &key, const int &value) {
+    ASSERT_EQ(value, static_cast<int>(key.size()));
+  });
+}
+
+// every key lands in the same bucket, so the bin is a tree
+struct ZeroHash {
+  auto operator()(int /*unused*/) const noexcept -> std::size_t { return 0; }
+};
+
+template <typename Map>
+class IteratorTest : public ::testing::Test {};
+
+using IteratorTestTypes =
+    ::testing::Types<JAVA::HashMap<int, int>, JAVA::TaggedHashMap<int, int>,
+                     JAVA::HashMap<int, int, ZeroHash>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(IteratorTest, IteratorTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(IteratorTest, EraseDuringIteration) {
+  TypeParam h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 2000; i++) {
+    h.Put(i, i);
+  }
+
+  std::size_t visited = 0;
+  for (auto it = h.begin(); it != h.end();) {
+    visited++;
+    if (it->first % 3 == 0) {
+      it = h.Erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(visited, 2000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 2000 - 667);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_EQ(h.Contain(i), i % 3 != 0);
+  }
+
+  // erasing everything shrinks trees into lists on the way
+  ASSERT_EQ(h.EraseIf([](int /*unused*/, int /*unused*/) { return true; }),
+            // NOLINTNEXTLINE(readability-magic-numbers)
+            2000 - 667);
+  ASSERT_TRUE(h.empty());
+  ASSERT_TRUE(h.begin() == h.end());
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
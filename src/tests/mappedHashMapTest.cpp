@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "../include/HashMap.hpp"
+#include "../include/Hasher.hpp"
+#include "../include/MappedHashMap.hpp"
+
+static auto snapshotPath(const std::string &name) -> std::string {
+  return (std::filesystem::temp_directory_path() /
+          ("mappedHashMapTest_" + name + ".snapshot"))
+      .string();
+}
+
+struct Point {
+  std::int32_t x;
+  std::int16_t y;
+
+  auto operator==(const Point &other) const noexcept -> bool {
+    return x == other.x && y == other.y;
+  }
+};
+
+// addresses are not position independent, so they cannot be stored
+static_assert(JAVA::snapshot::is_storable<Point>);
+static_assert(!JAVA::snapshot::is_storable<const char *>);
+static_assert(!JAVA::snapshot::is_storable<int Point::*>);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(MappedHashMapTestInt, AssertionTrue) {
+  std::string path = snapshotPath("int");
+  JAVA::HashMap<int, int> h;
+  constexpr int ENTRIES = 100000;
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Put(i, i * 3);
+  }
+  h.SaveSnapshot(path);
+
+  JAVA::MappedHashMap<int, int> m(path);
+  ASSERT_EQ(m.size(), ENTRIES);
+  ASSERT_FALSE(m.empty());
+  ASSERT_GE(m.bucketCount(), ENTRIES);
+  for (int i = -ENTRIES; i < 2 * ENTRIES; i++) {
+    ASSERT_EQ(m.Get(i), h.Get(i));
+    ASSERT_EQ(m.Contain(i), i >= 0 && i < ENTRIES);
+  }
+
+  // the mapping moves with the map
+  JAVA::MappedHashMap<int, int> moved(std::move(m));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(moved.Get(7), std::make_optional(21));
+  std::filesystem::remove(path);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(moved.Get(7), std::make_optional(21));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(MappedHashMapTestString, AssertionTrue) {
+  std::string path = snapshotPath("string");
+  JAVA::HashMap<std::string, std::string, JAVA::StringHash, std::equal_to<>> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 5000; i++) {
+    h.Put(std::to_string(i), std::string(static_cast<std::size_t>(i % 7), 'v') +
+                                 std::to_string(i));
+  }
+  h.Put(std::string(), std::string());
+  h.SaveSnapshot(path);
+
+  JAVA::MappedHashMap<std::string, std::string, JAVA::StringHash,
+                      std::equal_to<>>
+      m(path);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(m.size(), 5001);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    std::string key = std::to_string(i);
+    std::optional<std::string> expected = h.Get(key);
+    std::optional<std::string_view> got = m.Get(std::string_view(key));
+    ASSERT_EQ(got.has_value(), expected.has_value());
+    if (got.has_value()) {
+      ASSERT_EQ(*got, *expected);
+    }
+    ASSERT_EQ(m.Contain(key.c_str()), expected.has_value());
+  }
+  ASSERT_EQ(m.Get(std::string()), std::make_optional(std::string_view()));
+  std::filesystem::remove(path);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(MappedHashMapTestTrivialValue, AssertionTrue) {
+  std::string path = snapshotPath("point");
+  JAVA::HashMap<std::string, Point> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Put(std::string("a"), Point{1, 2});
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Put(std::string("b"), Point{-3, 4});
+  h.SaveSnapshot(path);
+
+  JAVA::MappedHashMap<std::string, Point> m(path);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(m.Get(std::string("b")), std::make_optional(Point{-3, 4}));
+  ASSERT_FALSE(m.Contain(std::string("c")));
+  std::filesystem::remove(path);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(MappedHashMapTestEmpty, AssertionTrue) {
+  std::string path = snapshotPath("empty");
+  JAVA::HashMap<int, int> h;
+  h.SaveSnapshot(path);
+
+  JAVA::MappedHashMap<int, int> m(path);
+  ASSERT_TRUE(m.empty());
+  ASSERT_EQ(m.Get(0), std::nullopt);
+  ASSERT_FALSE(m.Contain(1));
+  std::filesystem::remove(path);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(MappedHashMapTestErrors, AssertionTrue) {
+  std::string path = snapshotPath("errors");
+  ASSERT_THROW((JAVA::MappedHashMap<int, int>(path)), std::system_error);
+
+  JAVA::HashMap<int, int> h;
+  h.Put(1, 1);
+  h.SaveSnapshot(path);
+  ASSERT_THROW((JAVA::MappedHashMap<int, double>(path)), std::runtime_error);
+  ASSERT_THROW((JAVA::MappedHashMap<std::string, int>(path)),
+               std::runtime_error);
+
+  // bucket offsets that would wrap around past the records are rejected
+  {
+    JAVA::snapshot::Header header{};
+    std::fstream file(path, std::ios_base::in | std::ios_base::out |
+                                std::ios_base::binary);
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    JAVA::snapshot::Header corrupted = header;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    corrupted.bucketBits = 3;
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    corrupted.bucketsOffset = ~std::uint64_t{0} - 63;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&corrupted), sizeof(corrupted));
+    file.close();
+    ASSERT_THROW((JAVA::MappedHashMap<int, int>(path)), std::runtime_error);
+
+    // as are buckets overlapping the header
+    corrupted = header;
+    corrupted.bucketsOffset = 0;
+    file.open(path, std::ios_base::in | std::ios_base::out |
+                        std::ios_base::binary);
+    file.write(reinterpret_cast<const char *>(&corrupted), sizeof(corrupted));
+    file.close();
+    ASSERT_THROW((JAVA::MappedHashMap<int, int>(path)), std::runtime_error);
+  }
+
+  // a truncated file is rejected
+  std::filesystem::resize_file(path, sizeof(JAVA::snapshot::Header) + 8);
+  ASSERT_THROW((JAVA::MappedHashMap<int, int>(path)), std::runtime_error);
+  std::filesystem::remove(path);
+
+  ASSERT_THROW(h.SaveSnapshot("/nonexistent-directory/snapshot"),
+               std::ios_base::failure);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(MappedHashMapTestSeeded, AssertionTrue) {
+  std::string path = snapshotPath("seeded");
+  JAVA::SeededHashMap<std::uint64_t, std::uint64_t> h;
+  constexpr std::uint64_t ENTRIES = 1000;
+  for (std::uint64_t i = 0; i < ENTRIES; i++) {
+    h.Put(i, i * 2);
+  }
+  h.SaveSnapshot(path);
+
+  // the seed of the map gives back its hash codes
+  std::pair<std::uint64_t, std::uint64_t> seed = h.hash_function().Seed();
+  JAVA::MappedHashMap<std::uint64_t, std::uint64_t, JAVA::SeededHash,
+                      std::equal_to<>>
+      m(path, JAVA::SeededHash(seed.first, seed.second));
+  ASSERT_EQ(m.size(), ENTRIES);
+  for (std::uint64_t i = 0; i < 2 * ENTRIES; i++) {
+    ASSERT_EQ(m.Get(i), h.Get(i));
+  }
+
+  // any other seed would miss every key, so the snapshot is rejected
+  ASSERT_THROW((JAVA::MappedHashMap<std::uint64_t, std::uint64_t,
+                                    JAVA::SeededHash, std::equal_to<>>(path)),
+               std::runtime_error);
+
+  JAVA::SeededHashMap<std::string, int> strings;
+  strings.Put(std::string("key"), 1);
+  strings.SaveSnapshot(path);
+  seed = strings.hash_function().Seed();
+  JAVA::MappedHashMap<std::string, int, JAVA::SeededHash, std::equal_to<>>
+      mappedStrings(path, JAVA::SeededHash(seed.first, seed.second));
+  ASSERT_EQ(mappedStrings.Get("key"), std::make_optional(1));
+  ASSERT_THROW((JAVA::MappedHashMap<std::string, int, JAVA::SeededHash,
+                                    std::equal_to<>>(path)),
+               std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(MappedHashMapTestResave, AssertionTrue) {
+  // saving over a mapped snapshot leaves the old mapping intact
+  std::string path = snapshotPath("resave");
+  JAVA::HashMap<int, int> big;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    big.Put(i, i + 1);
+  }
+  big.SaveSnapshot(path);
+  JAVA::MappedHashMap<int, int> m(path);
+
+  JAVA::HashMap<int, int> small;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  small.Put(7, 8);
+  small.SaveSnapshot(path);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(m.Get(i), std::make_optional(i + 1));
+  }
+
+  JAVA::MappedHashMap<int, int> reopened(path);
+  ASSERT_EQ(reopened.size(), 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(reopened.Get(7), std::make_optional(8));
+  std::filesystem::remove(path);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(MappedHashMapTestBadStringRef, AssertionTrue) {
+  // a string past the end of the strings section is cut off, not read
+  std::string path = snapshotPath("badref");
+  JAVA::HashMap<std::string, std::string> h;
+  h.Put(std::string("key"), std::string("value"));
+  h.SaveSnapshot(path);
+
+  JAVA::snapshot::Header header{};
+  {
+    std::fstream file(path, std::ios_base::in | std::ios_base::out |
+                                std::ios_base::binary);
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    JAVA::snapshot::StringRef ref{header.stringsSize - 1, 1 << 20};
+    file.seekp(static_cast<std::streamoff>(
+        header.recordsOffset +
+        JAVA::snapshot::Layout<std::string, std::string>::VALUE_OFFSET));
+    file.write(reinterpret_cast<const char *>(&ref), sizeof(ref));
+  }
+
+  JAVA::MappedHashMap<std::string, std::string> m(path);
+  ASSERT_EQ(m.Get(std::string("key")),
+            std::make_optional(std::string_view("e")));
+  std::filesystem::remove(path);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,614 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../include/FlatHashMap.hpp"
+#include "../include/FrozenHashMap.hpp"
+#include "../include/HashMap.hpp"
+
+/**
+ * One benchmark per operation, parameterized by
+ *
+ *   range(0): entries in the map
+ *   range(1): key distribution, see Dist
+ *   range(2): load factor in percent, for the maps that take one
+ *
+ * and instantiated for JAVA::HashMap, JAVA::FlatHashMap and
+ * std::unordered_map with integer and string keys and values. Keys are
+ * generated before the timed region, and every result goes through
+ * DoNotOptimize. Sizes go from 1K to 1M by default, set
+ * HASHMAP_BENCHMARK_MAX_SIZE to go up to 100M.
+ */
+namespace {
+
+enum class Dist : std::int64_t {
+  // keys 0, 1, 2, ... looked up in order, the best case of identity hashes
+  SEQUENTIAL,
+  // random keys looked up in random order
+  UNIFORM,
+  // random keys, a few of them looked up far more often than the rest
+  ZIPF,
+  // integer keys that differ only above bit 32, so they share the low bits
+  // that pick a bucket in a power of two table. String keys are only
+  // distinct.
+  COLLIDING,
+};
+
+constexpr std::int64_t DEFAULT_MAX_SIZE = 1 << 20;
+
+constexpr std::int64_t LARGEST_SIZE = 100000000;
+
+// lookups per iteration are capped, so that large maps do not need a
+// lookup sequence as large as themselves
+constexpr std::size_t MAX_LOOKUPS = 1 << 20;
+
+constexpr double ZIPF_THETA = 0.99;
+
+constexpr std::uint64_t SEED = 0x5EED;
+
+/**
+ * Zipfian ranks in [0, n), from "Quickly Generating Billion-Record
+ * Synthetic Databases" by Gray et al., as used by YCSB.
+ */
+class ZipfGenerator {
+ public:
+  explicit ZipfGenerator(std::uint64_t n, double theta = ZIPF_THETA)
+      : n_(n), theta_(theta) {
+    for (std::uint64_t i = 1; i <= n; i++) {
+      zetaN_ += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+    alpha_ = 1.0 / (1.0 - theta);
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) /
+           (1.0 - zeta2 / zetaN_);
+  }
+
+  template <typename Rng>
+  auto operator()(Rng &rng) -> std::uint64_t {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    double uz = u * zetaN_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    auto rank = static_cast<std::uint64_t>(
+        static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, n_ - 1);
+  }
+
+ private:
+  std::uint64_t n_;
+
+  double theta_;
+
+  double zetaN_ = 0;
+
+  double alpha_ = 0;
+
+  double eta_ = 0;
+};
+
+/**
+ * The i-th key of a distribution. Misses use indices past the entries.
+ */
+auto rawKey(Dist dist, std::uint64_t i) -> std::uint64_t {
+  switch (dist) {
+    case Dist::SEQUENTIAL:
+      return i;
+    case Dist::COLLIDING:
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      return i << 32;
+    default:
+      // a bijection, so distinct indices give distinct random looking keys
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      return (i ^ SEED) * 0x9E3779B97F4A7C15ULL;
+  }
+}
+
+template <typename T>
+auto makeValue(std::uint64_t raw) -> T {
+  if constexpr (std::is_same_v<T, std::string>) {
+    // longer than the small string buffer, like most real string keys
+    return "benchmark-key-" + std::to_string(raw);
+  } else {
+    return static_cast<T>(raw);
+  }
+}
+
+template <typename K>
+auto makeKeys(Dist dist, std::uint64_t first, std::uint64_t count)
+    -> std::vector<K> {
+  std::vector<K> keys;
+  keys.reserve(count);
+  for (std::uint64_t i = first; i < first + count; i++) {
+    keys.push_back(makeValue<K>(rawKey(dist, i)));
+  }
+  return keys;
+}
+
+/**
+ * Indices into the n inserted keys in the order they are looked up.
+ */
+auto lookupOrder(Dist dist, std::uint64_t n, std::size_t count)
+    -> std::vector<std::uint64_t> {
+  std::vector<std::uint64_t> order(count);
+  std::mt19937_64 rng(SEED);
+  if (dist == Dist::SEQUENTIAL) {
+    std::iota(order.begin(), order.end(), 0);
+  } else if (dist == Dist::ZIPF) {
+    ZipfGenerator zipf(n);
+    // the popular ranks must not all be neighbours in the table
+    std::vector<std::uint64_t> shuffle(n);
+    std::iota(shuffle.begin(), shuffle.end(), 0);
+    std::shuffle(shuffle.begin(), shuffle.end(), rng);
+    for (std::uint64_t &i : order) {
+      i = shuffle[zipf(rng)];
+    }
+  } else {
+    std::uniform_int_distribution<std::uint64_t> pick(0, n - 1);
+    for (std::uint64_t &i : order) {
+      i = pick(rng);
+    }
+  }
+  return order;
+}
+
+/**
+ * The operations of the benchmarks on every map type. Maps are held by
+ * std::unique_ptr since the JAVA maps cannot be moved.
+ */
+template <typename Map>
+struct Ops {
+  using Key = typename Map::key_type;
+
+  static auto make(double loadFactor) -> std::unique_ptr<Map> {
+    auto map = std::make_unique<Map>();
+    map->max_load_factor(static_cast<float>(loadFactor));
+    return map;
+  }
+
+  template <typename K, typename V>
+  static auto put(Map &map, K &&key, V &&value) -> void {
+    map.insert_or_assign(std::forward<K>(key), std::forward<V>(value));
+  }
+
+  static auto get(const Map &map, const Key &key) -> bool {
+    auto it = map.find(key);
+    if (it == map.end()) {
+      return false;
+    }
+    benchmark::DoNotOptimize(it->second);
+    return true;
+  }
+
+  static auto del(Map &map, const Key &key) -> bool {
+    return map.erase(key) != 0;
+  }
+
+  template <typename Fn>
+  static auto forEach(const Map &map, Fn &&fn) -> void {
+    for (const auto &entry : map) {
+      fn(entry.first, entry.second);
+    }
+  }
+
+  static auto reserve(Map &map, std::size_t n) -> void { map.reserve(n); }
+
+  constexpr static bool ITERABLE = true;
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+struct Ops<JAVA::HashMap<K, V, Hash, KeyEqual>> {
+  using Map = JAVA::HashMap<K, V, Hash, KeyEqual>;
+
+  using Key = K;
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  constexpr static std::size_t INITIAL_CAPACITY = 16;
+
+  static auto make(double loadFactor) -> std::unique_ptr<Map> {
+    return std::make_unique<Map>(INITIAL_CAPACITY,
+                                 static_cast<float>(loadFactor));
+  }
+
+  template <typename KeyArg, typename ValueArg>
+  static auto put(Map &map, KeyArg &&key, ValueArg &&value) -> void {
+    map.InsertOrAssign(std::forward<KeyArg>(key),
+                       std::forward<ValueArg>(value));
+  }
+
+  static auto get(const Map &map, const Key &key) -> bool {
+    const V *value = map.Find(key);
+    if (value == nullptr) {
+      return false;
+    }
+    benchmark::DoNotOptimize(*value);
+    return true;
+  }
+
+  static auto del(Map &map, const Key &key) -> bool { return map.Del(key); }
+
+  template <typename Fn>
+  static auto forEach(const Map &map, Fn &&fn) -> void {
+    for (auto [key, value] : map) {
+      fn(key, value);
+    }
+  }
+
+  static auto reserve(Map &map, std::size_t n) -> void { map.Reserve(n); }
+
+  constexpr static bool ITERABLE = true;
+};
+
+// FlatHashMap has a fixed load factor and no iteration
+template <typename K, typename V>
+struct Ops<JAVA::FlatHashMap<K, V>> {
+  using Map = JAVA::FlatHashMap<K, V>;
+
+  using Key = K;
+
+  static auto make(double /*unused*/) -> std::unique_ptr<Map> {
+    return std::make_unique<Map>();
+  }
+
+  template <typename KeyArg, typename ValueArg>
+  static auto put(Map &map, KeyArg &&key, ValueArg &&value) -> void {
+    map.InsertOrAssign(std::forward<KeyArg>(key),
+                       std::forward<ValueArg>(value));
+  }
+
+  static auto get(const Map &map, const Key &key) -> bool {
+    const V *value = map.Find(key);
+    if (value == nullptr) {
+      return false;
+    }
+    benchmark::DoNotOptimize(*value);
+    return true;
+  }
+
+  static auto del(Map &map, const Key &key) -> bool { return map.Del(key); }
+
+  constexpr static bool ITERABLE = false;
+};
+
+struct Params {
+  std::uint64_t size;
+
+  Dist dist;
+
+  double loadFactor;
+
+  explicit Params(const benchmark::State &state)
+      : size(static_cast<std::uint64_t>(state.range(0))),
+        dist(static_cast<Dist>(state.range(1))),
+        // NOLINTNEXTLINE(readability-magic-numbers)
+        loadFactor(static_cast<double>(state.range(2)) / 100.0) {}
+};
+
+template <typename Map, typename V>
+auto build(const Params &params,
+           const std::vector<typename Ops<Map>::Key> &keys)
+    -> std::unique_ptr<Map> {
+  std::unique_ptr<Map> map = Ops<Map>::make(params.loadFactor);
+  for (std::uint64_t i = 0; i < keys.size(); i++) {
+    Ops<Map>::put(*map, keys[i], makeValue<V>(i));
+  }
+  return map;
+}
+
+/**
+ * Inserts all keys into an empty map, resizes included.
+ */
+template <typename Map, typename V>
+void PutBenchmark(benchmark::State &state) {
+  Params params(state);
+  using K = typename Ops<Map>::Key;
+  std::vector<K> keys = makeKeys<K>(params.dist, 0, params.size);
+  std::vector<V> values;
+  values.reserve(params.size);
+  for (std::uint64_t i = 0; i < params.size; i++) {
+    values.push_back(makeValue<V>(i));
+  }
+  for (auto _ : state) {
+    std::unique_ptr<Map> map = Ops<Map>::make(params.loadFactor);
+    for (std::uint64_t i = 0; i < params.size; i++) {
+      Ops<Map>::put(*map, keys[i], values[i]);
+    }
+    benchmark::DoNotOptimize(map.get());
+    // the map is destroyed outside the timed region
+    state.PauseTiming();
+    map.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(params.size));
+}
+
+/**
+ * Looks up present keys, in the order of the distribution.
+ */
+template <typename Map, typename V>
+void GetHitBenchmark(benchmark::State &state) {
+  Params params(state);
+  using K = typename Ops<Map>::Key;
+  std::vector<K> keys = makeKeys<K>(params.dist, 0, params.size);
+  std::unique_ptr<Map> map = build<Map, V>(params, keys);
+  std::vector<std::uint64_t> order =
+      lookupOrder(params.dist, params.size,
+                  std::min<std::size_t>(params.size, MAX_LOOKUPS));
+  std::vector<K> lookups;
+  lookups.reserve(order.size());
+  for (std::uint64_t i : order) {
+    lookups.push_back(keys[i]);
+  }
+  for (auto _ : state) {
+    for (const K &key : lookups) {
+      benchmark::DoNotOptimize(Ops<Map>::get(*map, key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(lookups.size()));
+}
+
+/**
+ * Looks up keys of the same distribution that are not in the map.
+ */
+template <typename Map, typename V>
+void GetMissBenchmark(benchmark::State &state) {
+  Params params(state);
+  using K = typename Ops<Map>::Key;
+  std::unique_ptr<Map> map =
+      build<Map, V>(params, makeKeys<K>(params.dist, 0, params.size));
+  std::vector<K> misses =
+      makeKeys<K>(params.dist, params.size,
+                  std::min<std::size_t>(params.size, MAX_LOOKUPS));
+  for (auto _ : state) {
+    for (const K &key : misses) {
+      benchmark::DoNotOptimize(Ops<Map>::get(*map, key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(misses.size()));
+}
+
+/**
+ * Removes every key of a full map, in the order of the distribution.
+ */
+template <typename Map, typename V>
+void DelBenchmark(benchmark::State &state) {
+  Params params(state);
+  using K = typename Ops<Map>::Key;
+  std::vector<K> keys = makeKeys<K>(params.dist, 0, params.size);
+  std::vector<std::uint64_t> order(params.size);
+  std::iota(order.begin(), order.end(), 0);
+  if (params.dist != Dist::SEQUENTIAL) {
+    std::mt19937_64 rng(SEED);
+    std::shuffle(order.begin(), order.end(), rng);
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<Map> map = build<Map, V>(params, keys);
+    state.ResumeTiming();
+    for (std::uint64_t i : order) {
+      benchmark::DoNotOptimize(Ops<Map>::del(*map, keys[i]));
+    }
+    state.PauseTiming();
+    map.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(params.size));
+}
+
+/**
+ * Visits every entry.
+ */
+template <typename Map, typename V>
+void IterateBenchmark(benchmark::State &state) {
+  Params params(state);
+  using K = typename Ops<Map>::Key;
+  std::unique_ptr<Map> map =
+      build<Map, V>(params, makeKeys<K>(params.dist, 0, params.size));
+  for (auto _ : state) {
+    std::size_t visited = 0;
+    Ops<Map>::forEach(*map, [&visited](const K &key, const V &value) {
+      benchmark::DoNotOptimize(key);
+      benchmark::DoNotOptimize(value);
+      ++visited;
+    });
+    benchmark::DoNotOptimize(visited);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(params.size));
+}
+
+/**
+ * Grows a full map to twice its bucket count in one go.
+ */
+template <typename Map, typename V>
+void ResizeBenchmark(benchmark::State &state) {
+  Params params(state);
+  using K = typename Ops<Map>::Key;
+  std::vector<K> keys = makeKeys<K>(params.dist, 0, params.size);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<Map> map = build<Map, V>(params, keys);
+    state.ResumeTiming();
+    Ops<Map>::reserve(*map, 2 * params.size);
+    benchmark::DoNotOptimize(map.get());
+    state.PauseTiming();
+    map.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(params.size));
+}
+
+/**
+ * Inserts and then looks up COLLIDING keys, which the default hash puts in
+ * a handful of buckets. Reports the longest chain and the tree bins the
+ * keys end up in, to compare the default hash with SeededHash.
+ */
+template <typename Map>
+void CollisionAttackBenchmark(benchmark::State &state) {
+  auto size = static_cast<std::uint64_t>(state.range(0));
+  std::vector<std::uint64_t> keys =
+      makeKeys<std::uint64_t>(Dist::COLLIDING, 0, size);
+  JAVA::HashMapStats stats;
+  for (auto _ : state) {
+    std::unique_ptr<Map> map = std::make_unique<Map>();
+    for (std::uint64_t i = 0; i < size; i++) {
+      map->InsertOrAssign(keys[i], i);
+    }
+    for (std::uint64_t key : keys) {
+      benchmark::DoNotOptimize(map->Find(key));
+    }
+    state.PauseTiming();
+    stats = map->Stats();
+    map.reset();
+    state.ResumeTiming();
+  }
+  state.counters["maxChain"] = static_cast<double>(stats.maxChain);
+  state.counters["treeBins"] = static_cast<double>(stats.treeBins);
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(2 * size));
+}
+
+/**
+ * Looks up present keys of a FrozenHashMap built from a HashMap, to set
+ * against GetHit of the HashMap with the same distribution.
+ */
+template <typename K, typename V>
+void FrozenGetHitBenchmark(benchmark::State &state) {
+  Params params(state);
+  std::vector<K> keys = makeKeys<K>(params.dist, 0, params.size);
+  std::unique_ptr<JAVA::HashMap<K, V>> source =
+      build<JAVA::HashMap<K, V>, V>(params, keys);
+  JAVA::FrozenHashMap<K, V> map(source->begin(), source->end());
+  source.reset();
+  std::vector<std::uint64_t> order =
+      lookupOrder(params.dist, params.size,
+                  std::min<std::size_t>(params.size, MAX_LOOKUPS));
+  std::vector<K> lookups;
+  lookups.reserve(order.size());
+  for (std::uint64_t i : order) {
+    lookups.push_back(keys[i]);
+  }
+  for (auto _ : state) {
+    for (const K &key : lookups) {
+      benchmark::DoNotOptimize(map.Find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(lookups.size()));
+}
+
+auto maxSize() -> std::int64_t {
+  const char *env = std::getenv("HASHMAP_BENCHMARK_MAX_SIZE");
+  if (env == nullptr) {
+    return DEFAULT_MAX_SIZE;
+  }
+  std::int64_t size = std::strtoll(env, nullptr, 10);
+  return size > 0 ? std::min(size, LARGEST_SIZE) : DEFAULT_MAX_SIZE;
+}
+
+auto applyArgs(benchmark::internal::Benchmark *b) -> void {
+  std::vector<std::int64_t> sizes;
+  std::int64_t max = maxSize();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (std::int64_t size = 1 << 10; size <= max; size *= 32) {
+    sizes.push_back(size);
+  }
+  if (max == LARGEST_SIZE) {
+    sizes.push_back(LARGEST_SIZE);
+  }
+  b->ArgNames({"size", "dist", "load%"});
+  b->ArgsProduct({sizes,
+                  {static_cast<std::int64_t>(Dist::SEQUENTIAL),
+                   static_cast<std::int64_t>(Dist::UNIFORM),
+                   static_cast<std::int64_t>(Dist::ZIPF),
+                   static_cast<std::int64_t>(Dist::COLLIDING)},
+                  // NOLINTNEXTLINE(readability-magic-numbers)
+                  {50, 75, 100}});
+  b->Unit(benchmark::kMicrosecond);
+}
+
+auto applyAttackArgs(benchmark::internal::Benchmark *b) -> void {
+  std::int64_t max = std::min<std::int64_t>(maxSize(), DEFAULT_MAX_SIZE);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (std::int64_t size = 1 << 10; size <= max; size *= 32) {
+    b->Arg(size);
+  }
+  b->ArgName("size");
+  b->Unit(benchmark::kMicrosecond);
+}
+
+template <typename Map, typename V>
+auto registerMap(const std::string &name) -> void {
+  benchmark::RegisterBenchmark(("Put<" + name + ">").c_str(),
+                               PutBenchmark<Map, V>)
+      ->Apply(applyArgs);
+  benchmark::RegisterBenchmark(("GetHit<" + name + ">").c_str(),
+                               GetHitBenchmark<Map, V>)
+      ->Apply(applyArgs);
+  benchmark::RegisterBenchmark(("GetMiss<" + name + ">").c_str(),
+                               GetMissBenchmark<Map, V>)
+      ->Apply(applyArgs);
+  benchmark::RegisterBenchmark(("Del<" + name + ">").c_str(),
+                               DelBenchmark<Map, V>)
+      ->Apply(applyArgs);
+  if constexpr (Ops<Map>::ITERABLE) {
+    benchmark::RegisterBenchmark(("Iterate<" + name + ">").c_str(),
+                                 IterateBenchmark<Map, V>)
+        ->Apply(applyArgs);
+    benchmark::RegisterBenchmark(("Resize<" + name + ">").c_str(),
+                                 ResizeBenchmark<Map, V>)
+        ->Apply(applyArgs);
+  }
+}
+
+auto registerSuite() -> bool {
+  using U64 = std::uint64_t;
+  registerMap<JAVA::HashMap<U64, U64>, U64>("HashMap<u64,u64>");
+  registerMap<JAVA::FlatHashMap<U64, U64>, U64>("FlatHashMap<u64,u64>");
+  registerMap<std::unordered_map<U64, U64>, U64>("unordered_map<u64,u64>");
+  registerMap<JAVA::HashMap<std::string, std::string>, std::string>(
+      "HashMap<string,string>");
+  registerMap<JAVA::FlatHashMap<std::string, std::string>, std::string>(
+      "FlatHashMap<string,string>");
+  registerMap<std::unordered_map<std::string, std::string>, std::string>(
+      "unordered_map<string,string>");
+  benchmark::RegisterBenchmark("GetHit<FrozenHashMap<u64,u64>>",
+                               FrozenGetHitBenchmark<U64, U64>)
+      ->Apply(applyArgs);
+  benchmark::RegisterBenchmark(
+      "GetHit<FrozenHashMap<string,string>>",
+      FrozenGetHitBenchmark<std::string, std::string>)
+      ->Apply(applyArgs);
+  benchmark::RegisterBenchmark(
+      "CollisionAttack<HashMap<u64,u64>>",
+      CollisionAttackBenchmark<JAVA::HashMap<U64, U64>>)
+      ->Apply(applyAttackArgs);
+  benchmark::RegisterBenchmark(
+      "CollisionAttack<SeededHashMap<u64,u64>>",
+      CollisionAttackBenchmark<JAVA::SeededHashMap<U64, U64>>)
+      ->Apply(applyAttackArgs);
+  return true;
+}
+
+const bool REGISTERED = registerSuite();
+
+}  // namespace
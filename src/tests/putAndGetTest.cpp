@@ -3,6 +3,7 @@
 #include <optional>
 #include <string>
 
+#include "../include/FlatHashMap.hpp"
 #include "../include/HashMap.hpp"
 
 // NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
@@ -100,6 +101,46 @@ TEST(PutAndGetTestMyClassType, AssertionTrue) {
   ASSERT_EQ(h.Get(obj4), std::nullopt);
 }
 
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(PutAndGetTestFlatHashMap, AssertionTrue) {
+  JAVA::FlatHashMap<int, int> h1;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h1.Put(i, i + 1);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 1000) {
+      ASSERT_EQ(h1.Get(i), std::make_optional(i + 1));
+    } else {
+      ASSERT_EQ(h1.Get(i), std::nullopt);
+    }
+  }
+
+  JAVA::FlatHashMap<std::string, int> h3;
+  h3.Put(std::string("Hello world"), 1);
+  h3.Put(std::string("Hello world"), 2);
+  h3.Put(std::string("Hello world1"), 3);
+
+  ASSERT_NE(h3.Get(std::string("Hello world")), std::make_optional(1));
+  ASSERT_EQ(h3.Get(std::string("Hello world")), std::make_optional(2));
+  ASSERT_EQ(h3.Get(std::string("Hello world1")), std::make_optional(3));
+  ASSERT_EQ(h3.Get(std::string("Hello world2")), std::nullopt);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  MyClass obj1("jack", 42);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  MyClass obj2("Tom", 42);
+  JAVA::FlatHashMap<MyClass, std::string> h;
+  h.Put(obj1, std::string("lisa"));
+  h.Put(obj1, std::string("liSA"));
+  h.Put(obj2, std::string("Kali"));
+  ASSERT_EQ(h.Get(obj1), std::make_optional(std::string("liSA")));
+  ASSERT_EQ(h.Get(obj2), std::make_optional(std::string("Kali")));
+  ASSERT_EQ(h.size(), 2);
+}
+
 auto main(int argc, char **argv) -> int {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::FLAGS_gtest_output = "stdout:";
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+#include "../include/HashMap.hpp"
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(ReserveTestConstructor, AssertionTrue) {
+  JAVA::HashMap<int, int> h1;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h1.bucketCount(), 16);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  JAVA::HashMap<int, int> h2(100);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h2.bucketCount(), 128);
+
+  JAVA::HashMap<int, int> h3(0);
+  ASSERT_EQ(h3.bucketCount(), 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h3.Put(i, i);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h3.size(), 1000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h3.Get(999), std::make_optional(999));
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  JAVA::HashMap<int, int> h4(16, 4.0F);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 64; i++) {
+    h4.Put(i, i);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h4.bucketCount(), 16);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_THROW((JAVA::HashMap<int, int>(16, 0.0F)), std::invalid_argument);
+  ASSERT_THROW((JAVA::HashMap<int, int>(
+                   // NOLINTNEXTLINE(readability-magic-numbers)
+                   16, std::numeric_limits<float>::quiet_NaN())),
+               std::invalid_argument);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(ReserveTestReserve, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Put(-1, -1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Reserve(100000);
+  std::size_t buckets = h.bucketCount();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    h.Put(i, i);
+  }
+  ASSERT_EQ(h.bucketCount(), buckets);
+  ASSERT_EQ(h.Get(-1), std::make_optional(-1));
+
+  // reserving less than what is there never shrinks
+  h.Reserve(0);
+  ASSERT_EQ(h.bucketCount(), buckets);
+}
+
+template <typename Map>
+class ReserveTest : public ::testing::Test {};
+
+using ReserveTestTypes =
+    ::testing::Types<JAVA::HashMap<long long, int>,
+                     JAVA::TaggedHashMap<long long, int>>;
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TYPED_TEST_SUITE(ReserveTest, ReserveTestTypes);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TYPED_TEST(ReserveTest, ShrinkAndRehash) {
+  TypeParam h;
+  // keys sharing their low bits keep some bins long enough to be trees
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 50000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    h.Put(i << 20, static_cast<int>(i));
+  }
+  std::size_t full = h.bucketCount();
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 50000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i % 100 != 0) {
+      // NOLINTNEXTLINE(readability-magic-numbers)
+      ASSERT_TRUE(h.Del(i << 20));
+    }
+  }
+  ASSERT_EQ(h.bucketCount(), full);
+
+  h.ShrinkToFit();
+  ASSERT_LT(h.bucketCount(), full);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.size(), 500);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 50000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(i << 20), i % 100 == 0
+                                  ? std::make_optional(static_cast<int>(i))
+                                  : std::nullopt);
+  }
+
+  // grow by more than one doubling in one step
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Rehash(1 << 16);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.bucketCount(), 1 << 16);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 50000; i += 100) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(i << 20), std::make_optional(static_cast<int>(i)));
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_TRUE(h.Del(i << 20));
+  }
+  ASSERT_TRUE(h.empty());
+
+  h.ShrinkToFit();
+  ASSERT_EQ(h.bucketCount(), 1);
+  h.Put(1LL, 1);
+  ASSERT_EQ(h.Get(1LL), std::make_optional(1));
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../include/HashMap.hpp"
+#include "../include/Hasher.hpp"
+
+namespace {
+
+// keys that differ only above bit 32, so that after the h ^ (h >> 16) of
+// the default hash they share the low 16 bits and with them the bucket of
+// every table of up to 65536 buckets
+auto collidingKey(std::uint64_t i) -> std::uint64_t {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  return i << 32;
+}
+
+constexpr std::uint64_t ATTACK_KEYS = 4096;
+
+}  // namespace
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(SeededHashTestSipHashVectors, AssertionTrue) {
+  // reference vectors of SipHash-2-4 with key 00 01 .. 0f and the messages
+  // 00 01 .. (n - 1)
+  // NOLINTBEGIN(readability-magic-numbers)
+  constexpr std::uint64_t K0 = 0x0706050403020100ULL;
+  constexpr std::uint64_t K1 = 0x0F0E0D0C0B0A0908ULL;
+  std::array<char, 16> message{};
+  for (std::size_t i = 0; i < message.size(); i++) {
+    message[i] = static_cast<char>(i);
+  }
+  ASSERT_EQ((JAVA::hashing::sipHash<2, 4>(K0, K1, message.data(), 0)),
+            0x726FDB47DD0E0E31ULL);
+  ASSERT_EQ((JAVA::hashing::sipHash<2, 4>(K0, K1, message.data(), 1)),
+            0x74F839C593DC67FDULL);
+  ASSERT_EQ((JAVA::hashing::sipHash<2, 4>(K0, K1, message.data(), 8)),
+            0x93F5F5799A932462ULL);
+  ASSERT_EQ((JAVA::hashing::sipHash<2, 4>(K0, K1, message.data(), 15)),
+            0xA129CA6149BE45E5ULL);
+  // NOLINTEND(readability-magic-numbers)
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(SeededHashTestSeeds, AssertionTrue) {
+  JAVA::SeededHash a;
+  JAVA::SeededHash b;
+  ASSERT_NE(a.Seed(), b.Seed());
+  ASSERT_NE(a(std::string_view("key")), b(std::string_view("key")));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_NE(a(42), b(42));
+
+  // the same seed gives the same hash codes
+  JAVA::SeededHash c(a.Seed().first, a.Seed().second);
+  ASSERT_EQ(a(std::string_view("key")), c(std::string_view("key")));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(a(42), c(42));
+
+  // every string type and every integer type hashes alike
+  ASSERT_EQ(a(std::string("key")), a(std::string_view("key")));
+  ASSERT_EQ(a("key"), a(std::string_view("key")));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(a(42), a(42ULL));
+  ASSERT_EQ(a(-1), a(-1LL));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(SeededHashTestCollisionAttack, AssertionTrue) {
+  JAVA::HashMap<std::uint64_t, std::uint64_t> plain;
+  JAVA::SeededHashMap<std::uint64_t, std::uint64_t> seeded;
+  for (std::uint64_t i = 0; i < ATTACK_KEYS; i++) {
+    plain.Put(collidingKey(i), i);
+    seeded.Put(collidingKey(i), i);
+  }
+
+  // the default hash puts every key in one bucket, which only its tree bin
+  // keeps from being a linear list
+  JAVA::HashMapStats plainStats = plain.Stats();
+  ASSERT_EQ(plainStats.maxChain, ATTACK_KEYS);
+  ASSERT_EQ(plainStats.treeBins, 1);
+
+  // the seeded hash spreads them like random keys
+  JAVA::HashMapStats seededStats = seeded.Stats();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_LE(seededStats.maxChain, 8);
+  ASSERT_EQ(seededStats.treeBins, 0);
+
+  for (std::uint64_t i = 0; i < ATTACK_KEYS; i++) {
+    ASSERT_EQ(seeded.Get(collidingKey(i)), i);
+  }
+  ASSERT_FALSE(seeded.Contain(collidingKey(ATTACK_KEYS)));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(SeededHashTestStringKeys, AssertionTrue) {
+  JAVA::SeededHashMap<std::string, int> h;
+  constexpr int ENTRIES = 1000;
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Put("key-" + std::to_string(i), i);
+  }
+  ASSERT_EQ(h.size(), ENTRIES);
+  ASSERT_EQ(h.Get(std::string_view("key-7")), 7);
+  ASSERT_EQ(h.Get("key-999"), 999);
+  ASSERT_FALSE(h.Contain("key-1000"));
+  ASSERT_TRUE(h.Del(std::string_view("key-0")));
+  ASSERT_FALSE(h.Contain(std::string("key-0")));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_LE(h.Stats().maxChain, 8);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "../include/HashMap.hpp"
+#include "../include/Serialization.hpp"
+
+struct Tagged {
+  std::string name;
+  int weight;
+
+  auto operator==(const Tagged &other) const noexcept -> bool {
+    return name == other.name && weight == other.weight;
+  }
+};
+
+template <>
+struct JAVA::Codec<Tagged> {
+  static auto encode(const Tagged &value, std::string &out) -> void {
+    Codec<std::string>::encode(value.name, out);
+    Codec<int>::encode(value.weight, out);
+  }
+
+  static auto decode(std::string_view &in) -> std::optional<Tagged> {
+    std::optional<std::string> name = Codec<std::string>::decode(in);
+    std::optional<int> weight = Codec<int>::decode(in);
+    if (!name.has_value() || !weight.has_value()) {
+      return std::nullopt;
+    }
+    return Tagged{std::move(*name), *weight};
+  }
+};
+
+// stores ints as their decimal text, to check that explicit codecs win
+struct TextCodec {
+  static auto encode(int value, std::string &out) -> void {
+    JAVA::Codec<std::string>::encode(std::to_string(value), out);
+  }
+
+  static auto decode(std::string_view &in) -> std::optional<int> {
+    std::optional<std::string> text = JAVA::Codec<std::string>::decode(in);
+    if (!text.has_value()) {
+      return std::nullopt;
+    }
+    return std::stoi(*text);
+  }
+};
+
+template <typename T, typename = void>
+struct has_codec : std::false_type {};
+
+template <typename T>
+struct has_codec<T, std::void_t<decltype(JAVA::Codec<T>::encode)>>
+    : std::true_type {};
+
+// pointers would be sent as addresses of the writing process
+static_assert(has_codec<double>::value);
+static_assert(!has_codec<const char *>::value);
+static_assert(!has_codec<int Tagged::*>::value);
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(SerializationTestStream, AssertionTrue) {
+  JAVA::HashMap<int, std::int64_t> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = -50000; i < 50000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    h.Put(i, static_cast<std::int64_t>(i) * 1000000007);
+  }
+  std::stringstream stream;
+  h.Serialize(stream);
+
+  JAVA::HashMap<int, std::int64_t> copy;
+  copy.Put(0, std::int64_t{-1});
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  copy.Put(1 << 20, std::int64_t{7});
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(copy.Deserialize(stream), 100000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(copy.size(), 100001);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = -50000; i < 50000; i++) {
+    ASSERT_EQ(copy.Get(i), h.Get(i));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(copy.Get(1 << 20), std::make_optional(std::int64_t{7}));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(SerializationTestBuffer, AssertionTrue) {
+  JAVA::HashMap<std::string, Tagged> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h.Put(std::to_string(i),
+          Tagged{std::string(static_cast<std::size_t>(i), 'x'), -i});
+  }
+  std::string buffer;
+  h.Serialize(buffer);
+
+  JAVA::HashMap<std::string, Tagged> copy;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(copy.Deserialize(buffer), 1000);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(copy.Get(std::to_string(i)), h.Get(std::to_string(i)));
+  }
+
+  JAVA::HashMap<int, int> empty;
+  std::string emptyBuffer;
+  empty.Serialize(emptyBuffer);
+  ASSERT_EQ(empty.Deserialize(emptyBuffer), 0);
+  ASSERT_TRUE(empty.empty());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(SerializationTestCodec, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Put(12345, -6789);
+  std::string text;
+  h.Serialize<TextCodec, TextCodec>(text);
+  ASSERT_NE(text.find("12345"), std::string::npos);
+  ASSERT_NE(text.find("-6789"), std::string::npos);
+
+  JAVA::HashMap<int, int> copy;
+  ASSERT_EQ((copy.Deserialize<TextCodec, TextCodec>(text)), 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(copy.Get(12345), std::make_optional(-6789));
+
+  // varints are shorter than the raw bytes for small values
+  std::string varints;
+  h.Serialize(varints);
+  std::string raw;
+  JAVA::HashMap<int, double> doubles;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  doubles.Put(12345, 0.5);
+  doubles.Serialize(raw);
+  ASSERT_LT(varints.size(), raw.size());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(SerializationTestLargeEntries, AssertionTrue) {
+  // entries larger than a frame are sent in frames of their own
+  JAVA::HashMap<int, std::string> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    std::size_t length = i % 100 == 0 ? std::size_t{1} << 20 : 100;
+    h.Put(i, std::string(length, static_cast<char>('a' + i % 26)));
+  }
+  std::string buffer;
+  h.Serialize(buffer);
+
+  JAVA::HashMap<int, std::string> copy;
+  std::string_view in(buffer);
+  copy.Deserialize(in);
+  ASSERT_EQ(copy.size(), h.size());
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(copy.Get(i), h.Get(i));
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(SerializationTestMalformed, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    h.Put(i, i);
+  }
+  std::string buffer;
+  h.Serialize(buffer);
+
+  // a stream cut short keeps the frames that did arrive
+  JAVA::HashMap<int, int> partial;
+  std::string_view half = std::string_view(buffer).substr(0, buffer.size() / 2);
+  ASSERT_THROW(partial.Deserialize(half), std::runtime_error);
+  ASSERT_GT(partial.size(), 0);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_LT(partial.size(), 100000);
+
+  JAVA::HashMap<int, int> other;
+  ASSERT_THROW(other.Deserialize(std::string_view("JHMX\x01\x00\x00", 7)),
+               std::runtime_error);
+  ASSERT_THROW(other.Deserialize(std::string_view("JHMS\x01\x01\x05\x01", 8)),
+               std::runtime_error);
+  ASSERT_THROW(other.Deserialize(std::string_view()), std::runtime_error);
+  // a tenth varint byte only holds bit 63
+  std::string_view maxVarint(
+      "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01", 10);
+  ASSERT_EQ(JAVA::serialization::getVarint(maxVarint),
+            std::make_optional(UINT64_MAX));
+  std::string_view wideVarint(
+      "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x02", 10);
+  ASSERT_EQ(JAVA::serialization::getVarint(wideVarint), std::nullopt);
+  // frames of several entries past MAX_FRAME_BYTES, and a single entry frame
+  // longer than the stream
+  ASSERT_THROW(other.Deserialize(
+                   std::string_view("JHMS\x01\x02\x80\x80\x80\x04", 10)),
+               std::runtime_error);
+  ASSERT_THROW(other.Deserialize(
+                   std::string_view("JHMS\x01\x01\x80\x80\x80\x04", 10)),
+               std::runtime_error);
+
+  // values that do not fit the key type are rejected
+  JAVA::HashMap<std::int64_t, int> wide;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  wide.Put(std::int64_t{1} << 40, 1);
+  std::string wideBuffer;
+  wide.Serialize(wideBuffer);
+  ASSERT_THROW(other.Deserialize(wideBuffer), std::runtime_error);
+  ASSERT_TRUE(other.empty());
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
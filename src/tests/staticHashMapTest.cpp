@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "../include/StaticHashMap.hpp"
+
+namespace {
+
+enum class Side : std::uint8_t { BUY, SELL };
+
+constexpr JAVA::StaticHashMap<std::string_view, int, 4> COLORS{
+    {"red", 1}, {"green", 2}, {"blue", 3}};
+
+// lookups of literal keys are constant expressions
+static_assert(COLORS.size() == 3);
+static_assert(COLORS.Get("green") == 2);
+static_assert(COLORS.Contain("blue"));
+static_assert(!COLORS.Contain("black"));
+static_assert(COLORS.GetOr("black", -1) == -1);
+
+constexpr auto buildSides() -> JAVA::StaticHashMap<Side, char, 2> {
+  JAVA::StaticHashMap<Side, char, 2> sides;
+  sides.TryPut(Side::BUY, 'B');
+  sides.TryPut(Side::SELL, 'S');
+  sides.Del(Side::BUY);
+  sides.TryPut(Side::BUY, 'b');
+  return sides;
+}
+
+static_assert(buildSides().Get(Side::BUY) == 'b');
+static_assert(buildSides().full());
+
+}  // namespace
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(StaticHashMapTestConstexpr, AssertionTrue) {
+  ASSERT_EQ(COLORS.Get("red"), 1);
+  ASSERT_EQ(COLORS.Get("black"), std::nullopt);
+  int sum = 0;
+  COLORS.ForEach([&sum](std::string_view /*unused*/, int value) {
+    sum += value;
+  });
+  ASSERT_EQ(sum, 6);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(StaticHashMapTestTryPut, AssertionTrue) {
+  constexpr std::size_t CAPACITY = 100;
+  JAVA::StaticHashMap<std::uint64_t, std::uint64_t, CAPACITY> h;
+  ASSERT_TRUE(h.empty());
+  ASSERT_EQ(h.capacity(), CAPACITY);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.bucketCount(), 128);
+
+  for (std::uint64_t i = 0; i < CAPACITY; i++) {
+    ASSERT_TRUE(h.TryPut(i, i * 2));
+  }
+  ASSERT_TRUE(h.full());
+
+  // full: new keys are refused, existing ones are still assigned
+  ASSERT_FALSE(h.TryPut(CAPACITY, 0));
+  ASSERT_FALSE(h.Contain(CAPACITY));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_TRUE(h.TryPut(7, 70));
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(h.Get(7), 70);
+  ASSERT_EQ(h.size(), CAPACITY);
+
+  // a removed entry makes room for one more
+  ASSERT_TRUE(h.Del(0));
+  ASSERT_FALSE(h.Del(0));
+  ASSERT_FALSE(h.full());
+  ASSERT_TRUE(h.TryPut(CAPACITY, 1));
+  ASSERT_FALSE(h.TryPut(CAPACITY + 1, 1));
+  for (std::uint64_t i = 1; i < CAPACITY; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(i), i == 7 ? 70 : i * 2);
+  }
+
+  std::uint64_t *value = h.Find(CAPACITY);
+  ASSERT_NE(value, nullptr);
+  *value = 3;
+  ASSERT_EQ(h.Get(CAPACITY), 3);
+
+  h.Clear();
+  ASSERT_TRUE(h.empty());
+  ASSERT_FALSE(h.Contain(1));
+  ASSERT_TRUE(h.TryPut(1, 1));
+}
+
+using Book = JAVA::StaticHashMap<std::uint32_t, std::uint32_t, 1000>;
+
+// nothing to free, so nothing can have been allocated
+static_assert(std::is_trivially_destructible_v<Book>);
+static_assert(std::is_trivially_copyable_v<Book>);
+static_assert(sizeof(Book) >= Book::capacity() * 2 * sizeof(std::uint32_t));
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(StaticHashMapTestChurn, AssertionTrue) {
+  Book h;
+  // every node is reused many times over
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (std::uint32_t round = 0; round < 10; round++) {
+    for (std::uint32_t i = 0; i < Book::capacity(); i++) {
+      ASSERT_TRUE(h.TryPut(round * Book::capacity() + i, i));
+    }
+    ASSERT_TRUE(h.full());
+    for (std::uint32_t i = 0; i < Book::capacity(); i++) {
+      ASSERT_TRUE(h.Del(round * Book::capacity() + i));
+    }
+    ASSERT_TRUE(h.empty());
+  }
+
+  // the map is plain data that can be copied as it is
+  h.TryPut(1, 2);
+  Book copy = h;
+  ASSERT_EQ(copy.Get(1), 2);
+  copy.Del(1);
+  ASSERT_EQ(h.Get(1), 2);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+
+#include "../include/HashMap.hpp"
+
+// every key hashes to the same bucket
+struct SameHash {
+  auto operator()(int /*unused*/) const noexcept -> std::size_t { return 0; }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(StatsTestEmpty, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  JAVA::HashMapStats stats = h.Stats();
+  ASSERT_EQ(stats.size, 0);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(stats.bucketCount, 16);
+  ASSERT_EQ(stats.load, 0);
+  ASSERT_EQ(stats.maxChain, 0);
+  ASSERT_EQ(stats.chainLengths.size(), 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(stats.chainLengths[0], 16);
+  ASSERT_EQ(stats.slabs, 0);
+  ASSERT_EQ(stats.bytesLive, 0);
+  ASSERT_EQ(stats.bytesReserved, h.MemoryUsage());
+  ASSERT_EQ(stats.resizes, 0);
+  ASSERT_EQ(stats.resizeTime.count(), 0);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(StatsTestShape, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  constexpr int ENTRIES = 10000;
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Put(i, i);
+  }
+  JAVA::HashMapStats stats = h.Stats();
+  ASSERT_EQ(stats.size, ENTRIES);
+  ASSERT_EQ(stats.bucketCount, h.bucketCount());
+  ASSERT_DOUBLE_EQ(stats.load, static_cast<double>(ENTRIES) /
+                                   static_cast<double>(h.bucketCount()));
+  ASSERT_EQ(stats.chainLengths.size(), stats.maxChain + 1);
+  ASSERT_GT(stats.chainLengths[stats.maxChain], 0);
+
+  // the histogram covers every bucket and every entry
+  ASSERT_EQ(std::accumulate(stats.chainLengths.begin(),
+                            stats.chainLengths.end(), std::size_t{0}),
+            stats.bucketCount);
+  std::size_t entries = 0;
+  for (std::size_t n = 0; n < stats.chainLengths.size(); n++) {
+    entries += n * stats.chainLengths[n];
+  }
+  ASSERT_EQ(entries, ENTRIES);
+
+  ASSERT_GT(stats.slabs, 0);
+  ASSERT_GT(stats.bytesLive, 0);
+  ASSERT_LT(stats.bytesLive, stats.bytesReserved);
+  ASSERT_EQ(stats.treeBins, 0);
+
+  // 16 -> 16384 buckets, resizes are only counted with HASHMAP_STATS
+#if HASHMAP_STATS
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(stats.resizes, 10);
+  ASSERT_GT(stats.resizeTime.count(), 0);
+#else
+  ASSERT_EQ(stats.resizes, 0);
+  ASSERT_EQ(stats.resizeTime.count(), 0);
+#endif
+
+  // removed entries leave free cells behind
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < ENTRIES; i += 2) {
+    h.Del(i);
+  }
+  JAVA::HashMapStats after = h.Stats();
+  ASSERT_EQ(after.freeCells, stats.freeCells + ENTRIES / 2);
+  ASSERT_LT(after.bytesLive, stats.bytesLive);
+
+  h.ShrinkToFit();
+  ASSERT_EQ(h.Stats().resizes, stats.resizes + (HASHMAP_STATS ? 1 : 0));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(StatsTestTreeBins, AssertionTrue) {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  JAVA::HashMap<int, int, SameHash> h(64);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100; i++) {
+    h.Put(i, i);
+  }
+  JAVA::HashMapStats stats = h.Stats();
+  ASSERT_EQ(stats.treeBins, 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(stats.maxChain, 100);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(stats.chainLengths[100], 1);
+  ASSERT_EQ(stats.chainLengths[0], h.bucketCount() - 1);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(StatsTestIncremental, AssertionTrue) {
+  JAVA::IncrementalHashMap<int, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 1000; i++) {
+    h.Put(i, i);
+  }
+  JAVA::HashMapStats stats = h.Stats();
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(stats.size, 1000);
+  std::size_t entries = 0;
+  for (std::size_t n = 0; n < stats.chainLengths.size(); n++) {
+    entries += n * stats.chainLengths[n];
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(entries, 1000);
+#if HASHMAP_STATS
+  ASSERT_GT(stats.resizes, 0);
+#else
+  ASSERT_EQ(stats.resizes, 0);
+#endif
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "../include/HashMap.hpp"
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TaggedBucketTestBasicType, AssertionTrue) {
+  JAVA::TaggedHashMap<int, int> h1;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    h1.Put(i, i + 1);
+    ASSERT_EQ(h1.size(), i + 1);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 200000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 100000) {
+      ASSERT_EQ(h1.Get(i), std::make_optional(i + 1));
+    } else {
+      ASSERT_FALSE(h1.Contain(i));
+      ASSERT_FALSE(h1.Del(i));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(h1.Del(i));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(h1.Contain(i), i % 2 == 1);
+  }
+  ASSERT_EQ(h1.size(), 50000);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(TaggedBucketTestString, AssertionTrue) {
+  JAVA::TaggedHashMap<std::string, int> h3;
+  h3.Put(std::string("Hello world"), 1);
+  h3.Put(std::string("Hello world"), 2);
+  h3.Put(std::string("Hello world1"), 3);
+
+  ASSERT_EQ(h3.Get(std::string("Hello world")), std::make_optional(2));
+  ASSERT_EQ(h3.Get(std::string("Hello world1")), std::make_optional(3));
+  ASSERT_EQ(h3.Get(std::string("Hello world2")), std::nullopt);
+  ASSERT_TRUE(h3.Del(std::string("Hello world")));
+  ASSERT_EQ(h3.Get(std::string("Hello world")), std::nullopt);
+  ASSERT_EQ(h3.Get(std::string("Hello world1")), std::make_optional(3));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TaggedBucketTestChains, AssertionTrue) {
+  // keys sharing their low bits build chains, removing from the middle of a
+  // chain must keep the tags of the following nodes aligned
+  JAVA::TaggedHashMap<long long, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 5000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    h.Put(i << 24, static_cast<int>(i));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 5000; i += 3) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_TRUE(h.Del(i << 24));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 5000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(i << 24), i % 3 == 0 ? std::nullopt
+                                         : std::make_optional(static_cast<int>(i)));
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_FALSE(h.Contain((i << 24) + 1));
+  }
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#undef HASHMAP_TRACE
+#define HASHMAP_TRACE 1
+#include "../include/HashMap.hpp"
+
+// every key hashes to the same bucket
+struct SameHash {
+  auto operator()(int /*unused*/) const noexcept -> std::size_t { return 0; }
+};
+
+struct Event {
+  JAVA::MapOp op;
+
+  std::size_t probes;
+};
+
+struct RecordingObserver : JAVA::HashMapObserver {
+  std::vector<Event> operations;
+
+  std::vector<std::pair<std::size_t, std::size_t>> resizes;
+
+  std::size_t slabBytes = 0;
+
+  auto OnOperation(JAVA::MapOp op, std::size_t probes,
+                   std::chrono::nanoseconds latency) -> void override {
+    EXPECT_GE(latency.count(), 0);
+    operations.push_back(Event{op, probes});
+  }
+
+  auto OnResize(std::size_t oldCapacity, std::size_t newCapacity,
+                std::chrono::nanoseconds /*duration*/) -> void override {
+    resizes.emplace_back(oldCapacity, newCapacity);
+  }
+
+  auto OnSlabAllocate(std::size_t bytes) -> void override {
+    slabBytes += bytes;
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TraceTestHistogram, AssertionTrue) {
+  JAVA::LatencyHistogram histogram;
+  ASSERT_EQ(histogram.Count(), 0);
+  ASSERT_EQ(histogram.Percentile(50), 0);
+
+  constexpr std::uint64_t VALUES = 100000;
+  for (std::uint64_t v = 1; v <= VALUES; v++) {
+    histogram.Record(v);
+  }
+  ASSERT_EQ(histogram.Count(), VALUES);
+  ASSERT_EQ(histogram.Min(), 1);
+  ASSERT_EQ(histogram.Max(), VALUES);
+  ASSERT_DOUBLE_EQ(histogram.Mean(), (VALUES + 1) / 2.0);
+
+  // every percentile is within the precision of its bucket
+  for (double p : {1.0, 10.0, 50.0, 90.0, 99.0, 99.9}) {
+    auto exact = static_cast<double>(VALUES) * p / 100;
+    auto value = static_cast<double>(histogram.Percentile(p));
+    ASSERT_GE(value, exact * (1 - 1.0 / JAVA::LatencyHistogram::SUB_BUCKETS));
+    ASSERT_LE(value, exact * (1 + 2.0 / JAVA::LatencyHistogram::SUB_BUCKETS));
+  }
+  ASSERT_EQ(histogram.Percentile(0), 1);
+  ASSERT_EQ(histogram.Percentile(100), VALUES);
+
+  // small values are exact
+  JAVA::LatencyHistogram small;
+  small.Record(3);
+  small.Record(7);
+  ASSERT_EQ(small.Percentile(50), 3);
+  ASSERT_EQ(small.Percentile(100), 7);
+
+  // a percentile is reached by the value at its rank rounded up
+  JAVA::LatencyHistogram three;
+  three.Record(1);
+  three.Record(2);
+  three.Record(3);
+  ASSERT_EQ(three.Percentile(0), 1);
+  ASSERT_EQ(three.Percentile(33), 1);
+  ASSERT_EQ(three.Percentile(50), 2);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(three.Percentile(66), 2);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(three.Percentile(99), 3);
+
+  histogram.Merge(small);
+  ASSERT_EQ(histogram.Count(), VALUES + 2);
+  histogram.Reset();
+  ASSERT_EQ(histogram.Count(), 0);
+  ASSERT_EQ(histogram.Max(), 0);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TraceTestProbes, AssertionTrue) {
+  JAVA::HashMap<int, int, SameHash> h;
+  RecordingObserver observer;
+  h.SetObserver(&observer);
+
+  // a chain short of being treeified
+  constexpr int ENTRIES = 5;
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Put(i, i);
+  }
+  ASSERT_EQ(observer.operations.size(), ENTRIES);
+  for (int i = 0; i < ENTRIES; i++) {
+    ASSERT_EQ(observer.operations[i].op, JAVA::MapOp::PUT);
+    // compared with every key before it
+    ASSERT_EQ(observer.operations[i].probes, i);
+  }
+
+  observer.operations.clear();
+  ASSERT_EQ(h.Get(0), 0);
+  ASSERT_EQ(h.Get(ENTRIES - 1), ENTRIES - 1);
+  ASSERT_FALSE(h.Contain(ENTRIES));
+  ASSERT_EQ(observer.operations.size(), 3);
+  ASSERT_EQ(observer.operations[0].op, JAVA::MapOp::GET);
+  ASSERT_EQ(observer.operations[0].probes, 1);
+  ASSERT_EQ(observer.operations[1].probes, ENTRIES);
+  ASSERT_EQ(observer.operations[2].probes, ENTRIES);
+
+  observer.operations.clear();
+  ASSERT_TRUE(h.Del(2));
+  ASSERT_EQ(observer.operations.size(), 1);
+  ASSERT_EQ(observer.operations[0].op, JAVA::MapOp::DEL);
+  ASSERT_EQ(observer.operations[0].probes, 3);
+
+  // nothing is reported once the observer is removed
+  h.SetObserver(nullptr);
+  h.Put(ENTRIES, ENTRIES);
+  ASSERT_EQ(h.Get(ENTRIES), ENTRIES);
+  ASSERT_EQ(observer.operations.size(), 1);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(TraceTestTreeProbes, AssertionTrue) {
+  JAVA::HashMap<int, int, SameHash> h;
+  constexpr int ENTRIES = 1000;
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Put(i, i);
+  }
+  JAVA::HistogramObserver observer;
+  h.SetObserver(&observer);
+  for (int i = 0; i < ENTRIES; i++) {
+    ASSERT_EQ(h.Get(i), i);
+  }
+  // a tree bin keeps lookups logarithmic
+  ASSERT_EQ(observer.get.probes.Count(), ENTRIES);
+  ASSERT_GE(observer.get.probes.Min(), 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_LE(observer.get.probes.Max(), 20);
+  ASSERT_EQ(observer.get.latency.Count(), ENTRIES);
+  ASSERT_EQ(observer.put.latency.Count(), 0);
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(TraceTestResizeAndSlabs, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  RecordingObserver observer;
+  h.SetObserver(&observer);
+
+  // the default table of 16 buckets resizes past 12 entries
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 13; i++) {
+    h.Put(i, i);
+  }
+  ASSERT_EQ(observer.resizes.size(), 1);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(observer.resizes[0].first, 16);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(observer.resizes[0].second, 32);
+  ASSERT_GT(observer.slabBytes, 0);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  h.Rehash(256);
+  ASSERT_EQ(observer.resizes.size(), 2);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  ASSERT_EQ(observer.resizes[1].first, 32);
+  ASSERT_EQ(observer.resizes[1].second, h.bucketCount());
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(TraceTestHistogramObserver, AssertionTrue) {
+  JAVA::HashMap<int, int> h;
+  JAVA::HistogramObserver observer;
+  h.SetObserver(&observer);
+  constexpr int ENTRIES = 10000;
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Put(i, i);
+  }
+  for (int i = 0; i < ENTRIES; i++) {
+    h.Del(i);
+  }
+  ASSERT_EQ(observer.put.latency.Count(), ENTRIES);
+  ASSERT_EQ(observer.del.latency.Count(), ENTRIES);
+  ASSERT_LE(observer.put.latency.Percentile(50),
+            observer.put.latency.Percentile(99));
+  ASSERT_GT(observer.resizes.Count(), 0);
+  ASSERT_EQ(observer.lastCapacity, h.bucketCount());
+  ASSERT_GT(observer.slabs, 0);
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}
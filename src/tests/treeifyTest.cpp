@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <cctype>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "../include/HashMap.hpp"
+
+// every key lands in the same bucket and operator< is available
+struct CollidingKey {
+  int id;
+
+  auto operator==(const CollidingKey &other) const noexcept -> bool {
+    return id == other.id;
+  }
+
+  auto operator<(const CollidingKey &other) const noexcept -> bool {
+    return id < other.id;
+  }
+};
+
+// every key lands in the same bucket and there is no ordering at all
+struct IncomparableKey {
+  std::string id;
+
+  auto operator==(const IncomparableKey &other) const noexcept -> bool {
+    return id == other.id;
+  }
+};
+
+template <>
+struct std::hash<CollidingKey> {
+  auto operator()(const CollidingKey & /*unused*/) const -> std::size_t {
+    return 0;
+  }
+};
+
+template <>
+struct std::hash<IncomparableKey> {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  auto operator()(const IncomparableKey &key) const -> std::size_t {
+    // two hash codes only, so tree bins contain long runs of equal hashes
+    return key.id.size() % 2;
+  }
+};
+
+// sends every string to the same bucket
+struct ZeroHash {
+  auto operator()(const std::string & /*unused*/) const noexcept
+      -> std::size_t {
+    return 0;
+  }
+};
+
+// equality that operator< of std::string disagrees with
+struct CaseInsensitiveEq {
+  auto operator()(const std::string &a, const std::string &b) const noexcept
+      -> bool {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.size(); i++) {
+      if (std::tolower(static_cast<unsigned char>(a[i])) !=
+          std::tolower(static_cast<unsigned char>(b[i]))) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TreeifyTestComparableKey, AssertionTrue) {
+  JAVA::HashMap<CollidingKey, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    h.Put(CollidingKey{i}, i + 1);
+    ASSERT_EQ(h.size(), i + 1);
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 20000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    if (i < 10000) {
+      ASSERT_EQ(h.Get(CollidingKey{i}), std::make_optional(i + 1));
+    } else {
+      ASSERT_FALSE(h.Contain(CollidingKey{i}));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i += 2) {
+    h.Put(CollidingKey{i}, -i);
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(h.Get(CollidingKey{i}), std::make_optional(i % 2 == 0 ? -i : i + 1));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    if (i % 3 == 0) {
+      ASSERT_TRUE(h.Del(CollidingKey{i}));
+      ASSERT_FALSE(h.Del(CollidingKey{i}));
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(h.Contain(CollidingKey{i}), i % 3 != 0);
+  }
+
+  // shrinking the bin below the untreeify threshold keeps it usable
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 10000; i++) {
+    h.Del(CollidingKey{i});
+  }
+  ASSERT_TRUE(h.empty());
+  h.Put(CollidingKey{1}, 1);
+  ASSERT_EQ(h.Get(CollidingKey{1}), std::make_optional(1));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TreeifyTestIncomparableKey, AssertionTrue) {
+  JAVA::HashMap<IncomparableKey, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 3000; i++) {
+    h.Put(IncomparableKey{std::to_string(i)}, i);
+  }
+  ASSERT_EQ(h.size(), 3000);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 3000; i++) {
+    ASSERT_EQ(h.Get(IncomparableKey{std::to_string(i)}), std::make_optional(i));
+  }
+  ASSERT_FALSE(h.Contain(IncomparableKey{"-1"}));
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 3000; i += 2) {
+    ASSERT_TRUE(h.Del(IncomparableKey{std::to_string(i)}));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 0; i < 3000; i++) {
+    ASSERT_EQ(h.Contain(IncomparableKey{std::to_string(i)}), i % 2 == 1);
+  }
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type)
+TEST(TreeifyTestResizeSplit, AssertionTrue) {
+  // a hash with few distinct low bits so tree bins survive several resizes
+  JAVA::HashMap<long long, int> h;
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 50000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    h.Put(i << 20, static_cast<int>(i));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (long long i = 0; i < 50000; i++) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    ASSERT_EQ(h.Get(i << 20), std::make_optional(static_cast<int>(i)));
+  }
+  ASSERT_FALSE(h.Contain(1));
+}
+
+// NOLINTNEXTLINE(modernize-use-trailing-return-type,readability-function-cognitive-complexity)
+TEST(TreeifyTestCustomKeyEqual, AssertionTrue) {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  JAVA::HashMap<std::string, int, ZeroHash, CaseInsensitiveEq> h(64);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 100; i < 140; i++) {
+    h.Put("k" + std::to_string(i), i);
+  }
+  ASSERT_EQ(h.size(), 40);
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 100; i < 140; i++) {
+    ASSERT_EQ(h.Get("K" + std::to_string(i)), std::make_optional(i));
+  }
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 100; i < 140; i++) {
+    h.Put("K" + std::to_string(i), -i);
+  }
+  ASSERT_EQ(h.size(), 40);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 100; i < 140; i++) {
+    ASSERT_EQ(h.Get("k" + std::to_string(i)), std::make_optional(-i));
+  }
+
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 100; i < 140; i += 2) {
+    ASSERT_TRUE(h.Del("K" + std::to_string(i)));
+  }
+  ASSERT_EQ(h.size(), 20);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (int i = 100; i < 140; i++) {
+    ASSERT_EQ(h.Contain("k" + std::to_string(i)), i % 2 == 1);
+  }
+}
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_output = "stdout:";
+  return RUN_ALL_TESTS();
+}